@@ -0,0 +1,154 @@
+#include "pipeline/batch_reader.hpp"
+#include "pipeline/mapped_file.hpp"
+
+#include <benchmark/benchmark.h>
+
+#ifdef HAVE_OPENCV_CORE
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#endif
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kFiles = 256;
+
+/**
+ * @brief Files read by the benchmarks, written once per run and removed at exit.
+ *
+ * With OpenCV they are 640x480 JPEGs, so cv::imread has real work to do; without it, random
+ * bytes of a similar size. They go to $PIXLINK_BENCH_DIR, or the temporary directory. The
+ * cold runs need a disk-backed directory: on tmpfs the page cache is the storage.
+ */
+class Corpus {
+public:
+    static const Corpus& get() {
+        static Corpus corpus;
+        return corpus;
+    }
+
+    ~Corpus() {
+        std::error_code ec;
+        std::filesystem::remove_all(dir_, ec);
+    }
+
+    const std::vector<std::string>& paths() const { return paths_; }
+    size_t bytes() const { return bytes_; }
+
+    /**
+     * @brief Drop the files from the page cache, so the next read goes to the device.
+     */
+    void evict() const {
+        for (const auto& path : paths_) {
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) continue;
+            ::fdatasync(fd); // Dirty pages are not dropped
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+    }
+
+private:
+    Corpus() {
+        const char* base = std::getenv("PIXLINK_BENCH_DIR");
+        dir_ = std::filesystem::path(base ? base : std::filesystem::temp_directory_path().string()) /
+               ("pixlink-bench-" + std::to_string(::getpid()));
+        std::filesystem::create_directories(dir_);
+        std::mt19937 rng(42); // Only for the non-OpenCV corpus
+        for (size_t i = 0; i < kFiles; ++i) {
+            std::string path = (dir_ / ("img" + std::to_string(i) + ".jpg")).string();
+#ifdef HAVE_OPENCV_CORE
+            cv::Mat image(480, 640, CV_8UC3);
+            cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(256));
+            cv::imwrite(path, image);
+#else
+            std::vector<char> bytes(200 * 1024);
+            for (auto& b : bytes) b = static_cast<char>(rng());
+            std::ofstream(path, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+#endif
+            bytes_ += std::filesystem::file_size(path);
+            paths_.push_back(std::move(path));
+        }
+    }
+
+    std::filesystem::path dir_;
+    std::vector<std::string> paths_;
+    size_t bytes_ = 0;
+};
+
+// Runs one pass over the corpus per iteration, evicting it first (untimed) when cold.
+template <typename Pass>
+void run(benchmark::State& state, bool cold, Pass&& pass) {
+    const Corpus& corpus = Corpus::get();
+    for (auto _ : state) {
+        if (cold) {
+            state.PauseTiming();
+            corpus.evict();
+            state.ResumeTiming();
+        }
+        pass(corpus.paths());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * corpus.paths().size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * corpus.bytes()));
+}
+
+// Args: queue depth, cold (1) or warm (0) page cache
+void BM_BatchFileReader(benchmark::State& state) {
+    pipeline::BatchFileReader reader(static_cast<unsigned>(state.range(0)), true);
+    state.SetLabel(reader.usingIoUring() ? "io_uring" : "plain reads");
+    run(state, state.range(1) != 0, [&](const std::vector<std::string>& paths) {
+        benchmark::DoNotOptimize(reader.read(paths));
+    });
+}
+BENCHMARK(BM_BatchFileReader)
+    ->ArgsProduct({{1, 16, 64, 256}, {1, 0}})
+    ->ArgNames({"depth", "cold"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// The same result as BatchFileReader::read (every buffer alive at the end), one file at a
+// time. Arg: cold (1) or warm (0) page cache
+void BM_PlainReads(benchmark::State& state) {
+    run(state, state.range(0) != 0, [](const std::vector<std::string>& paths) {
+        std::vector<std::vector<unsigned char>> buffers;
+        buffers.reserve(paths.size());
+        for (const auto& path : paths) buffers.push_back(pipeline::readFileBytes(path));
+        benchmark::DoNotOptimize(buffers);
+    });
+}
+BENCHMARK(BM_PlainReads)->Arg(1)->Arg(0)->ArgName("cold")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+#ifdef HAVE_OPENCV_CORE
+
+// cv::imread per file against a batched read then cv::imdecode: the same decoding, so the
+// difference is the I/O. Arg: cold (1) or warm (0) page cache
+void BM_Imread(benchmark::State& state) {
+    run(state, state.range(0) != 0, [](const std::vector<std::string>& paths) {
+        for (const auto& path : paths) benchmark::DoNotOptimize(cv::imread(path, cv::IMREAD_COLOR));
+    });
+}
+BENCHMARK(BM_Imread)->Arg(1)->Arg(0)->ArgName("cold")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_BatchFileReaderDecode(benchmark::State& state) {
+    pipeline::BatchFileReader reader(64, true);
+    state.SetLabel(reader.usingIoUring() ? "io_uring" : "plain reads");
+    run(state, state.range(0) != 0, [&](const std::vector<std::string>& paths) {
+        for (auto& buffer : reader.read(paths))
+            benchmark::DoNotOptimize(cv::imdecode(buffer.bytes, cv::IMREAD_COLOR));
+    });
+}
+BENCHMARK(BM_BatchFileReaderDecode)->Arg(1)->Arg(0)->ArgName("cold")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+#endif
+
+} // namespace
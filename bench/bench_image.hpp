@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Image type for the cache benchmarks: pixels behind a shared pointer.
+ *
+ * Copies are shallow and clone() copies the pixels, as with cv::Mat.
+ */
+struct BenchImage {
+    std::shared_ptr<const std::vector<unsigned char>> pixels;
+
+    BenchImage clone() const {
+        return BenchImage{pixels ? std::make_shared<const std::vector<unsigned char>>(*pixels) : nullptr};
+    }
+};
+
+/**
+ * @brief Keys "img0" ... "img<n-1>", built once so lookups do not time string formatting.
+ */
+inline std::vector<std::string> benchKeys(size_t n) {
+    std::vector<std::string> keys;
+    keys.reserve(n);
+    for (size_t i = 0; i < n; ++i) keys.push_back("img" + std::to_string(i));
+    return keys;
+}
+
+/**
+ * @brief Indices into a key set of `universe` keys, Zipf-distributed with exponent s.
+ */
+inline std::vector<uint32_t> zipfSequence(size_t universe, size_t length, double s, uint64_t seed) {
+    std::vector<double> cdf(universe);
+    double sum = 0;
+    for (size_t i = 0; i < universe; ++i) cdf[i] = sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0, sum);
+    std::vector<uint32_t> sequence(length);
+    for (auto& index : sequence) {
+        size_t i = static_cast<size_t>(std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin());
+        index = static_cast<uint32_t>(std::min(i, universe - 1));
+    }
+    return sequence;
+}
@@ -0,0 +1,98 @@
+#include "bench_image.hpp"
+#include "pipeline/strategy.hpp"
+#include "pipeline/strategy_2q.hpp"
+#include "pipeline/strategy_arc.hpp"
+#include "pipeline/strategy_lru.hpp"
+#include "pipeline/strategy_tinylfu.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Cache = pipeline::CacheManager<BenchImage>;
+using CacheFactory = std::function<std::unique_ptr<Cache>(size_t)>;
+
+/**
+ * @brief The access trace replayed by every policy.
+ *
+ * Read from $PIXLINK_TRACE when set: one key per line, anything after a tab ignored, e.g. a
+ * PersistentCacheManager access.log or a log of Pipeline loads. Otherwise a synthetic trace of
+ * the mixed workload the scan-resistant policies target: a Zipf-distributed hot set of 2000
+ * images, interrupted every 50000 accesses by a one-pass scan of 10000 new images.
+ */
+const std::vector<std::string>& trace() {
+    static const std::vector<std::string> trace = [] {
+        std::vector<std::string> keys;
+        if (const char* path = std::getenv("PIXLINK_TRACE")) {
+            std::ifstream in(path);
+            if (!in) throw std::runtime_error(std::string("Failed to open trace: ") + path);
+            for (std::string line; std::getline(in, line);)
+                if (!line.empty()) keys.push_back(line.substr(0, line.find('\t')));
+            return keys;
+        }
+        const std::vector<std::string> hot = benchKeys(2000);
+        std::vector<uint32_t> hits = zipfSequence(hot.size(), 400000, 0.8, 1);
+        size_t scans = 0;
+        for (size_t i = 0; i < hits.size(); ++i) {
+            if (i % 50000 == 49999)
+                for (int j = 0; j < 10000; ++j) keys.push_back("scan" + std::to_string(scans++));
+            keys.push_back(hot[hits[i]]);
+        }
+        return keys;
+    }();
+    return trace;
+}
+
+// Cache-aside replay, as Pipeline uses its cache: a hit is served from the cache, a miss is
+// "decoded" and inserted. Arg: capacity in images. Reports the hit ratio.
+void BM_Replay(benchmark::State& state, const CacheFactory& make) {
+    const std::vector<std::string>& keys = trace();
+    const BenchImage image{std::make_shared<const std::vector<unsigned char>>(64)};
+    std::unique_ptr<Cache> cache;
+    size_t hits = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        cache = make(static_cast<size_t>(state.range(0)));
+        hits = 0;
+        state.ResumeTiming();
+        for (const auto& key : keys) {
+            if (cache->isCached(key)) {
+                benchmark::DoNotOptimize(cache->getCachedShallow(key));
+                ++hits;
+            } else {
+                cache->cacheImage(key, image);
+            }
+        }
+    }
+    state.SetLabel(std::getenv("PIXLINK_TRACE") ? "recorded trace" : "synthetic trace");
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * keys.size()));
+    state.counters["hit_ratio"] = static_cast<double>(hits) / static_cast<double>(keys.size());
+}
+
+std::unique_ptr<Cache> makeLRU(size_t capacity) {
+    return std::make_unique<pipeline::LRUCacheManager<BenchImage>>(capacity);
+}
+std::unique_ptr<Cache> make2Q(size_t capacity) {
+    return std::make_unique<pipeline::TwoQueueCacheManager<BenchImage>>(capacity);
+}
+std::unique_ptr<Cache> makeARC(size_t capacity) {
+    return std::make_unique<pipeline::ARCCacheManager<BenchImage>>(capacity);
+}
+std::unique_ptr<Cache> makeTinyLFU(size_t capacity) {
+    return std::make_unique<pipeline::TinyLFUCacheManager<BenchImage>>(capacity);
+}
+
+BENCHMARK_CAPTURE(BM_Replay, lru, makeLRU)->Arg(500)->Arg(1000)->Arg(2000)->ArgName("capacity")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Replay, 2q, make2Q)->Arg(500)->Arg(1000)->Arg(2000)->ArgName("capacity")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Replay, arc, makeARC)->Arg(500)->Arg(1000)->Arg(2000)->ArgName("capacity")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Replay, tinylfu, makeTinyLFU)->Arg(500)->Arg(1000)->Arg(2000)->ArgName("capacity")->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,55 @@
+#ifdef HAVE_OPENCV_CORE
+
+#include "pipeline/mat_pool.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <opencv2/core.hpp>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+constexpr int kInFlight = 8; ///< Images alive at once, as in a pipeline batch
+
+// Arg: resolution index
+constexpr std::array<std::array<int, 2>, 3> kSizes{{{480, 640}, {1080, 1920}, {3000, 4000}}};
+
+// One allocation per iteration replacing the oldest of kInFlight live images, like a
+// decode/process loop. Every page is written once, so page faults are part of the cost.
+void allocate(benchmark::State& state, cv::MatAllocator* allocator) {
+    auto [rows, cols] = kSizes[static_cast<size_t>(state.range(0))];
+    std::vector<cv::Mat> live(kInFlight);
+    size_t next = 0;
+    for (auto _ : state) {
+        cv::Mat image;
+        image.allocator = allocator;
+        image.create(rows, cols, CV_8UC3);
+        unsigned char* data = image.ptr();
+        for (size_t offset = 0; offset < image.total() * image.elemSize(); offset += 4096) data[offset] = 1;
+        benchmark::DoNotOptimize(data);
+        live[next] = image;
+        next = (next + 1) % live.size();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * rows * cols * 3);
+}
+
+void BM_MatDefaultAllocator(benchmark::State& state) {
+    allocate(state, nullptr);
+}
+BENCHMARK(BM_MatDefaultAllocator)->DenseRange(0, 2)->ArgName("size");
+
+void BM_MatPooledAllocator(benchmark::State& state) {
+    pipeline::PooledMatAllocator pool;
+    allocate(state, &pool);
+    pipeline::MatPoolStats stats = pool.stats();
+    state.counters["hit_ratio"] = stats.hits + stats.misses
+        ? static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses) : 0.0;
+}
+BENCHMARK(BM_MatPooledAllocator)->DenseRange(0, 2)->ArgName("size");
+
+} // namespace
+
+#endif // HAVE_OPENCV_CORE
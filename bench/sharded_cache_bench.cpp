@@ -0,0 +1,91 @@
+#include "bench_image.hpp"
+#include "pipeline/strategy_lru.hpp"
+#include "pipeline/strategy_sharded.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kUniverse = 16384; ///< Distinct keys
+constexpr size_t kCapacity = 4096;  ///< Cached images
+constexpr size_t kSequence = 1 << 16;
+
+/**
+ * @brief LRUCacheManager behind a single mutex: the baseline ShardedCacheManager replaces.
+ */
+class LockedLRU {
+public:
+    explicit LockedLRU(size_t capacity) : cache_(capacity) {}
+
+    bool isCached(const std::string& key) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cache_.isCached(key);
+    }
+    BenchImage getCachedShallow(const std::string& key) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cache_.getCachedShallow(key);
+    }
+    void cacheImage(const std::string& key, const BenchImage& image) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cache_.cacheImage(key, image);
+    }
+
+private:
+    mutable std::mutex mutex_;
+    pipeline::LRUCacheManager<BenchImage> cache_;
+};
+
+const std::vector<std::string>& keys() {
+    static const std::vector<std::string> keys = benchKeys(kUniverse);
+    return keys;
+}
+
+// Each thread replays its own Zipf sequence of pipeline lookups: isCached, then a shallow
+// get on a hit or an insert on a miss. Entries evicted between the two calls count as misses.
+template <typename Cache>
+void contend(benchmark::State& state, std::unique_ptr<Cache>& cache, const std::function<Cache*()>& make) {
+    if (state.thread_index() == 0) cache.reset(make());
+    std::vector<uint32_t> sequence = zipfSequence(kUniverse, kSequence, 0.99, static_cast<uint64_t>(state.thread_index()) + 1);
+    BenchImage image{std::make_shared<const std::vector<unsigned char>>(64)};
+    size_t next = 0;
+    for (auto _ : state) {
+        const std::string& key = keys()[sequence[next]];
+        next = (next + 1) % sequence.size();
+        bool hit = cache->isCached(key);
+        if (hit) {
+            try {
+                benchmark::DoNotOptimize(cache->getCachedShallow(key));
+            } catch (const std::runtime_error&) {
+                hit = false;
+            }
+        }
+        if (!hit) cache->cacheImage(key, image);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    if (state.thread_index() == 0) cache.reset();
+}
+
+void BM_LockedLRU(benchmark::State& state) {
+    static std::unique_ptr<LockedLRU> cache;
+    contend<LockedLRU>(state, cache, [] { return new LockedLRU(kCapacity); });
+}
+BENCHMARK(BM_LockedLRU)->ThreadRange(1, 64)->UseRealTime();
+
+// Arg: shard count
+void BM_ShardedCache(benchmark::State& state) {
+    static std::unique_ptr<pipeline::ShardedCacheManager<BenchImage>> cache;
+    size_t shards = static_cast<size_t>(state.range(0));
+    contend<pipeline::ShardedCacheManager<BenchImage>>(state, cache, [shards] {
+        return new pipeline::ShardedCacheManager<BenchImage>(kCapacity, shards);
+    });
+}
+BENCHMARK(BM_ShardedCache)->Arg(16)->Arg(64)->ArgName("shards")->ThreadRange(1, 64)->UseRealTime();
+
+} // namespace
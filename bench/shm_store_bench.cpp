@@ -0,0 +1,82 @@
+#include "bench_image.hpp"
+#include "pipeline/shm_store.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using pipeline::SharedImageStore;
+using pipeline::SharedMemoryCacheOptions;
+
+namespace {
+
+constexpr size_t kImages = 1024;
+
+std::unique_ptr<SharedImageStore> makeStore(size_t dataBytes) {
+    std::string name = "/pixlink-bench-" + std::to_string(::getpid());
+    SharedImageStore::unlink(name);
+    SharedMemoryCacheOptions options;
+    options.dataBytes = dataBytes;
+    options.maxEntries = 4 * kImages;
+    options.unlinkOnDestroy = true;
+    return std::make_unique<SharedImageStore>(name, options);
+}
+
+bool put(SharedImageStore& store, const std::string& key, size_t bytes) {
+    SharedImageStore::ImageInfo info{1, static_cast<int32_t>(bytes), 0, bytes};
+    return store.insert(key, info, [&](unsigned char* data) { std::memset(data, 1, bytes); });
+}
+
+// Lease and release of stored 16 KiB images, Zipf-distributed, from several threads. Every
+// acquire and release takes the segment's process-shared mutex.
+void BM_ShmAcquire(benchmark::State& state) {
+    static std::unique_ptr<SharedImageStore> store;
+    static std::vector<std::string> keys;
+    if (state.thread_index() == 0) {
+        store = makeStore(64 << 20);
+        keys = benchKeys(kImages);
+        for (const auto& key : keys) put(*store, key, 16 << 10);
+    }
+    std::vector<uint32_t> sequence = zipfSequence(kImages, 1 << 16, 0.99, static_cast<uint64_t>(state.thread_index()) + 1);
+    size_t next = 0;
+    for (auto _ : state) {
+        auto lease = store->acquire(keys[sequence[next]]);
+        next = (next + 1) % sequence.size();
+        if (!lease) continue;
+        benchmark::DoNotOptimize(lease->data[0]);
+        store->release(lease->entry);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    if (state.thread_index() == 0) store.reset();
+}
+BENCHMARK(BM_ShmAcquire)->ThreadRange(1, 8)->UseRealTime();
+
+// Inserts into a full 64 MiB store. Arg 0: 64 KiB images only. Arg 1: phases of 64 KiB and
+// 1 MiB images alternating every 2048 inserts, so space held by one size class must be
+// rebalanced to the other. Reports evictions and failed inserts per insert.
+void BM_ShmInsert(benchmark::State& state) {
+    std::unique_ptr<SharedImageStore> store = makeStore(64 << 20);
+    const std::vector<std::string> keys = benchKeys(4 * kImages);
+    bool shifting = state.range(0) != 0;
+    size_t inserts = 0;
+    size_t failed = 0;
+    size_t written = 0;
+    for (auto _ : state) {
+        size_t bytes = shifting && (inserts / 2048) % 2 ? (1 << 20) : (64 << 10);
+        if (!put(*store, keys[inserts % keys.size()], bytes)) ++failed;
+        ++inserts;
+        written += bytes;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(inserts));
+    state.SetBytesProcessed(static_cast<int64_t>(written));
+    state.counters["evictions"] = benchmark::Counter(static_cast<double>(store->evictions()), benchmark::Counter::kAvgIterations);
+    state.counters["failed"] = benchmark::Counter(static_cast<double>(failed), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ShmInsert)->Arg(0)->Arg(1)->ArgName("shifting")->UseRealTime();
+
+} // namespace
@@ -0,0 +1,348 @@
+#pragma once
+
+#include "pipeline/mapped_file.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define PIPELINE_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace pipeline {
+
+/**
+ * @brief Contents of one file read by BatchFileReader.
+ */
+struct FileBuffer {
+    std::string path;                ///< Path that was read.
+    std::vector<unsigned char> bytes; ///< File contents (empty on error).
+    std::string error;               ///< Empty on success, otherwise a description of the failure.
+
+    bool ok() const { return error.empty(); }
+};
+
+#ifdef PIPELINE_HAS_IO_URING
+
+namespace detail {
+
+/**
+ * @brief Minimal io_uring instance driven through raw syscalls (no liburing dependency).
+ *
+ * run() queues one SQE per item, submits them in rounds of at most the ring size,
+ * and returns each item's CQE result.
+ */
+class IoUring {
+public:
+    explicit IoUring(unsigned entries) {
+        if (entries == 0) return; // No ring wanted: stays invalid
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) return;
+        entries_ = params.sq_entries;
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+
+        sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if (sqRing_ == MAP_FAILED) { sqRing_ = nullptr; close(); return; }
+        if (single) {
+            cqRing_ = sqRing_;
+        } else {
+            cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+            if (cqRing_ == MAP_FAILED) { cqRing_ = nullptr; close(); return; }
+        }
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) { close(); return; }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        auto* sq = static_cast<char*>(sqRing_);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        auto* cq = static_cast<char*>(cqRing_);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    ~IoUring() { close(); }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool valid() const { return sqes_ != nullptr; }
+
+    /**
+     * @brief true if the kernel implements every given opcode.
+     *
+     * Asks with IORING_REGISTER_PROBE (Linux 5.6); older kernels, which lack the probe, also
+     * lack OPENAT and STATX, and are reported as supporting nothing.
+     */
+    bool supports(std::initializer_list<unsigned> opcodes) const {
+        if (!valid()) return false;
+        constexpr unsigned kOps = 256;
+        std::vector<unsigned char> buffer(sizeof(io_uring_probe) + kOps * sizeof(io_uring_probe_op), 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+        if (::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe, kOps) < 0) return false;
+        for (unsigned op : opcodes)
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+        return true;
+    }
+
+    /**
+     * @brief Prepare, submit and reap one operation per item.
+     *
+     * @param count Number of operations.
+     * @param prep Fills the zeroed SQE for item i.
+     * @return CQE result per item (negative errno on failure), or empty if the ring failed.
+     */
+    template <typename Prep>
+    std::vector<int> run(size_t count, Prep&& prep) {
+        std::vector<int> results(count, -EIO);
+        for (size_t begin = 0; begin < count; begin += entries_) {
+            size_t end = std::min(count, begin + entries_);
+            unsigned tail = *sqTail_;
+            for (size_t i = begin; i < end; ++i, ++tail) {
+                unsigned index = tail & sqMask_;
+                io_uring_sqe& sqe = sqes_[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                prep(sqe, i);
+                sqe.user_data = i;
+                sqArray_[index] = index;
+            }
+            std::atomic_ref<unsigned>(*sqTail_).store(tail, std::memory_order_release);
+
+            unsigned pending = static_cast<unsigned>(end - begin);
+            unsigned toSubmit = pending;
+            while (pending > 0) {
+                int ret = enter(toSubmit, 1, IORING_ENTER_GETEVENTS);
+                if (ret < 0) {
+                    if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+                    return {};
+                }
+                toSubmit -= std::min<unsigned>(toSubmit, static_cast<unsigned>(ret));
+                unsigned head = *cqHead_;
+                unsigned cqTail = std::atomic_ref<unsigned>(*cqTail_).load(std::memory_order_acquire);
+                for (; head != cqTail; ++head, --pending) {
+                    const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                    results[static_cast<size_t>(cqe.user_data)] = cqe.res;
+                }
+                std::atomic_ref<unsigned>(*cqHead_).store(head, std::memory_order_release);
+            }
+        }
+        return results;
+    }
+
+private:
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, fd_, toSubmit, minComplete, flags, nullptr, 0));
+    }
+
+    void close() {
+        if (sqes_) ::munmap(sqes_, sqesSize_);
+        if (cqRing_ && cqRing_ != sqRing_) ::munmap(cqRing_, cqRingSize_);
+        if (sqRing_) ::munmap(sqRing_, sqRingSize_);
+        if (fd_ >= 0) ::close(fd_);
+        sqes_ = nullptr;
+        cqRing_ = sqRing_ = nullptr;
+        fd_ = -1;
+    }
+
+    int fd_ = -1;
+    unsigned entries_ = 0;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    size_t sqesSize_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned* sqArray_ = nullptr;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+} // namespace detail
+
+#endif // PIPELINE_HAS_IO_URING
+
+/**
+ * @brief Reads many whole files with few syscalls.
+ *
+ * By default files are read one by one with plain reads. With io_uring enabled (Linux), files
+ * are processed in groups of queueDepth; each group is opened, sized, read and closed as four
+ * rounds of io_uring submissions (OPENAT, STATX, READ, CLOSE). Where io_uring or one of these
+ * operations is unavailable (kernels before 5.6, seccomp, other platforms), or if the ring
+ * fails, plain reads are used.
+ *
+ * io_uring only pays off when the files are not in the page cache. In bench/batch_reader_bench
+ * (256 files of 200 KB, all buffers kept), io_uring at depth 16-256 was 20-30% faster than plain
+ * reads on a cold page cache, but up to about 10% slower on a warm one: every buffer is zero-filled
+ * before any read lands, so each byte crosses the memory bus twice, where a plain read fills a
+ * buffer that is still in cache. Enable it for first passes over large trees on disk.
+ * Per-file errors are reported in FileBuffer::error rather than thrown.
+ */
+class BatchFileReader {
+public:
+    /**
+     * @brief Construct a reader.
+     *
+     * @param queueDepth io_uring submission queue size (operations in flight per round).
+     * @param useIoUring Read through io_uring where available instead of plain reads.
+     */
+    explicit BatchFileReader(unsigned queueDepth = 64, bool useIoUring = false)
+        : groupSize_(queueDepth > 0 ? queueDepth : 1)
+#ifdef PIPELINE_HAS_IO_URING
+        , ring_(useIoUring ? static_cast<unsigned>(groupSize_) : 0)
+        , ringReady_(useIoUring && ring_.supports({IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE}))
+#endif
+    {
+#ifndef PIPELINE_HAS_IO_URING
+        (void)useIoUring;
+#endif
+    }
+
+    /**
+     * @brief true if batches go through io_uring.
+     */
+    bool usingIoUring() const {
+#ifdef PIPELINE_HAS_IO_URING
+        return ringReady_;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Read a batch of files.
+     *
+     * @param paths Files to read.
+     * @return One FileBuffer per path, in the same order.
+     */
+    std::vector<FileBuffer> read(const std::vector<std::string>& paths) {
+        std::vector<FileBuffer> buffers(paths.size());
+        for (size_t i = 0; i < paths.size(); ++i) buffers[i].path = paths[i];
+#ifdef PIPELINE_HAS_IO_URING
+        bool ringOk = ringReady_;
+        for (size_t begin = 0; ringOk && begin < buffers.size(); begin += groupSize_)
+            ringOk = readWithRing(buffers.data() + begin, std::min(groupSize_, buffers.size() - begin));
+        if (ringOk) return buffers;
+#endif
+        for (auto& buffer : buffers) {
+            buffer.error.clear();
+            try {
+                buffer.bytes = readFileBytes(buffer.path);
+            } catch (const std::exception& e) {
+                buffer.error = e.what();
+            }
+        }
+        return buffers;
+    }
+
+private:
+#ifdef PIPELINE_HAS_IO_URING
+    // Returns false if the ring itself failed; the caller then falls back to plain reads.
+    bool readWithRing(FileBuffer* buffers, size_t n) {
+        auto fail = [&](size_t i, const char* what, int err) {
+            if (buffers[i].error.empty())
+                buffers[i].error = std::string(what) + buffers[i].path + " (" + std::strerror(err) + ")";
+        };
+
+        std::vector<int> fds = ring_.run(n, [&](io_uring_sqe& sqe, size_t i) {
+            sqe.opcode = IORING_OP_OPENAT;
+            sqe.fd = AT_FDCWD;
+            sqe.addr = reinterpret_cast<__u64>(buffers[i].path.c_str());
+            sqe.open_flags = O_RDONLY | O_CLOEXEC;
+        });
+        if (fds.size() != n) return false;
+        for (size_t i = 0; i < n; ++i)
+            if (fds[i] < 0) fail(i, "Failed to open: ", -fds[i]);
+
+        std::vector<struct statx> stats(n);
+        static const char empty[] = "";
+        std::vector<int> statResults = ring_.run(n, [&](io_uring_sqe& sqe, size_t i) {
+            if (fds[i] < 0) { sqe.opcode = IORING_OP_NOP; return; }
+            sqe.opcode = IORING_OP_STATX;
+            sqe.fd = fds[i];
+            sqe.addr = reinterpret_cast<__u64>(empty);
+            sqe.len = STATX_SIZE;
+            sqe.off = reinterpret_cast<__u64>(&stats[i]);
+            sqe.statx_flags = AT_EMPTY_PATH;
+        });
+        bool ringOk = statResults.size() == n;
+        for (size_t i = 0; ringOk && i < n; ++i) {
+            if (fds[i] < 0) continue;
+            if (statResults[i] < 0) fail(i, "Failed to stat: ", -statResults[i]);
+            else buffers[i].bytes.resize(static_cast<size_t>(stats[i].stx_size));
+        }
+
+        // Read until every file is complete; short reads are resubmitted from their offset.
+        std::vector<size_t> done(n, 0);
+        auto needsRead = [&](size_t i) { return fds[i] >= 0 && buffers[i].ok() && done[i] < buffers[i].bytes.size(); };
+        for (bool more = ringOk; more; ) {
+            std::vector<int> readResults = ring_.run(n, [&](io_uring_sqe& sqe, size_t i) {
+                if (!needsRead(i)) { sqe.opcode = IORING_OP_NOP; return; }
+                sqe.opcode = IORING_OP_READ;
+                sqe.fd = fds[i];
+                sqe.addr = reinterpret_cast<__u64>(buffers[i].bytes.data() + done[i]);
+                sqe.len = static_cast<__u32>(std::min<size_t>(buffers[i].bytes.size() - done[i], 1u << 30));
+                sqe.off = done[i];
+            });
+            if (readResults.size() != n) { ringOk = false; break; }
+            more = false;
+            for (size_t i = 0; i < n; ++i) {
+                if (!needsRead(i)) continue;
+                if (readResults[i] < 0) {
+                    fail(i, "Failed to read: ", -readResults[i]);
+                } else if (readResults[i] == 0) {
+                    buffers[i].bytes.resize(done[i]); // file shrank since statx
+                } else {
+                    done[i] += static_cast<size_t>(readResults[i]);
+                    more = more || needsRead(i);
+                }
+            }
+        }
+
+        std::vector<int> closeResults = ring_.run(n, [&](io_uring_sqe& sqe, size_t i) {
+            if (fds[i] < 0) { sqe.opcode = IORING_OP_NOP; return; }
+            sqe.opcode = IORING_OP_CLOSE;
+            sqe.fd = fds[i];
+        });
+        if (closeResults.size() != n)
+            for (size_t i = 0; i < n; ++i)
+                if (fds[i] >= 0) ::close(fds[i]);
+
+        for (size_t i = 0; i < n; ++i)
+            if (!buffers[i].ok()) buffers[i].bytes.clear();
+        return ringOk;
+    }
+#endif
+
+    size_t groupSize_; ///< Files opened at once
+#ifdef PIPELINE_HAS_IO_URING
+    detail::IoUring ring_;
+    bool ringReady_; ///< The ring exists and supports every operation used
+#endif
+};
+
+} // namespace pipeline
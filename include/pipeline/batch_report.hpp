@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace pipeline {
+
+/**
+ * @brief A single per-key failure collected during a batch operation.
+ */
+struct BatchFailure {
+    std::string key;   ///< Key of the image that failed.
+    std::string error; ///< Error message (usually the exception's what()).
+};
+
+/**
+ * @brief Outcome of a batch operation (parallel load, save, ...).
+ *
+ * Batch operations record per-key failures here instead of aborting the whole batch.
+ */
+struct BatchReport {
+    std::vector<std::string> succeeded; ///< Keys processed successfully.
+    std::vector<BatchFailure> failed;   ///< Keys that failed, with their error.
+
+    /**
+     * @brief true if no key failed.
+     */
+    bool ok() const { return failed.empty(); }
+};
+
+} // namespace pipeline
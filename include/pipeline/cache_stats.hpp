@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace pipeline {
+
+/**
+ * @brief Cache operations counted separately by CacheStats.
+ */
+enum class CacheOp {
+    IsCached,  ///< CacheManager::isCached
+    Get,       ///< CacheManager::getCached
+    GetShallow ///< CacheManager::getCachedShallow
+};
+
+/**
+ * @brief Point-in-time copy of a cache's counters (see CacheManager::stats).
+ */
+struct CacheStatsSnapshot {
+    uint64_t isCachedHits = 0;
+    uint64_t isCachedMisses = 0;
+    uint64_t getHits = 0;
+    uint64_t getMisses = 0;
+    uint64_t getShallowHits = 0;
+    uint64_t getShallowMisses = 0;
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;      ///< Entries dropped to make room (not explicit removals).
+    size_t residentBytes = 0;    ///< Bytes of image data currently cached.
+    size_t peakBytes = 0;        ///< Highest residentBytes seen.
+    std::chrono::nanoseconds decodeTimeSaved{0}; ///< Recorded decode cost of entries found by isCached.
+
+    /**
+     * @brief Fraction of isCached checks that found the key (0 if none were made).
+     */
+    double hitRate() const {
+        uint64_t total = isCachedHits + isCachedMisses;
+        return total == 0 ? 0.0 : static_cast<double>(isCachedHits) / static_cast<double>(total);
+    }
+};
+
+/**
+ * @brief Write a snapshot as one line of key=value pairs, e.g. for logs.
+ */
+inline std::ostream& operator<<(std::ostream& os, const CacheStatsSnapshot& s) {
+    return os << "isCached.hits=" << s.isCachedHits << " isCached.misses=" << s.isCachedMisses
+              << " get.hits=" << s.getHits << " get.misses=" << s.getMisses
+              << " getShallow.hits=" << s.getShallowHits << " getShallow.misses=" << s.getShallowMisses
+              << " insertions=" << s.insertions << " evictions=" << s.evictions
+              << " residentBytes=" << s.residentBytes << " peakBytes=" << s.peakBytes
+              << " decodeMsSaved=" << std::chrono::duration_cast<std::chrono::milliseconds>(s.decodeTimeSaved).count();
+}
+
+/**
+ * @brief Counters a cache manager updates as it is used.
+ *
+ * All counters are relaxed atomics: cheap enough to leave on, safe to read from another
+ * thread, but a snapshot taken during concurrent updates is not a consistent cut.
+ * Byte counts are owned by the cache manager and filled into the snapshot by it.
+ */
+class CacheStats {
+public:
+    void recordHit(CacheOp op) { hits_[index(op)].fetch_add(1, std::memory_order_relaxed); }
+    void recordMiss(CacheOp op) { misses_[index(op)].fetch_add(1, std::memory_order_relaxed); }
+    void recordInsertion() { insertions_.fetch_add(1, std::memory_order_relaxed); }
+    void recordEviction() { evictions_.fetch_add(1, std::memory_order_relaxed); }
+    void recordDecodeSaved(std::chrono::nanoseconds cost) { decodeNanosSaved_.fetch_add(static_cast<uint64_t>(cost.count()), std::memory_order_relaxed); }
+
+    /**
+     * @brief Copy the counters (byte fields are left at 0).
+     */
+    CacheStatsSnapshot snapshot() const {
+        CacheStatsSnapshot s;
+        s.isCachedHits = hits_[index(CacheOp::IsCached)].load(std::memory_order_relaxed);
+        s.isCachedMisses = misses_[index(CacheOp::IsCached)].load(std::memory_order_relaxed);
+        s.getHits = hits_[index(CacheOp::Get)].load(std::memory_order_relaxed);
+        s.getMisses = misses_[index(CacheOp::Get)].load(std::memory_order_relaxed);
+        s.getShallowHits = hits_[index(CacheOp::GetShallow)].load(std::memory_order_relaxed);
+        s.getShallowMisses = misses_[index(CacheOp::GetShallow)].load(std::memory_order_relaxed);
+        s.insertions = insertions_.load(std::memory_order_relaxed);
+        s.evictions = evictions_.load(std::memory_order_relaxed);
+        s.decodeTimeSaved = std::chrono::nanoseconds(decodeNanosSaved_.load(std::memory_order_relaxed));
+        return s;
+    }
+
+    /**
+     * @brief Reset all counters to zero.
+     */
+    void reset() {
+        for (auto& c : hits_) c.store(0, std::memory_order_relaxed);
+        for (auto& c : misses_) c.store(0, std::memory_order_relaxed);
+        insertions_.store(0, std::memory_order_relaxed);
+        evictions_.store(0, std::memory_order_relaxed);
+        decodeNanosSaved_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static size_t index(CacheOp op) { return static_cast<size_t>(op); }
+
+    std::atomic<uint64_t> hits_[3] = {};
+    std::atomic<uint64_t> misses_[3] = {};
+    std::atomic<uint64_t> insertions_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> decodeNanosSaved_{0};
+};
+
+} // namespace pipeline
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace pipeline {
+
+/**
+ * @brief JPEG chroma subsampling mode.
+ */
+enum class ChromaSubsampling {
+    Default, ///< Encoder default (4:2:0 for libjpeg).
+    S444,    ///< No subsampling: best colour fidelity, largest files.
+    S422,    ///< Horizontal subsampling.
+    S420     ///< Horizontal and vertical subsampling: smallest files.
+};
+
+/**
+ * @brief Encoder settings trading encode speed against file size and quality.
+ *
+ * Fields left at -1 (or Default) keep the encoder's default. Only the fields matching the
+ * output format are used, so one profile can serve JPEG, PNG and WebP outputs alike.
+ * Attach profiles per output subdirectory with Pipeline::setProfile, or pass one to a save call.
+ */
+struct EncodeProfile {
+    std::string format;      ///< Output extension replacing the key's (e.g. ".png"); empty keeps it.
+    int jpegQuality = -1;    ///< JPEG quality, 0-100.
+    int pngCompression = -1; ///< PNG zlib level, 0-9; low levels encode several times faster.
+    bool progressive = false; ///< Write progressive instead of baseline JPEG.
+    ChromaSubsampling subsampling = ChromaSubsampling::Default; ///< JPEG chroma subsampling.
+    int webpQuality = -1;    ///< WebP quality, 1-100 (above 100 selects lossless).
+
+    /**
+     * @brief Cheap to encode: for previews and debug outputs.
+     */
+    static EncodeProfile fast() {
+        EncodeProfile p;
+        p.jpegQuality = 80;
+        p.pngCompression = 1;
+        p.subsampling = ChromaSubsampling::S420;
+        p.webpQuality = 75;
+        return p;
+    }
+
+    /**
+     * @brief Good quality at a moderate encode cost.
+     */
+    static EncodeProfile balanced() {
+        EncodeProfile p;
+        p.jpegQuality = 90;
+        p.pngCompression = 3;
+        p.webpQuality = 90;
+        return p;
+    }
+
+    /**
+     * @brief Smallest files at the highest encode cost: for archival outputs.
+     */
+    static EncodeProfile small() {
+        EncodeProfile p;
+        p.jpegQuality = 75;
+        p.pngCompression = 9;
+        p.progressive = true;
+        p.subsampling = ChromaSubsampling::S420;
+        p.webpQuality = 70;
+        return p;
+    }
+
+    /**
+     * @brief Look up a preset by name ("fast", "balanced" or "small").
+     *
+     * @throws std::invalid_argument for an unknown name.
+     */
+    static EncodeProfile preset(const std::string& name) {
+        if (name == "fast") return fast();
+        if (name == "balanced") return balanced();
+        if (name == "small") return small();
+        throw std::invalid_argument("Unknown encode profile: " + name);
+    }
+
+    /**
+     * @brief Apply the format override to a file name or path.
+     *
+     * @param filename File name or path whose extension may be replaced.
+     * @return The name with its extension replaced by format, or unchanged if format is empty.
+     */
+    std::string applyFormat(const std::string& filename) const {
+        if (format.empty()) return filename;
+        return std::filesystem::path(filename).replace_extension(format).string();
+    }
+
+    bool operator==(const EncodeProfile&) const = default;
+};
+
+/**
+ * @brief One destination of a fan-out save (see Pipeline::saveFanOut).
+ */
+struct SaveTarget {
+    std::string subdir;                   ///< Output subdirectory under the output folder.
+    std::string suffix;                   ///< Appended to the filename before the extension; may be empty.
+    std::optional<EncodeProfile> profile; ///< Encoder settings; unset uses the subdirectory's profile.
+
+    /**
+     * @brief Output filename for a key: its filename (".jpg" if it has no extension) with the
+     * suffix appended and the profile's format override applied.
+     */
+    std::string filenameFor(const std::string& key) const {
+        std::filesystem::path keyPath(key);
+        std::string extension = keyPath.extension().empty() ? std::string(".jpg") : keyPath.extension().string();
+        std::string filename = keyPath.stem().string() + suffix + extension;
+        return profile ? profile->applyFormat(filename) : filename;
+    }
+};
+
+} // namespace pipeline
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cerrno>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#if defined(__linux__)
+#define PIPELINE_HAS_COPY_FILE_RANGE 1
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pipeline {
+
+#ifdef PIPELINE_HAS_COPY_FILE_RANGE
+
+namespace detail {
+
+/**
+ * @brief Copy a file inside the kernel: reflink (FICLONE) first, then copy_file_range.
+ *
+ * A destination that is the source itself (another path to the same inode) is left as is.
+ *
+ * @return false if neither is supported for this pair of files (e.g. across filesystems on
+ *         old kernels); the destination may then be truncated and the caller should fall back.
+ * @throws std::runtime_error if a file cannot be opened or the copy fails.
+ */
+inline bool copyFileInKernel(const std::string& from, const std::string& to) {
+    int in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) throw std::runtime_error("Failed to open: " + from);
+    struct stat st;
+    if (::fstat(in, &st) != 0) {
+        ::close(in);
+        throw std::runtime_error("Failed to read: " + from);
+    }
+    int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (out < 0) {
+        ::close(in);
+        throw std::runtime_error("Failed to open for writing: " + to);
+    }
+    struct stat outSt;
+    if (::fstat(out, &outSt) == 0 && outSt.st_dev == st.st_dev && outSt.st_ino == st.st_ino) {
+        ::close(in);
+        ::close(out);
+        return true; // Truncating would empty the source
+    }
+    if (::ftruncate(out, 0) != 0) {
+        ::close(in);
+        ::close(out);
+        throw std::runtime_error("Failed to truncate: " + to);
+    }
+
+    bool copied = false;
+    int error = 0;
+#ifdef FICLONE
+    // Shares the source's extents on CoW filesystems (btrfs, XFS): no data is copied at all
+    copied = ::ioctl(out, FICLONE, in) == 0;
+#endif
+    off_t remaining = st.st_size;
+    while (!copied && remaining > 0) {
+        ssize_t n = ::copy_file_range(in, nullptr, out, nullptr, static_cast<size_t>(remaining), 0);
+        if (n > 0) {
+            remaining -= n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            error = n < 0 ? errno : EIO; // n == 0: source shrank while copying
+            break;
+        }
+    }
+    ::close(in);
+    ::close(out);
+    if (copied || remaining == 0) return true;
+    if (error == EXDEV || error == ENOSYS || error == EOPNOTSUPP || error == EINVAL) return false;
+    throw std::runtime_error("Failed to copy " + from + " to " + to);
+}
+
+} // namespace detail
+
+#endif // PIPELINE_HAS_COPY_FILE_RANGE
+
+/**
+ * @brief Copy a file, replacing the destination, without passing the data through user space
+ * where the platform allows it.
+ *
+ * On Linux this tries a reflink (FICLONE), then copy_file_range; otherwise, or if neither
+ * applies, it falls back to std::filesystem::copy_file. Copying a file onto itself (e.g. the
+ * same path spelled differently, or a hard link) does nothing.
+ *
+ * @param from Source file.
+ * @param to Destination file; its directory must exist.
+ * @throws std::runtime_error if the copy fails.
+ */
+inline void copyFile(const std::string& from, const std::string& to) {
+    std::error_code ec;
+    if (std::filesystem::equivalent(from, to, ec)) return;
+#ifdef PIPELINE_HAS_COPY_FILE_RANGE
+    if (detail::copyFileInKernel(from, to)) return;
+#endif
+    std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, ec);
+    if (ec) throw std::runtime_error("Failed to copy " + from + " to " + to + ": " + ec.message());
+}
+
+} // namespace pipeline
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace pipeline {
+
+/**
+ * @brief Image properties read from the file header, without decoding pixels.
+ */
+struct ImageInfo {
+    int width = 0;      ///< Width in pixels as stored (EXIF orientation is not applied).
+    int height = 0;     ///< Height in pixels as stored.
+    int channels = 0;   ///< Channels as stored (1 = gray, 3 = color, 4 = with alpha).
+    std::string format; ///< "jpeg", "png", "gif", "bmp" or "webp".
+};
+
+namespace detail {
+
+inline uint32_t readBE(const unsigned char* p, int n) {
+    uint32_t v = 0;
+    for (int i = 0; i < n; ++i) v = (v << 8) | p[i];
+    return v;
+}
+
+inline uint32_t readLE(const unsigned char* p, int n) {
+    uint32_t v = 0;
+    for (int i = n - 1; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+// Walk JPEG markers up to the first SOFn segment
+inline bool probeJpeg(std::istream& in, ImageInfo& info) {
+    in.seekg(2);
+    unsigned char seg[8];
+    for (;;) {
+        int byte = in.get();
+        while (byte != EOF && byte != 0xFF) byte = in.get();
+        while (byte == 0xFF) byte = in.get();
+        if (byte == EOF) return false;
+        int marker = byte;
+        if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) continue;
+        if (marker == 0xD9 || marker == 0xDA) return false;
+        if (!in.read(reinterpret_cast<char*>(seg), 2)) return false;
+        uint32_t length = readBE(seg, 2);
+        if (length < 2) return false;
+        bool isSof = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        if (isSof) {
+            if (length < 8 || !in.read(reinterpret_cast<char*>(seg), 6)) return false;
+            info.height = static_cast<int>(readBE(seg + 1, 2));
+            info.width = static_cast<int>(readBE(seg + 3, 2));
+            info.channels = seg[5];
+            info.format = "jpeg";
+            return true;
+        }
+        in.seekg(length - 2, std::ios::cur);
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Format name, as in ImageInfo::format, that a file extension stands for.
+ *
+ * @param path File path or key, e.g. "animals/cat.JPG".
+ * @return "jpeg", "png", "gif", "bmp", "webp", or an empty string for other extensions.
+ */
+inline std::string formatForExtension(const std::string& path) {
+    size_t dot = path.find_last_of("./");
+    if (dot == std::string::npos || path[dot] != '.') return "";
+    std::string extension = path.substr(dot + 1);
+    for (char& c : extension) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    if (extension == "jpg" || extension == "jpeg" || extension == "jpe") return "jpeg";
+    if (extension == "png" || extension == "gif" || extension == "bmp" || extension == "webp") return extension;
+    return "";
+}
+
+/**
+ * @brief Read an image's dimensions, channel count and format from its container header.
+ *
+ * Supports JPEG (SOF segment), PNG (IHDR), GIF, BMP and WebP (VP8, VP8L, VP8X).
+ *
+ * @param path Filesystem path to the image file.
+ * @return ImageInfo Parsed header information.
+ * @throws std::runtime_error if the file cannot be read or the format is not recognized.
+ */
+inline ImageInfo probeImageFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Failed to open: " + path);
+    std::array<unsigned char, 32> h{};
+    in.read(reinterpret_cast<char*>(h.data()), h.size());
+    std::streamsize n = in.gcount();
+    in.clear();
+    ImageInfo info;
+
+    if (n >= 3 && h[0] == 0xFF && h[1] == 0xD8 && h[2] == 0xFF) {
+        if (detail::probeJpeg(in, info)) return info;
+    } else if (n >= 26 && h[0] == 0x89 && h[1] == 'P' && h[2] == 'N' && h[3] == 'G') {
+        static const int pngChannels[] = {1, 0, 3, 3, 2, 0, 4};
+        info.width = static_cast<int>(detail::readBE(&h[16], 4));
+        info.height = static_cast<int>(detail::readBE(&h[20], 4));
+        info.channels = h[25] <= 6 ? pngChannels[h[25]] : 0;
+        info.format = "png";
+        return info;
+    } else if (n >= 10 && h[0] == 'G' && h[1] == 'I' && h[2] == 'F') {
+        info.width = static_cast<int>(detail::readLE(&h[6], 2));
+        info.height = static_cast<int>(detail::readLE(&h[8], 2));
+        info.channels = 3;
+        info.format = "gif";
+        return info;
+    } else if (n >= 30 && h[0] == 'B' && h[1] == 'M') {
+        info.width = static_cast<int>(detail::readLE(&h[18], 4));
+        info.height = std::abs(static_cast<int32_t>(detail::readLE(&h[22], 4)));
+        int bpp = static_cast<int>(detail::readLE(&h[28], 2));
+        info.channels = bpp == 32 ? 4 : (bpp <= 8 ? 1 : 3);
+        info.format = "bmp";
+        return info;
+    } else if (n >= 30 && std::string(h.begin(), h.begin() + 4) == "RIFF" && std::string(h.begin() + 8, h.begin() + 12) == "WEBP") {
+        std::string chunk(h.begin() + 12, h.begin() + 16);
+        info.format = "webp";
+        if (chunk == "VP8 ") {
+            info.width = static_cast<int>(detail::readLE(&h[26], 2) & 0x3FFF);
+            info.height = static_cast<int>(detail::readLE(&h[28], 2) & 0x3FFF);
+            info.channels = 3;
+            return info;
+        }
+        if (chunk == "VP8L") {
+            uint32_t bits = detail::readLE(&h[21], 4);
+            info.width = static_cast<int>((bits & 0x3FFF) + 1);
+            info.height = static_cast<int>(((bits >> 14) & 0x3FFF) + 1);
+            info.channels = (bits >> 28) & 1 ? 4 : 3;
+            return info;
+        }
+        if (chunk == "VP8X") {
+            info.width = static_cast<int>(detail::readLE(&h[24], 3) + 1);
+            info.height = static_cast<int>(detail::readLE(&h[27], 3) + 1);
+            info.channels = h[20] & 0x10 ? 4 : 3;
+            return info;
+        }
+    }
+    throw std::runtime_error("Unsupported or corrupt image header: " + path);
+}
+
+} // namespace pipeline
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "pipeline/image_probe.hpp"
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pipeline {
+
+/**
+ * @brief Per-image-type helpers used by memory-aware components (prefetching, budgets).
+ *
+ * The primary template only knows sizeof(ImageType). Specialize it for image types that
+ * own heap buffers (see opencv_specializations.hpp for cv::Mat).
+ *
+ * @tparam ImageType The image type.
+ */
+template <typename ImageType>
+struct ImageTraits {
+    /**
+     * @brief Approximate number of bytes held by an image.
+     */
+    static size_t byteSize(const ImageType& image) { return sizeof(image); }
+
+    /**
+     * @brief Make sure the image does not share its pixels with another copy before an in-place write.
+     *
+     * Value types never share, so the primary template does nothing. Types with shallow copies
+     * (cv::Mat) detach here, which lets savers keep cheap snapshots of images still being edited.
+     */
+    static void makeExclusive(ImageType& image) { (void)image; }
+
+    /**
+     * @brief Width, height and channels of a decoded image (format is left empty).
+     *
+     * Used by Pipeline::filterByInfo for images already in the working set. The primary
+     * template cannot inspect an arbitrary type and returns std::nullopt; the pipeline then
+     * probes the image's source file instead.
+     */
+    static std::optional<ImageInfo> describe(const ImageType& image) {
+        (void)image;
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Write the image's pixels uncompressed to a file, to be read back with readRaw.
+     *
+     * Used by SpillCacheManager. The primary template cannot serialize an arbitrary type and
+     * returns false, so such images are simply not spilled.
+     *
+     * @return true if the file was written.
+     */
+    static bool writeRaw(const ImageType& image, const std::string& path) {
+        (void)image;
+        (void)path;
+        return false;
+    }
+
+    /**
+     * @brief Append the writeRaw file contents of the image to a buffer instead of a file.
+     *
+     * Used by RemoteCacheManager for raw payloads. The primary template returns false.
+     *
+     * @return true if the image was serialized.
+     */
+    static bool encodeRaw(const ImageType& image, std::vector<unsigned char>& bytes) {
+        (void)image;
+        (void)bytes;
+        return false;
+    }
+
+    /**
+     * @brief Rebuild an image from the contents of a file written by writeRaw (e.g. memory-mapped).
+     *
+     * @return The image, or std::nullopt if the data is not recognized.
+     */
+    static std::optional<ImageType> readRaw(const unsigned char* data, size_t size) {
+        (void)data;
+        (void)size;
+        return std::nullopt;
+    }
+};
+
+} // namespace pipeline
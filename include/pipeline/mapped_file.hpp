@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PIPELINE_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pipeline {
+
+/**
+ * @brief Memory mapping of a whole file (POSIX mmap).
+ *
+ * The mapping is read-only, or private copy-on-write if requested (writes never reach the file).
+ * It is released by the destructor, so keep the object scoped to its users.
+ * valid() is false if the file could not be mapped (empty file, unsupported platform, ...);
+ * callers are expected to fall back to readFileBytes().
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Map a file.
+     *
+     * @param path Filesystem path to map.
+     * @param sequential Advise the kernel the mapping will be read once, front to back,
+     *        and should be read ahead (MADV_SEQUENTIAL + MADV_WILLNEED).
+     * @param copyOnWrite Map pages writable but private, so writes only touch this process's copy.
+     */
+    explicit MappedFile(const std::string& path, bool sequential = true, bool copyOnWrite = false) {
+#ifdef PIPELINE_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            int prot = copyOnWrite ? (PROT_READ | PROT_WRITE) : PROT_READ;
+            void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), prot, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data_ = static_cast<unsigned char*>(addr);
+                size_ = static_cast<size_t>(st.st_size);
+                if (sequential) {
+                    ::madvise(addr, size_, MADV_SEQUENTIAL);
+                    ::madvise(addr, size_, MADV_WILLNEED);
+                }
+            }
+        }
+        ::close(fd);
+#else
+        (void)path;
+        (void)sequential;
+        (void)copyOnWrite;
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef PIPELINE_HAS_MMAP
+        if (data_) ::munmap(data_, size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool valid() const { return data_ != nullptr; }
+    const unsigned char* data() const { return data_; }
+    unsigned char* data() { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief Read a whole file into memory.
+ *
+ * @param path Filesystem path to read.
+ * @return std::vector<unsigned char> File contents.
+ * @throws std::runtime_error if the file cannot be read.
+ */
+inline std::vector<unsigned char> readFileBytes(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) throw std::runtime_error("Failed to open: " + path);
+    std::streamsize size = in.tellg();
+    if (size < 0) throw std::runtime_error("Failed to read: " + path);
+    std::vector<unsigned char> bytes(static_cast<size_t>(size));
+    in.seekg(0);
+    if (size > 0 && !in.read(reinterpret_cast<char*>(bytes.data()), size))
+        throw std::runtime_error("Failed to read: " + path);
+    return bytes;
+}
+
+/**
+ * @brief Write a whole buffer to a file, replacing it.
+ *
+ * @param path Filesystem path to write.
+ * @param bytes File contents.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+inline void writeFileBytes(const std::string& path, const std::vector<unsigned char>& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("Failed to open for writing: " + path);
+    if (!out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+        throw std::runtime_error("Failed to write: " + path);
+}
+
+} // namespace pipeline
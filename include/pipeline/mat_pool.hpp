@@ -0,0 +1,174 @@
+#pragma once
+
+#ifdef HAVE_OPENCV_CORE
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace pipeline {
+
+/**
+ * @brief Counters of a PooledMatAllocator.
+ */
+struct MatPoolStats {
+    size_t hits = 0;             ///< Allocations served from a pooled buffer.
+    size_t misses = 0;           ///< Allocations that needed a fresh buffer.
+    size_t recycled = 0;         ///< Buffers returned to the pool on release.
+    size_t dropped = 0;          ///< Buffers freed on release because the pool was full.
+    size_t pooledBytes = 0;      ///< Bytes currently idle in the pool.
+    size_t pooledBuffers = 0;    ///< Buffers currently idle in the pool.
+    size_t outstandingBytes = 0; ///< Bytes currently held by live cv::Mat data.
+};
+
+/**
+ * @brief cv::MatAllocator that recycles pixel buffers by size class.
+ * 
+ * Sizes are rounded up to 4 KiB classes; a released buffer is kept on its class's free list
+ * (up to maxPooledBytes in total) and handed to the next allocation of the same class.
+ * Decoded photos usually share a handful of resolutions, so steady-state decode/process/cache
+ * cycles stop hitting malloc/mmap and page faults. Thread-safe.
+ * 
+ * Install it as OpenCV's default allocator with installMatPool(); the allocator must outlive
+ * every cv::Mat it allocated.
+ */
+class PooledMatAllocator : public cv::MatAllocator {
+public:
+    /**
+     * @brief Construct a new PooledMatAllocator.
+     * 
+     * @param maxPooledBytes Maximum bytes of idle buffers kept for reuse.
+     */
+    explicit PooledMatAllocator(size_t maxPooledBytes = size_t(1) << 30) : maxPooledBytes_(maxPooledBytes) {}
+
+    ~PooledMatAllocator() override { trim(); }
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                           cv::AccessFlag /*flags*/, cv::UMatUsageFlags /*usageFlags*/) const override {
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; --i) {
+            if (step) {
+                if (data0 && step[i] != CV_AUTOSTEP) {
+                    CV_Assert(total <= step[i]);
+                    total = step[i];
+                } else {
+                    step[i] = total;
+                }
+            }
+            total *= sizes[i];
+        }
+        cv::UMatData* u = new cv::UMatData(this);
+        u->size = total;
+        if (data0) {
+            u->data = u->origdata = static_cast<unsigned char*>(data0);
+            u->flags |= cv::UMatData::USER_ALLOCATED;
+            return u;
+        }
+        u->data = u->origdata = static_cast<unsigned char*>(acquire(total));
+        return u;
+    }
+
+    bool allocate(cv::UMatData* u, cv::AccessFlag /*accessFlags*/, cv::UMatUsageFlags /*usageFlags*/) const override {
+        return u != nullptr;
+    }
+
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) return;
+        CV_Assert(u->urefcount == 0);
+        CV_Assert(u->refcount == 0);
+        if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+            release(u->origdata, u->size);
+            u->origdata = nullptr;
+        }
+        delete u;
+    }
+
+    /**
+     * @brief Snapshot of the pool counters.
+     */
+    MatPoolStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    /**
+     * @brief Free every idle buffer.
+     */
+    void trim() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [_, buffers] : free_)
+            for (void* buffer : buffers) cv::fastFree(buffer);
+        free_.clear();
+        stats_.pooledBytes = 0;
+        stats_.pooledBuffers = 0;
+    }
+
+private:
+    static size_t sizeClass(size_t bytes) {
+        constexpr size_t granularity = 4096;
+        return (bytes + granularity - 1) / granularity * granularity;
+    }
+
+    void* acquire(size_t bytes) const {
+        size_t cls = sizeClass(bytes);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.outstandingBytes += cls;
+            auto it = free_.find(cls);
+            if (it != free_.end() && !it->second.empty()) {
+                void* buffer = it->second.back();
+                it->second.pop_back();
+                stats_.pooledBytes -= cls;
+                --stats_.pooledBuffers;
+                ++stats_.hits;
+                return buffer;
+            }
+            ++stats_.misses;
+        }
+        return cv::fastMalloc(cls);
+    }
+
+    void release(void* buffer, size_t bytes) const {
+        size_t cls = sizeClass(bytes);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.outstandingBytes -= cls;
+            if (stats_.pooledBytes + cls <= maxPooledBytes_) {
+                free_[cls].push_back(buffer);
+                stats_.pooledBytes += cls;
+                ++stats_.pooledBuffers;
+                ++stats_.recycled;
+                return;
+            }
+            ++stats_.dropped;
+        }
+        cv::fastFree(buffer);
+    }
+
+    size_t maxPooledBytes_; ///< Cap on idle pooled bytes
+    mutable std::mutex mutex_;
+    mutable std::unordered_map<size_t, std::vector<void*>> free_; ///< Size class to idle buffers
+    mutable MatPoolStats stats_;
+};
+
+/**
+ * @brief Install a process-wide PooledMatAllocator as OpenCV's default allocator.
+ * 
+ * Every cv::Mat allocated afterwards (decoding, cache copies, processing results) draws from
+ * the pool. The allocator is created on first call and intentionally never destroyed, since
+ * cv::Mat objects may release their buffers during static destruction.
+ * 
+ * @param maxPooledBytes Maximum bytes of idle buffers kept for reuse (first call only).
+ * @return The installed allocator, e.g. to read stats().
+ */
+inline PooledMatAllocator& installMatPool(size_t maxPooledBytes = size_t(1) << 30) {
+    static PooledMatAllocator* allocator = new PooledMatAllocator(maxPooledBytes);
+    cv::Mat::setDefaultAllocator(allocator);
+    return *allocator;
+}
+
+} // namespace pipeline
+
+#endif // HAVE_OPENCV_CORE
@@ -3,41 +3,275 @@
 #ifdef HAVE_OPENCV_CORE
 
 #include "pipeline/strategy_default.hpp"
+#include "pipeline/image_traits.hpp"
+#include "pipeline/mapped_file.hpp"
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/core.hpp>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <optional>
 #include <stdexcept>
 
 namespace pipeline {
 
+namespace detail {
+
+/**
+ * @brief Decode an image file with imdecode straight from a memory mapping.
+ * 
+ * Falls back to reading the file into a buffer if it cannot be mapped, and to imread for
+ * files too large for a single cv::Mat row. The mapping is released right after decoding.
+ * Throws std::runtime_error if decoding fails.
+ */
+inline cv::Mat decodeFile(const std::string& path, int flags) {
+    cv::Mat img;
+    {
+        MappedFile mapped(path);
+        if (mapped.valid() && mapped.size() <= static_cast<size_t>(INT_MAX)) {
+            cv::Mat bytes(1, static_cast<int>(mapped.size()), CV_8U, const_cast<unsigned char*>(mapped.data()));
+            img = cv::imdecode(bytes, flags);
+        } else if (!mapped.valid()) {
+            std::vector<unsigned char> bytes = readFileBytes(path);
+            if (!bytes.empty()) img = cv::imdecode(cv::Mat(1, static_cast<int>(bytes.size()), CV_8U, bytes.data()), flags);
+        } else {
+            img = cv::imread(path, flags);
+        }
+    }
+    if (img.empty()) throw std::runtime_error("Failed to load: " + path);
+    return img;
+}
+
+} // namespace detail
+
 /**
  * @brief Specialization of DefaultImageLoader for cv::Mat.
  * 
- * Loads an image from a file using OpenCV's imread.
+ * Memory-maps the file and decodes it in place with OpenCV's imdecode (see detail::decodeFile).
  * Throws std::runtime_error if loading fails.
  */
 template <>
 inline cv::Mat DefaultImageLoader<cv::Mat>::loadFromFile(const std::string& path) {
-    cv::Mat img = cv::imread(path);
-    if (img.empty()) throw std::runtime_error("Failed to load: " + path);
+    return detail::decodeFile(path, cv::IMREAD_COLOR);
+}
+
+/**
+ * @brief Specialization of DefaultImageLoader::loadFromBuffer for cv::Mat.
+ * 
+ * Decodes encoded bytes with OpenCV's imdecode.
+ * Throws std::runtime_error if decoding fails.
+ */
+template <>
+inline cv::Mat DefaultImageLoader<cv::Mat>::loadFromBuffer(const std::vector<unsigned char>& bytes) {
+    cv::Mat img;
+    if (!bytes.empty())
+        img = cv::imdecode(cv::Mat(1, static_cast<int>(bytes.size()), CV_8U, const_cast<unsigned char*>(bytes.data())), cv::IMREAD_COLOR);
+    if (img.empty()) throw std::runtime_error("Failed to decode image from memory");
     return img;
 }
 
+/**
+ * @brief Specialization of DefaultImageLoader::loadScaled for cv::Mat.
+ * 
+ * Uses OpenCV's IMREAD_REDUCED_COLOR_* modes, which JPEG decodes in the DCT domain.
+ * The denominator is rounded down to 1, 2, 4 or 8; a minimum size is resolved from the file header.
+ * Throws std::runtime_error if loading fails.
+ */
+template <>
+inline cv::Mat DefaultImageLoader<cv::Mat>::loadScaled(const std::string& path, const DecodeOptions& options) {
+    int denominator = options.scaleDenominator;
+    if (options.hasMinimumSize()) {
+        ImageInfo info = probe(path);
+        denominator = options.denominatorFor(info.width, info.height);
+    }
+    int flags = cv::IMREAD_COLOR;
+    if (denominator >= 8) flags = cv::IMREAD_REDUCED_COLOR_8;
+    else if (denominator >= 4) flags = cv::IMREAD_REDUCED_COLOR_4;
+    else if (denominator >= 2) flags = cv::IMREAD_REDUCED_COLOR_2;
+    return detail::decodeFile(path, flags);
+}
+
+namespace detail {
+
+/**
+ * @brief Translate an EncodeProfile into imwrite/imencode parameters for a file extension.
+ * 
+ * @param extension Output extension, e.g. ".jpg" (case-insensitive).
+ * @param profile Encoder settings.
+ * @return Flat list of (flag, value) pairs.
+ */
+inline std::vector<int> encodeParams(const std::string& extension, const EncodeProfile& profile) {
+    std::string ext = extension;
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    std::vector<int> params;
+    if (ext == ".jpg" || ext == ".jpeg" || ext == ".jpe") {
+        if (profile.jpegQuality >= 0) params.insert(params.end(), {cv::IMWRITE_JPEG_QUALITY, profile.jpegQuality});
+        if (profile.progressive) params.insert(params.end(), {cv::IMWRITE_JPEG_PROGRESSIVE, 1});
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && (CV_VERSION_MINOR > 5 || (CV_VERSION_MINOR == 5 && CV_VERSION_REVISION >= 5)))
+        // IMWRITE_JPEG_SAMPLING_FACTOR exists since OpenCV 4.5.5; older versions keep the encoder default
+        switch (profile.subsampling) {
+        case ChromaSubsampling::S444: params.insert(params.end(), {cv::IMWRITE_JPEG_SAMPLING_FACTOR, cv::IMWRITE_JPEG_SAMPLING_FACTOR_444}); break;
+        case ChromaSubsampling::S422: params.insert(params.end(), {cv::IMWRITE_JPEG_SAMPLING_FACTOR, cv::IMWRITE_JPEG_SAMPLING_FACTOR_422}); break;
+        case ChromaSubsampling::S420: params.insert(params.end(), {cv::IMWRITE_JPEG_SAMPLING_FACTOR, cv::IMWRITE_JPEG_SAMPLING_FACTOR_420}); break;
+        case ChromaSubsampling::Default: break;
+        }
+#endif
+    } else if (ext == ".png") {
+        if (profile.pngCompression >= 0) params.insert(params.end(), {cv::IMWRITE_PNG_COMPRESSION, profile.pngCompression});
+    } else if (ext == ".webp") {
+        if (profile.webpQuality >= 0) params.insert(params.end(), {cv::IMWRITE_WEBP_QUALITY, profile.webpQuality});
+    }
+    return params;
+}
+
+} // namespace detail
+
+/**
+ * @brief Specialization of DefaultImageSaver for cv::Mat with encoder settings.
+ * 
+ * Saves an image to a file using OpenCV's imwrite, passing the profile's parameters
+ * for the file's format. Creates the necessary directories if they do not exist.
+ * 
+ * @param outputPath Path to save the image.
+ * @param image The cv::Mat image to save.
+ * @param profile Encoder settings.
+ * @throws std::runtime_error if the image cannot be encoded or written.
+ */
+template <>
+inline void DefaultImageSaver<cv::Mat>::save(const std::string& outputPath, const cv::Mat& image, const EncodeProfile& profile) {
+    ensureParentDirectory(outputPath);
+    std::string extension = std::filesystem::path(outputPath).extension().string();
+    if (!cv::imwrite(outputPath, image, detail::encodeParams(extension, profile)))
+        throw std::runtime_error("Failed to save image: " + outputPath);
+}
+
 /**
  * @brief Specialization of DefaultImageSaver for cv::Mat.
  * 
- * Saves an image to a file using OpenCV's imwrite.
- * Creates the necessary directories if they do not exist.
+ * Saves an image to a file using OpenCV's imwrite with default encoder settings.
  * 
  * @param outputPath Path to save the image.
  * @param image The cv::Mat image to save.
+ * @throws std::runtime_error if the image cannot be encoded or written.
  */
 template <>
 inline void DefaultImageSaver<cv::Mat>::save(const std::string& outputPath, const cv::Mat& image) {
-    std::filesystem::create_directories(std::filesystem::path(outputPath).parent_path());
-    cv::imwrite(outputPath, image);
+    save(outputPath, image, EncodeProfile{});
+}
+
+/**
+ * @brief Specialization of DefaultImageSaver for cv::Mat: encoding to memory is supported.
+ */
+template <>
+inline bool DefaultImageSaver<cv::Mat>::supportsEncode() const { return true; }
+
+/**
+ * @brief Specialization of DefaultImageSaver for cv::Mat.
+ * 
+ * Encodes an image into memory using OpenCV's imencode.
+ * 
+ * @param image The cv::Mat image to encode.
+ * @param extension Format as a file extension (e.g. ".jpg").
+ * @param profile Encoder settings.
+ * @return Encoded file contents.
+ * @throws std::runtime_error if the image cannot be encoded.
+ */
+template <>
+inline std::vector<unsigned char> DefaultImageSaver<cv::Mat>::encode(const cv::Mat& image, const std::string& extension, const EncodeProfile& profile) {
+    std::vector<unsigned char> bytes;
+    if (!cv::imencode(extension, image, bytes, detail::encodeParams(extension, profile)))
+        throw std::runtime_error("Failed to encode image as " + extension);
+    return bytes;
 }
 
+namespace detail {
+
+/**
+ * @brief Header of a raw cv::Mat file (see ImageTraits<cv::Mat>::writeRaw), followed by rows * cols * elemSize bytes.
+ */
+struct RawMatHeader {
+    uint32_t magic;
+    int32_t rows;
+    int32_t cols;
+    int32_t type;
+};
+
+inline constexpr uint32_t kRawMatMagic = 0x3154414Du; // "MAT1"
+
+/**
+ * @brief Bytes of an unpadded rows x cols image of the given type.
+ * @return nullopt if the dimensions are not positive, the type is not a valid cv::Mat type or the size overflows.
+ */
+inline std::optional<size_t> rawMatBytes(int rows, int cols, int type) {
+    if (rows <= 0 || cols <= 0 || (type & ~CV_MAT_TYPE_MASK) != 0 || CV_MAT_DEPTH(type) > CV_16F) return std::nullopt;
+    size_t elemSize = CV_ELEM_SIZE(type);
+    size_t r = static_cast<size_t>(rows), c = static_cast<size_t>(cols);
+    if (c > SIZE_MAX / elemSize || r > SIZE_MAX / (c * elemSize)) return std::nullopt;
+    return r * c * elemSize;
+}
+
+} // namespace detail
+
+/**
+ * @brief Specialization of ImageTraits for cv::Mat.
+ * 
+ * Sizes an image by its pixel buffer; raw files are a small header plus the rows, unpadded.
+ */
+template <>
+struct ImageTraits<cv::Mat> {
+    static size_t byteSize(const cv::Mat& image) { return image.total() * image.elemSize(); }
+
+    static void makeExclusive(cv::Mat& image) {
+        if (image.u && image.u->refcount > 1) image = image.clone();
+    }
+
+    static std::optional<ImageInfo> describe(const cv::Mat& image) {
+        ImageInfo info;
+        info.width = image.cols;
+        info.height = image.rows;
+        info.channels = image.channels();
+        return info;
+    }
+
+    static bool writeRaw(const cv::Mat& image, const std::string& path) {
+        if (image.empty() || image.dims != 2) return false;
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        detail::RawMatHeader header{detail::kRawMatMagic, image.rows, image.cols, image.type()};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        size_t rowBytes = static_cast<size_t>(image.cols) * image.elemSize();
+        for (int r = 0; r < image.rows && out; ++r)
+            out.write(reinterpret_cast<const char*>(image.ptr(r)), static_cast<std::streamsize>(rowBytes));
+        return static_cast<bool>(out.flush());
+    }
+
+    static bool encodeRaw(const cv::Mat& image, std::vector<unsigned char>& bytes) {
+        if (image.empty() || image.dims != 2) return false;
+        detail::RawMatHeader header{detail::kRawMatMagic, image.rows, image.cols, image.type()};
+        size_t rowBytes = static_cast<size_t>(image.cols) * image.elemSize();
+        size_t at = bytes.size();
+        bytes.resize(at + sizeof(header) + rowBytes * static_cast<size_t>(image.rows));
+        std::memcpy(bytes.data() + at, &header, sizeof(header));
+        unsigned char* out = bytes.data() + at + sizeof(header);
+        for (int r = 0; r < image.rows; ++r, out += rowBytes) std::memcpy(out, image.ptr(r), rowBytes);
+        return true;
+    }
+
+    static std::optional<cv::Mat> readRaw(const unsigned char* data, size_t size) {
+        detail::RawMatHeader header;
+        if (size < sizeof(header)) return std::nullopt;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != detail::kRawMatMagic) return std::nullopt;
+        std::optional<size_t> bytes = detail::rawMatBytes(header.rows, header.cols, header.type);
+        if (!bytes || *bytes != size - sizeof(header)) return std::nullopt; // Checked before allocating
+        cv::Mat image(header.rows, header.cols, header.type);
+        std::memcpy(image.data, data + sizeof(header), *bytes); // Freshly allocated, so continuous
+        return image;
+    }
+};
+
 } // namespace pipeline
 
 #endif // HAVE_OPENCV_CORE
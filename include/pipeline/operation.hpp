@@ -0,0 +1,89 @@
+#pragma once
+
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace pipeline {
+
+namespace detail {
+
+/**
+ * @brief Prefix every backslash and every character of `special` in text with a backslash,
+ * so fields joined with those characters as delimiters cannot collide.
+ */
+inline std::string escapeField(std::string_view text, std::string_view special) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        if (c == '\\' || special.find(c) != std::string_view::npos) escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+/**
+ * @brief Write one operation parameter; floating-point values keep every significant digit.
+ */
+template <typename T>
+std::string formatParam(const T& value) {
+    std::ostringstream out;
+    if constexpr (std::is_floating_point_v<T>) out << std::setprecision(std::numeric_limits<T>::max_digits10);
+    out << value;
+    return out.str();
+}
+
+} // namespace detail
+
+/**
+ * @brief An image operation with a stable identity, so its results can be memoized
+ * (see Pipeline::process(key, const Operation&) and Pipeline::setResultCache).
+ *
+ * Two operations with the same id and params must compute the same result: change the id
+ * (e.g. "blur@2") when the implementation changes, and put every parameter that affects
+ * the output into params.
+ *
+ * @tparam ImageType The image type processed.
+ */
+template <typename ImageType>
+struct Operation {
+    std::string id;     ///< Stable name of the operation, e.g. "gaussianBlur".
+    std::string params; ///< Serialized parameters, e.g. "5,1.5".
+    std::function<ImageType(const ImageType&)> fn; ///< The operation itself.
+
+    /**
+     * @brief Build an operation whose params are the given values written with operator<<, comma separated.
+     *
+     * Floating-point values are written with max_digits10 digits, so values that differ only
+     * past the default precision get different params. Commas and backslashes inside a value
+     * are escaped with a backslash.
+     *
+     * @param id Stable name of the operation.
+     * @param fn The operation.
+     * @param params Parameter values, e.g. Operation<cv::Mat>::make("blur", blurFn, 5, 1.5).
+     */
+    template <typename Fn, typename... Params>
+    static Operation make(std::string id, Fn&& fn, const Params&... params) {
+        std::string joined;
+        [[maybe_unused]] const char* separator = ""; // Unused when there are no params
+        ((joined += separator, joined += detail::escapeField(detail::formatParam(params), ","), separator = ","), ...);
+        return Operation{std::move(id), std::move(joined), std::forward<Fn>(fn)};
+    }
+
+    /**
+     * @brief Identity of the operation: id and params, e.g. "gaussianBlur(5,1.5)".
+     *
+     * Parentheses, ';', '|' and backslashes inside id and params are escaped, so signatures
+     * joined into a chain (see Pipeline::process) decode unambiguously.
+     */
+    std::string signature() const {
+        return detail::escapeField(id, "();|") + "(" + detail::escapeField(params, "();|") + ")";
+    }
+};
+
+} // namespace pipeline
@@ -0,0 +1,221 @@
+#pragma once
+
+#ifdef HAVE_OPENCV_CORE
+
+#include "pipeline/pipeline.hpp"
+#include "pipeline/mapped_file.hpp"
+#include "pipeline/opencv_specializations.hpp"
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pipeline {
+
+/**
+ * @brief pixlink pack: a single file of decoded cv::Mat pixel buffers for fast reloads.
+ * 
+ * Layout (native byte order):
+ * - 64-byte header: magic "PIXPACK1", version, entry count, index offset and size.
+ * - Pixel buffers, each contiguous and starting on a 4096-byte boundary, so a mapping of
+ *   the file yields page-aligned image data.
+ * - Index: per entry, key length + key, rows, cols, OpenCV type, offset and byte size.
+ */
+namespace pack {
+
+constexpr char kMagic[8] = {'P', 'I', 'X', 'P', 'A', 'C', 'K', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kAlignment = 4096;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t indexOffset;
+    uint64_t indexSize;
+    char reserved[32];
+};
+static_assert(sizeof(Header) == 64, "pack header must be 64 bytes");
+
+struct IndexEntry {
+    int32_t rows;
+    int32_t cols;
+    int32_t type;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+} // namespace pack
+
+/**
+ * @brief Write images into a pack file.
+ * 
+ * Keys are written in sorted order. Only 2D images are supported.
+ * 
+ * @param path Output pack file path.
+ * @param images Map of key to image (e.g. Pipeline::getWorkingMap()).
+ * @throws std::runtime_error on I/O failure or unsupported image.
+ */
+inline void writePack(const std::string& path, const std::unordered_map<std::string, cv::Mat>& images) {
+    std::vector<std::string> keys;
+    for (const auto& [key, _] : images) keys.push_back(key);
+    std::sort(keys.begin(), keys.end());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("Failed to create pack: " + path);
+    pack::Header header{};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<char> padding(pack::kAlignment, 0);
+    std::vector<char> index;
+    uint64_t offset = sizeof(header);
+    for (const auto& key : keys) {
+        const cv::Mat& image = images.at(key);
+        if (image.dims != 2) throw std::runtime_error("Pack supports 2D images only: " + key);
+        uint64_t aligned = (offset + pack::kAlignment - 1) / pack::kAlignment * pack::kAlignment;
+        out.write(padding.data(), static_cast<std::streamsize>(aligned - offset));
+        const size_t rowBytes = image.cols * image.elemSize();
+        for (int r = 0; r < image.rows; ++r)
+            out.write(reinterpret_cast<const char*>(image.ptr(r)), static_cast<std::streamsize>(rowBytes));
+
+        pack::IndexEntry entry{image.rows, image.cols, image.type(), 0, aligned, rowBytes * image.rows};
+        uint32_t keyLength = static_cast<uint32_t>(key.size());
+        index.insert(index.end(), reinterpret_cast<const char*>(&keyLength), reinterpret_cast<const char*>(&keyLength) + sizeof(keyLength));
+        index.insert(index.end(), key.begin(), key.end());
+        index.insert(index.end(), reinterpret_cast<const char*>(&entry), reinterpret_cast<const char*>(&entry) + sizeof(entry));
+        offset = aligned + entry.size;
+    }
+    out.write(index.data(), static_cast<std::streamsize>(index.size()));
+
+    std::memcpy(header.magic, pack::kMagic, sizeof(header.magic));
+    header.version = pack::kVersion;
+    header.count = static_cast<uint32_t>(keys.size());
+    header.indexOffset = offset;
+    header.indexSize = index.size();
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!out.flush()) throw std::runtime_error("Failed to write pack: " + path);
+}
+
+/**
+ * @brief Write a pipeline's working set into a pack file.
+ * 
+ * Reads the images through Pipeline::getImage, so the pipeline keeps passthrough and
+ * memoization (getWorkingMap would turn them off).
+ * 
+ * @param pipeline Pipeline whose working set is written (lazily registered images are decoded).
+ * @param path Output pack file path.
+ */
+inline void writePack(Pipeline<cv::Mat>& pipeline, const std::string& path) {
+    std::unordered_map<std::string, cv::Mat> images; // Headers sharing the working images' pixels
+    for (const auto& key : pipeline.getAllImageKeys()) images.emplace(key, pipeline.getImage(key));
+    writePack(path, images);
+}
+
+/**
+ * @brief Zero-copy reader for pack files.
+ * 
+ * The file is mapped private copy-on-write; get() returns cv::Mat headers pointing into the
+ * mapping, so nothing is copied until a page is written. The returned headers do not own
+ * their data: the reader must outlive every image obtained from it (clone() to detach).
+ */
+class PackReader {
+public:
+    /**
+     * @brief Map a pack file and parse its index.
+     * 
+     * @param path Pack file path.
+     * @throws std::runtime_error if the file cannot be mapped or is not a valid pack.
+     */
+    explicit PackReader(const std::string& path)
+        : mapping_(std::make_unique<MappedFile>(path, false, true)) {
+        if (!mapping_->valid()) throw std::runtime_error("Failed to map pack: " + path);
+        const size_t size = mapping_->size();
+        if (size < sizeof(pack::Header)) throw std::runtime_error("Not a pack file: " + path);
+        pack::Header header;
+        std::memcpy(&header, mapping_->data(), sizeof(header));
+        if (std::memcmp(header.magic, pack::kMagic, sizeof(header.magic)) != 0 || header.version != pack::kVersion)
+            throw std::runtime_error("Not a pack file: " + path);
+        if (header.indexOffset > size || header.indexSize > size - header.indexOffset)
+            throw std::runtime_error("Corrupt pack index: " + path);
+
+        const unsigned char* p = mapping_->data() + header.indexOffset;
+        const unsigned char* end = p + header.indexSize;
+        for (uint32_t i = 0; i < header.count; ++i) {
+            uint32_t keyLength;
+            if (end - p < static_cast<std::ptrdiff_t>(sizeof(keyLength))) throw std::runtime_error("Corrupt pack index: " + path);
+            std::memcpy(&keyLength, p, sizeof(keyLength));
+            p += sizeof(keyLength);
+            if (end - p < static_cast<std::ptrdiff_t>(keyLength + sizeof(pack::IndexEntry))) throw std::runtime_error("Corrupt pack index: " + path);
+            std::string key(reinterpret_cast<const char*>(p), keyLength);
+            p += keyLength;
+            pack::IndexEntry entry;
+            std::memcpy(&entry, p, sizeof(entry));
+            p += sizeof(entry);
+            if (entry.offset > size || entry.size > size - entry.offset) throw std::runtime_error("Corrupt pack entry: " + key);
+            std::optional<size_t> pixels = detail::rawMatBytes(entry.rows, entry.cols, entry.type);
+            if (!pixels || *pixels != entry.size) throw std::runtime_error("Corrupt pack entry: " + key);
+            keys_.push_back(key);
+            index_.emplace(std::move(key), entry);
+        }
+    }
+
+    /**
+     * @brief Keys stored in the pack, in file order.
+     */
+    const std::vector<std::string>& keys() const { return keys_; }
+
+    /**
+     * @brief Check if the pack contains a key.
+     */
+    bool contains(const std::string& key) const { return index_.count(key) > 0; }
+
+    /**
+     * @brief Get an image as a header over the mapped pixels (no copy).
+     * 
+     * @param key Key of the image.
+     * @return cv::Mat Image header valid while this reader lives.
+     * @throws std::runtime_error if the key is not in the pack.
+     */
+    cv::Mat get(const std::string& key) const {
+        auto it = index_.find(key);
+        if (it == index_.end()) throw std::runtime_error("Key not found in pack: " + key);
+        const pack::IndexEntry& entry = it->second;
+        return cv::Mat(entry.rows, entry.cols, entry.type, mapping_->data() + entry.offset);
+    }
+
+private:
+    std::unique_ptr<MappedFile> mapping_;
+    std::vector<std::string> keys_;
+    std::unordered_map<std::string, pack::IndexEntry> index_;
+};
+
+/**
+ * @brief Load every image of a pack into a pipeline's working set and cache.
+ * 
+ * With DefaultCacheManager the images stay zero-copy headers into the pack's mapping;
+ * caches that deep-copy (e.g. LRUCacheManager::getCached) copy them.
+ * 
+ * @param pipeline Pipeline to load into.
+ * @param reader Pack to read; must outlive the pipeline's use of the images.
+ * @param relativeDir Optional key prefix filter (e.g. "people/").
+ */
+inline void loadPack(Pipeline<cv::Mat>& pipeline, const PackReader& reader, const std::string& relativeDir = "") {
+    std::string prefix = relativeDir;
+    if (!prefix.empty() && prefix.back() != '/') prefix += '/';
+    for (const auto& key : reader.keys())
+        if (prefix.empty() || key.rfind(prefix, 0) == 0)
+            pipeline.load(reader.get(key), key);
+}
+
+} // namespace pipeline
+
+#endif // HAVE_OPENCV_CORE
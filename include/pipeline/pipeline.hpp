@@ -2,6 +2,13 @@
 
 #include "pipeline/strategy.hpp"
 #include "pipeline/strategy_default.hpp"
+#include "pipeline/batch_report.hpp"
+#include "pipeline/thread_pool.hpp"
+#include "pipeline/read_ahead.hpp"
+#include "pipeline/batch_reader.hpp"
+#include "pipeline/file_copy.hpp"
+#include "pipeline/operation.hpp"
+#include "pipeline/image_traits.hpp"
 
 #include <memory>
 #include <vector>
@@ -10,7 +17,11 @@
 #include <filesystem>
 #include <functional>
 #include <algorithm>
+#include <chrono>
 #include <stdexcept>
+#include <mutex>
+#include <optional>
+#include <unordered_set>
 
 namespace pipeline {
 
@@ -27,10 +38,28 @@ inline std::string appendSuffix(const std::string& key, const std::string& suffi
     return (parent / newName).string();
 }
 
+/**
+ * @brief How loadDirectory brings images into the working set.
+ */
+enum class LoadMode {
+    Eager, ///< Decode every file immediately (default).
+    Lazy   ///< Only register keys and paths; decode on first access.
+};
+
 template <typename ImageType>
 class Pipeline {
 public:
     using ImageMap = std::unordered_map<std::string, ImageType>;
+    using Recipe = std::function<void(Pipeline&, const std::string&)>;
+
+    /**
+     * @brief Settings for stream().
+     */
+    struct StreamOptions {
+        size_t maxInFlightBytes = size_t(512) << 20; ///< Cap on decoded images waiting ahead of the recipe.
+        size_t decodeWorkers = 2;                    ///< Background decode threads.
+        std::function<bool(const std::string&, const ImageType&)> filter; ///< Optional: skip images it rejects.
+    };
 
     /**
      * @brief Construct a new Pipeline object.
@@ -77,10 +106,8 @@ public:
             throw std::runtime_error("File does not exist: " + fullPath.string());
         std::string key = path;
         if (workingMap.count(key)) return *this;
-        if (!cacheManager->isCached(key)) {
-            imageLoader->loadIntoCache(*cacheManager, fullPath.string(), key);
-        }
-        workingMap[key] = cacheManager->getCached(key);
+        pendingMap.erase(key);
+        loadIntoWorkingSet(key, fullPath.string());
         return *this;
     }
 
@@ -96,6 +123,9 @@ public:
         std::string key = name;
         imageLoader->loadIntoCache(*cacheManager, image, key);
         workingMap[key] = cacheManager->getCached(key);
+        pristineSources.erase(key);
+        chains.erase(key);
+        inMemoryKeys.insert(key);
         return *this;
     }
 
@@ -103,32 +133,166 @@ public:
      * @brief Recursively load all images from a directory (relative to inputFolder),
      * optionally filtering by allowed file extensions.
      * 
+     * With more than one load worker (see setLoadWorkers), files are decoded in parallel
+     * and per-file failures are collected into getLastReport() instead of aborting the batch.
+     * In LoadMode::Lazy (see setLoadMode), files are only registered and decoded on first access.
+     * 
      * @param directory Relative directory path to load images from.
      * @param extensions List of allowed file extensions (e.g., {".jpg", ".png"}). Defaults to {".jpg"}.
      * @return Reference to *this for chaining.
      */
     Pipeline& loadDirectory(const std::string& directory, const std::vector<std::string>& extensions = {".jpg"}) {
         std::filesystem::path base = std::filesystem::path(inputFolder) / directory;
+        if (loadMode == LoadMode::Lazy) {
+            registerDirectory(base, extensions);
+            return *this;
+        }
+        if (loadWorkers != 1) {
+            loadDirectoryParallel(base, extensions);
+            return *this;
+        }
         for (const auto& entry : std::filesystem::recursive_directory_iterator(base)) {
-            if (!entry.is_regular_file()) continue;
-            std::string ext = entry.path().extension().string();
-            if (!extensions.empty()) {
-                std::string lower_ext = ext;
-                std::transform(lower_ext.begin(), lower_ext.end(), lower_ext.begin(), ::tolower);
-                bool found = false;
-                for (const auto& allowed : extensions) {
-                    std::string lower_allowed = allowed;
-                    std::transform(lower_allowed.begin(), lower_allowed.end(), lower_allowed.begin(), ::tolower);
-                    if (lower_ext == lower_allowed) { found = true; break; }
-                }
-                if (!found) continue;
-            }
+            if (!entry.is_regular_file() || !hasAllowedExtension(entry.path(), extensions)) continue;
             std::string key = std::filesystem::relative(entry.path(), inputFolder).generic_string();
-            if (!cacheManager->isCached(key)) {
-                imageLoader->loadIntoCache(*cacheManager, entry.path().string(), key);
+            pendingMap.erase(key);
+            loadIntoWorkingSet(key, entry.path().string());
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Choose between eager and lazy directory loading.
+     * 
+     * In LoadMode::Lazy, loadDirectory only records keys and paths. An image is decoded on
+     * first access through process, filter, save/saveAs/saveAll or getWorkingMap, going
+     * through the cache, so images evicted from a bounded cache are transparently re-decoded.
+     * 
+     * @param mode Load mode for subsequent loadDirectory calls.
+     * @return Reference to *this for chaining.
+     */
+    Pipeline& setLoadMode(LoadMode mode) {
+        loadMode = mode;
+        return *this;
+    }
+
+    /**
+     * @brief Set the number of decode workers used by loadDirectory.
+     * 
+     * 1 (the default) loads serially and throws on the first failure.
+     * Any other value decodes in parallel; 0 uses the hardware concurrency.
+     * The loader's loadFromFile must be safe to call concurrently.
+     * 
+     * @param workers Number of decode workers.
+     * @return Reference to *this for chaining.
+     */
+    Pipeline& setLoadWorkers(size_t workers) {
+        loadWorkers = workers;
+        return *this;
+    }
+
+    /**
+     * @brief Read files in groups before handing them to the parallel decode workers.
+     * 
+     * Only used when loadDirectory runs with more than one load worker. The directory walker
+     * reads `batchSize` files at a time through a BatchFileReader and workers decode from
+     * memory with ImageLoader::loadFromBuffer, which the loader must support. 0 (the default)
+     * lets each worker read its own file.
+     * 
+     * @param batchSize Files per read batch, or 0 to disable.
+     * @param useIoUring Read batches through io_uring (Linux). Faster only for files not yet in
+     *        the page cache; see BatchFileReader.
+     * @return Reference to *this for chaining.
+     */
+    Pipeline& setBatchedReads(size_t batchSize, bool useIoUring = false) {
+        readBatchSize = batchSize;
+        readWithIoUring = useIoUring;
+        return *this;
+    }
+
+    /**
+     * @brief Get the report of the most recent batch operation (e.g. a parallel loadDirectory or saveAll).
+     * 
+     * @return const reference to the report.
+     */
+    const BatchReport& getLastReport() const { return lastReport; }
+
+    /**
+     * @brief Process a directory one image at a time with bounded memory.
+     * 
+     * For each matching file: load -> filter -> recipe (process/save/reset...) -> unload.
+     * Upcoming files that are not cached are decoded in the background, but never more than
+     * options.maxInFlightBytes ahead of the recipe, so a slow recipe (e.g. saving) throttles
+     * decoding instead of letting memory grow. Failures are collected into getLastReport();
+     * keys rejected by the filter appear in neither list.
+     * 
+     * Only what stream() adds is unloaded: an image already in the working set or the cache
+     * under the same key is left as it was (the recipe works on a copy of a cached one).
+     * 
+     * @param directory Relative directory path to stream images from.
+     * @param extensions List of allowed file extensions.
+     * @param recipe Called with the pipeline and the key of the loaded image.
+     * @param options Memory cap, decode workers and optional filter.
+     * @return Reference to *this for chaining.
+     */
+    Pipeline& stream(const std::string& directory, const std::vector<std::string>& extensions, Recipe recipe, const StreamOptions& options = {}) {
+        fs::path base = fs::path(inputFolder) / directory;
+        std::vector<std::string> keys;
+        std::vector<std::string> paths;
+        for (const auto& entry : fs::recursive_directory_iterator(base)) {
+            if (!entry.is_regular_file() || !hasAllowedExtension(entry.path(), extensions)) continue;
+            keys.push_back(fs::relative(entry.path(), inputFolder).generic_string());
+            paths.push_back(entry.path().string());
+        }
+
+        BatchReport report;
+        ReadAhead<ImageType> readAhead([this](const std::string& path) { return imageLoader->loadFromFile(path); },
+                                       options.maxInFlightBytes, options.decodeWorkers);
+        readAhead.schedule(uncachedPaths(keys, paths));
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const std::string& key = keys[i];
+            WorkingEntry previous = takeWorkingEntry(key);
+            bool cachedBefore = cacheManager->isCached(key);
+            try {
+                if (!cachedBefore) {
+                    std::optional<ImageType> image = readAhead.take(paths[i]);
+                    imageLoader->loadIntoCache(*cacheManager, image ? *image : imageLoader->loadFromFile(paths[i]), key);
+                }
+                // Our own cache entry is removed below, so the working image may share its pixels
+                ImageType image = cachedBefore ? cacheManager->getCached(key) : cacheManager->getCachedShallow(key);
+                auto it = workingMap.insert_or_assign(key, std::move(image)).first;
+                markPristine(key, paths[i]);
+                if (!options.filter || options.filter(key, it->second)) {
+                    recipe(*this, key);
+                    report.succeeded.push_back(key);
+                }
+            } catch (const std::exception& e) {
+                report.failed.push_back({key, e.what()});
             }
-            workingMap[key] = cacheManager->getCached(key);
+            workingMap.erase(key);
+            pristineSources.erase(key);
+            chains.erase(key);
+            restoreWorkingEntry(key, std::move(previous));
+            if (!cachedBefore) cacheManager->remove(key);
         }
+        lastReport = std::move(report);
+        return *this;
+    }
+
+    /**
+     * @brief Announce the order in which images are about to be loaded or reset.
+     * 
+     * Forwarded to the loader as file paths; a prefetching loader (see PrefetchingImageLoader)
+     * decodes them ahead so that cache misses in load/reset find the image already decoded.
+     * 
+     * @param keys Image keys (relative to inputFolder) in expected access order.
+     * @return Reference to *this for chaining.
+     */
+    Pipeline& prefetch(const std::vector<std::string>& keys) {
+        std::vector<std::string> paths;
+        paths.reserve(keys.size());
+        for (const auto& key : keys)
+            paths.push_back((std::filesystem::path(inputFolder) / key).string());
+        imageLoader->prefetch(paths);
         return *this;
     }
 
@@ -148,16 +312,30 @@ public:
         for (const auto& [key, _] : workingMap)
             if (prefix.empty() || key.rfind(prefix, 0) == 0)
                 keys.push_back(key);
+        for (const auto& [key, _] : pendingMap)
+            if (prefix.empty() || key.rfind(prefix, 0) == 0)
+                keys.push_back(key);
         return keys;
     }
 
+    /**
+     * @brief Read-only access to an image of the working set, decoding it first if it is only registered.
+     * 
+     * Unlike getWorkingMap(), this does not give up passthrough or memoization.
+     * 
+     * @param key Key of the image.
+     * @return Reference to the image, valid until the image is next changed or unloaded.
+     * @throws std::runtime_error if image key not found in working set.
+     */
+    const ImageType& getImage(const std::string& key) { return acquire(key)->second; }
+
     /**
      * @brief Check if the working set of loaded images is empty.
      * 
      * @return true if no images are loaded in working set.
      * @return false otherwise.
      */
-    bool isWorkingMapEmpty() const { return workingMap.empty(); }
+    bool isWorkingMapEmpty() const { return workingMap.empty() && pendingMap.empty(); }
 
     /**
      * @brief Check if the cache is empty (no images cached).
@@ -167,6 +345,26 @@ public:
      */
     bool isCacheMapEmpty() const { return cacheManager->getKeys().empty(); }
 
+    /**
+     * @brief Snapshot of the cache's counters (hits, misses, evictions, bytes, decode time saved).
+     * 
+     * @return All zeros if the cache manager is not instrumented.
+     */
+    CacheStatsSnapshot getCacheStats() const { return cacheManager->stats(); }
+
+    /**
+     * @brief Read an image's size, channels and format from its file header, without decoding.
+     * 
+     * @param key Key of the image (relative to inputFolder); it does not need to be loaded.
+     * @return ImageInfo Header information.
+     * @throws std::runtime_error if the file header cannot be parsed.
+     */
+    ImageInfo probe(const std::string& key) const {
+        auto pending = pendingMap.find(key);
+        if (pending != pendingMap.end()) return imageLoader->probe(pending->second);
+        return imageLoader->probe((std::filesystem::path(inputFolder) / key).string());
+    }
+
     /**
      * @brief Get the path to the output folder where images are saved.
      * 
@@ -186,42 +384,234 @@ public:
      * @throws std::runtime_error if image key not found in working set.
      */
     Pipeline& process(const std::string& key, std::function<ImageType(const ImageType&)> op) {
-        auto it = assertInWorkingMap(key);
+        auto it = acquire(key);
         it->second = op(it->second);
+        pristineSources.erase(key);
+        chains.erase(key);
         return *this;
     }
 
+    /**
+     * @brief Apply an operation with a stable identity, reusing a memoized result if possible.
+     * 
+     * With a result cache (see setResultCache), the pipeline tracks the chain of operations
+     * applied to each image since it was loaded from its file. If the same chain has already
+     * produced a result for this key, that result is taken from the result cache instead of
+     * running op.fn; otherwise the new result is stored there. Re-running a recipe whose last
+     * step changed thus only recomputes that step.
+     * 
+     * Images loaded from memory, changed by a plain process() call or markModified, and all
+     * images once getWorkingMap() has been called, run op.fn without memoization.
+     * 
+     * @param key Key of the image to process.
+     * @param op Operation to apply.
+     * @return Reference to *this for chaining.
+     * @throws std::runtime_error if image key not found in working set.
+     */
+    Pipeline& process(const std::string& key, const Operation<ImageType>& op) {
+        auto it = acquire(key);
+        std::optional<std::string> chain = chainOf(key);
+        pristineSources.erase(key);
+        if (!chain) {
+            it->second = op.fn(it->second);
+            chains.erase(key);
+            return *this;
+        }
+        std::string next = *chain + op.signature() + ";";
+        std::string resultKey = detail::escapeField(key, "|") + "|" + next;
+        if (resultCache->isCached(resultKey)) {
+            it->second = resultCache->getCached(resultKey);
+        } else {
+            it->second = op.fn(it->second);
+            resultCache->cacheImage(resultKey, it->second.clone()); // Later in-place edits must not reach the cache
+        }
+        chains[key] = std::move(next);
+        return *this;
+    }
+
+    /**
+     * @brief Memoize process(key, Operation) results in the given cache (nullptr disables memoization).
+     * 
+     * Results are cached under "<key>|<op signatures>", so any CacheManager works; bound it
+     * (e.g. LRUCacheManager with a ByteBudget) as intermediate results can be numerous.
+     * 
+     * @param cache Cache for operation results.
+     * @return Reference to *this for chaining.
+     */
+    Pipeline& setResultCache(std::unique_ptr<CacheManager<ImageType>> cache) {
+        resultCache = std::move(cache);
+        chains.clear();
+        return *this;
+    }
+
+    /**
+     * @brief Snapshot of the result cache's counters (all zeros without a result cache).
+     */
+    CacheStatsSnapshot getResultCacheStats() const { return resultCache ? resultCache->stats() : CacheStatsSnapshot{}; }
+
+    /**
+     * @brief Record that an image was modified outside process() (e.g. in place through a
+     * reference), so passthrough no longer copies its source file (see setPassthrough).
+     * 
+     * @param key Key of the modified image.
+     * @return Reference to *this for chaining.
+     */
+    Pipeline& markModified(const std::string& key) {
+        pristineSources.erase(key);
+        chains.erase(key);
+        return *this;
+    }
+
+    /**
+     * @brief Keep only the images for which the predicate returns true.
+     * Lazily registered images are decoded through the cache for the test but stay unmaterialized.
+     * 
+     * @param pred Predicate receiving the key and the image.
+     * @return Reference to *this for chaining.
+     */
     Pipeline& filter(std::function<bool(const std::string&, const ImageType&)> pred) {
+        return filter(std::move(pred), DecodeOptions{});
+    }
+
+    /**
+     * @brief Keep only the images for which the predicate returns true, testing lazily
+     * registered images on a reduced-resolution decode.
+     * 
+     * The preview is decoded outside the cache and discarded; survivors stay registered and
+     * are decoded at full resolution on first access. Images already in the working set are
+     * tested as they are.
+     * 
+     * @param pred Predicate receiving the key and the (possibly reduced) image.
+     * @param preview Reduction used for registered images.
+     * @return Reference to *this for chaining.
+     */
+    Pipeline& filter(std::function<bool(const std::string&, const ImageType&)> pred, const DecodeOptions& preview) {
     for (auto it = workingMap.begin(); it != workingMap.end(); ) {
         if (!pred(it->first, it->second))
             it = workingMap.erase(it);
         else
             ++it;
     }
+    for (auto it = pendingMap.begin(); it != pendingMap.end(); ) {
+        bool keep = preview.isFullResolution()
+            ? pred(it->first, peek(it->first, it->second))
+            : pred(it->first, imageLoader->loadScaled(it->second, preview));
+        if (!keep)
+            it = pendingMap.erase(it);
+        else
+            ++it;
+    }
     return *this;
     }
 
+    /**
+     * @brief Keep only the images whose header information satisfies the predicate.
+     * No pixels are decoded, so lazily registered images that are rejected never get decoded.
+     * 
+     * Lazily registered images are described by their file header. Images already in the
+     * working set are described as they are now (ImageTraits::describe), so earlier processing
+     * such as a resize is taken into account; their format is the one their key's extension
+     * names, i.e. the format they would be saved in. Types that ImageTraits cannot describe
+     * fall back to the source file's header, and such images loaded from memory are kept.
+     * 
+     * @param pred Predicate receiving the key and the header information.
+     * @return Reference to *this for chaining.
+     * @throws std::runtime_error if a file header cannot be parsed.
+     */
+    Pipeline& filterByInfo(std::function<bool(const std::string&, const ImageInfo&)> pred) {
+        for (auto it = workingMap.begin(); it != workingMap.end(); ) {
+            std::optional<ImageInfo> info = ImageTraits<ImageType>::describe(it->second);
+            std::filesystem::path path = std::filesystem::path(inputFolder) / it->first;
+            if (info)
+                info->format = formatForExtension(it->first);
+            else if (std::filesystem::is_regular_file(path))
+                info = imageLoader->probe(path.string());
+            if (info && !pred(it->first, *info))
+                it = workingMap.erase(it);
+            else
+                ++it;
+        }
+        for (auto it = pendingMap.begin(); it != pendingMap.end(); ) {
+            if (!pred(it->first, imageLoader->probe(it->second)))
+                it = pendingMap.erase(it);
+            else
+                ++it;
+        }
+        return *this;
+    }
+
     // --- Saving images ---
 
+    /**
+     * @brief Attach encoder settings to an output subdirectory (relative to the output folder).
+     * Saves into that subdirectory, or any directory below it, use the profile unless a deeper
+     * subdirectory has its own or the save call passes one. An empty subdir sets the default.
+     * 
+     * @param subdir Output subdirectory, e.g. "people/preview".
+     * @param profile Encoder settings, e.g. EncodeProfile::fast().
+     * @return Reference to *this for chaining.
+     */
+    Pipeline& setProfile(const std::string& subdir, const EncodeProfile& profile) {
+        profiles[normalizeSubdir(subdir)] = profile;
+        return *this;
+    }
+
+    /**
+     * @brief Copy untouched input files instead of decoding and re-encoding them.
+     * 
+     * When enabled, saving an image that is unchanged since it was loaded from its file copies
+     * that file (reflink or copy_file_range where available), provided the output keeps the
+     * file's extension. Output is bit-identical, costs no encode, and lazily registered images
+     * are not even decoded. Encoder settings other than a format change are not applied to
+     * such images. Images count as changed after process() or markModified().
+     * 
+     * getWorkingMap() turns passthrough (and memoization, see setResultCache) off for the rest
+     * of this pipeline's life, even if this is called again: in-place edits through the map
+     * cannot be tracked. Read images through getImage() and getAllImageKeys() to keep them.
+     * 
+     * @param enabled true to enable passthrough. Off by default.
+     * @return Reference to *this for chaining.
+     */
+    Pipeline& setPassthrough(bool enabled) {
+        passthroughEnabled = enabled;
+        return *this;
+    }
+
     /**
      * @brief Save a loaded image to the output folder using its original key-based filename.
-     * If the key has no extension, ".jpg" is appended.
+     * If the key has no extension, ".jpg" is appended. Uses the profile set for its directory.
      * 
      * @param key Key of the image to save.
      * @return Reference to *this for chaining.
      * @throws std::runtime_error if image key not found in working set.
      */
     Pipeline& save(const std::string& key) {
-        auto it = assertInWorkingMap(key);
         std::filesystem::path p(key);
         std::string filename = p.extension().empty() ? (key + ".jpg") : key;
+        return save(key, profileFor(std::filesystem::path(filename).parent_path().generic_string()));
+    }
+
+    /**
+     * @brief Save a loaded image to the output folder with explicit encoder settings.
+     * If the key has no extension, ".jpg" is appended; the profile's format override replaces it.
+     * 
+     * @param key Key of the image to save.
+     * @param profile Encoder settings.
+     * @return Reference to *this for chaining.
+     * @throws std::runtime_error if image key not found in working set.
+     */
+    Pipeline& save(const std::string& key, const EncodeProfile& profile) {
+        std::filesystem::path p(key);
+        std::string filename = profile.applyFormat(p.extension().empty() ? (key + ".jpg") : key);
         std::filesystem::path outPath = std::filesystem::path(outputFolder) / filename;
-        imageSaver->save(outPath.string(), it->second);
+        if (!copyIfUnchanged(key, outPath.string()))
+            imageSaver->save(outPath.string(), acquire(key)->second, profile);
         return *this;
     }
 
     /**
      * @brief Save a loaded image to a custom output path relative to the output folder.
+     * Uses the profile set for its directory, without overriding the path's format.
      * 
      * @param key Key of the image to save.
      * @param outputPath Relative output path (including filename).
@@ -229,14 +619,15 @@ public:
      * @throws std::runtime_error if image key not found in working set.
      */
     Pipeline& save(const std::string& key, const std::string& outputPath) {
-        auto it = assertInWorkingMap(key);
         std::filesystem::path fullPath = std::filesystem::path(outputFolder) / outputPath;
-        imageSaver->save(fullPath.string(), it->second);
+        if (!copyIfUnchanged(key, fullPath.string()))
+            imageSaver->save(fullPath.string(), acquire(key)->second, profileFor(std::filesystem::path(outputPath).parent_path().generic_string()));
         return *this;
     }
 
     /**
      * @brief Save an image into a custom subdirectory inside the output folder, preserving original filename.
+     * Uses the profile set for the subdirectory.
      * 
      * @param key Key of the image to save.
      * @param customSubdir Subdirectory inside output folder.
@@ -244,8 +635,22 @@ public:
      * @throws std::runtime_error if image key not found in working set.
      */
     Pipeline& saveAs(const std::string& key, const std::string& customSubdir) {
-        auto it = assertInWorkingMap(key);
-        imageSaver->saveAs(it->second, outputFolder, customSubdir, key);
+        return saveAs(key, customSubdir, profileFor(customSubdir));
+    }
+
+    /**
+     * @brief Save an image into a custom subdirectory inside the output folder with explicit encoder settings.
+     * 
+     * @param key Key of the image to save.
+     * @param customSubdir Subdirectory inside output folder.
+     * @param profile Encoder settings.
+     * @return Reference to *this for chaining.
+     * @throws std::runtime_error if image key not found in working set.
+     */
+    Pipeline& saveAs(const std::string& key, const std::string& customSubdir, const EncodeProfile& profile) {
+        std::filesystem::path outPath = std::filesystem::path(outputFolder) / customSubdir / SaveTarget{customSubdir, "", profile}.filenameFor(key);
+        if (!copyIfUnchanged(key, outPath.string()))
+            imageSaver->saveAs(acquire(key)->second, outputFolder, customSubdir, key, profile);
         return *this;
     }
 
@@ -259,19 +664,111 @@ public:
      * @throws std::runtime_error if image key not found in working set.
      */
     Pipeline& saveAs(const std::string& key, const std::string& customSubdir, const std::string& newFilename) {
-        auto it = assertInWorkingMap(key);
-        std::string saveKey = pipeline::appendSuffix(key, newFilename);
-        imageSaver->saveAs(it->second, outputFolder, customSubdir, saveKey);
+        EncodeProfile profile = profileFor(customSubdir);
+        std::filesystem::path outPath = std::filesystem::path(outputFolder) / customSubdir / SaveTarget{customSubdir, newFilename, profile}.filenameFor(key);
+        if (!copyIfUnchanged(key, outPath.string())) {
+            std::string saveKey = pipeline::appendSuffix(key, newFilename);
+            imageSaver->saveAs(acquire(key)->second, outputFolder, customSubdir, saveKey, profile);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Save one image to several destinations, encoding each distinct format/profile once.
+     * Targets without a profile use the one set for their subdirectory (see setProfile).
+     * Results per output path (relative to the output folder) go to getLastReport().
+     * 
+     * @param key Key of the image to save.
+     * @param targets Destinations (subdirectory, filename suffix, optional profile).
+     * @return Reference to *this for chaining.
+     * @throws std::runtime_error if image key not found in working set.
+     */
+    Pipeline& saveFanOut(const std::string& key, const std::vector<SaveTarget>& targets) {
+        BatchReport copied;
+        std::vector<SaveTarget> resolved;
+        for (auto target : targets) {
+            if (!target.profile) target.profile = profileFor(target.subdir);
+            std::string relative = (std::filesystem::path(target.subdir) / target.filenameFor(key)).generic_string();
+            try {
+                if (copyIfUnchanged(key, (std::filesystem::path(outputFolder) / relative).string())) {
+                    copied.succeeded.push_back(relative);
+                    continue;
+                }
+            } catch (const std::exception& e) {
+                copied.failed.push_back({relative, e.what()});
+                continue;
+            }
+            resolved.push_back(std::move(target));
+        }
+        lastReport = resolved.empty() ? BatchReport{} : imageSaver->saveMany(acquire(key)->second, outputFolder, key, resolved);
+        mergeReport(lastReport, std::move(copied));
         return *this;
     }
 
     /**
      * @brief Save all loaded images currently in the working set to the output folder.
+     * Uses the default profile (see setProfile). Per-image failures are collected into getLastReport().
      * 
      * @return Reference to *this for chaining.
      */
     Pipeline& saveAll() {
-        imageSaver->saveAll(workingMap, outputFolder);
+        return saveAll(profileFor(""));
+    }
+
+    /**
+     * @brief Save all loaded images currently in the working set with explicit encoder settings.
+     * Per-image failures are collected into getLastReport().
+     * 
+     * @param profile Encoder settings.
+     * @return Reference to *this for chaining.
+     */
+    Pipeline& saveAll(const EncodeProfile& profile) {
+        // Copy untouched files first; lazily registered ones are then never decoded
+        BatchReport copied;
+        std::unordered_set<std::string> done;
+        if (passthroughActive()) {
+            std::vector<std::string> keys = getAllImageKeys();
+            for (const auto& key : keys) {
+                std::string filename = profile.applyFormat(std::filesystem::path(key).extension().empty() ? (key + ".jpg") : key);
+                try {
+                    if (!copyIfUnchanged(key, (std::filesystem::path(outputFolder) / filename).string())) continue;
+                    copied.succeeded.push_back(key);
+                } catch (const std::exception& e) {
+                    copied.failed.push_back({key, e.what()});
+                }
+                done.insert(key);
+            }
+        }
+        for (auto it = pendingMap.begin(); it != pendingMap.end(); ) {
+            if (done.count(it->first)) { ++it; continue; }
+            std::string key = it->first;
+            ++it;
+            try {
+                acquire(key);
+            } catch (const std::exception& e) {
+                copied.failed.push_back({key, e.what()}); // Undecodable input: the others are still saved
+            }
+        }
+        if (done.empty()) {
+            lastReport = imageSaver->saveAll(workingMap, outputFolder, profile);
+        } else {
+            ImageMap remaining;
+            for (const auto& [key, image] : workingMap)
+                if (!done.count(key)) remaining.emplace(key, image);
+            lastReport = imageSaver->saveAll(remaining, outputFolder, profile);
+        }
+        mergeReport(lastReport, std::move(copied));
+        return *this;
+    }
+
+    /**
+     * @brief Wait until all saves issued so far are written (see AsyncImageSaver).
+     * 
+     * @return Reference to *this for chaining.
+     * @throws The first error raised by a background save.
+     */
+    Pipeline& flush() {
+        imageSaver->flush();
         return *this;
     }
 
@@ -285,9 +782,11 @@ public:
      * @throws std::runtime_error if image key not found in working set.
      */
     Pipeline& unload(const std::string& key) {
-        auto it = assertInWorkingMap(key);
+        if (pendingMap.erase(key) == 0) workingMap.erase(assertInWorkingMap(key));
+        pristineSources.erase(key);
+        chains.erase(key);
+        inMemoryKeys.erase(key);
         cacheManager->remove(key);
-        workingMap.erase(it);
         return *this;
     }
 
@@ -298,6 +797,10 @@ public:
      */
     Pipeline& unloadAll() {
         workingMap.clear();
+        pendingMap.clear();
+        pristineSources.clear();
+        chains.clear();
+        inMemoryKeys.clear();
         cacheManager->clear();
         return *this;
     }
@@ -310,8 +813,9 @@ public:
      * @throws std::runtime_error if image key not found in working set.
      */
     Pipeline& release(const std::string& key) {
-        auto it = assertInWorkingMap(key);
-        workingMap.erase(it);
+        if (pendingMap.erase(key) == 0) workingMap.erase(assertInWorkingMap(key));
+        pristineSources.erase(key);
+        chains.erase(key);
         return *this;
     }
 
@@ -334,19 +838,293 @@ public:
      */
     Pipeline& clearCache() {
         cacheManager->clear();
+        inMemoryKeys.clear();
         return *this;
     }
 
-    // get workingMap
-    ImageMap& getWorkingMap() { return workingMap; }
+    // get workingMap, decoding any lazily registered images first. Permanently disables
+    // passthrough and memoization (see setPassthrough); prefer getImage for reading.
+    ImageMap& getWorkingMap() {
+        materializeAll();
+        workingMapShared = true; // callers may edit in place, which passthrough cannot see
+        return workingMap;
+    }
 
 private:
     std::string inputFolder;
     std::string outputFolder;
     ImageMap workingMap;
+    std::unordered_map<std::string, std::string> pendingMap; ///< Lazily registered key -> file path, not yet decoded
     std::unique_ptr<CacheManager<ImageType>> cacheManager;
     std::unique_ptr<ImageLoader<ImageType>> imageLoader;
     std::unique_ptr<ImageSaver<ImageType>> imageSaver;
+    size_t loadWorkers = 1;
+    size_t readBatchSize = 0;
+    bool readWithIoUring = false;
+    LoadMode loadMode = LoadMode::Eager;
+    BatchReport lastReport;
+    std::unordered_map<std::string, EncodeProfile> profiles; ///< Output subdirectory to encoder settings
+    std::unordered_map<std::string, std::string> pristineSources; ///< Working-set key -> source file, while unchanged since load
+    std::unordered_set<std::string> inMemoryKeys; ///< Keys cached from memory (no source file to copy)
+    bool passthroughEnabled = false;
+    bool workingMapShared = false;
+    std::unique_ptr<CacheManager<ImageType>> resultCache; ///< Memoized process(key, Operation) results, if enabled
+    std::unordered_map<std::string, std::string> chains; ///< Working-set key -> operations applied since load, while tracked
+
+    // Remember the file an image was just decoded from, unless its cache entry came from memory
+    void markPristine(const std::string& key, const std::string& path) {
+        if (!inMemoryKeys.count(key)) pristineSources[key] = path;
+        chains.erase(key);
+    }
+
+    // Operations applied to the image since it was decoded from its file ("" if none); nullopt if untracked
+    std::optional<std::string> chainOf(const std::string& key) const {
+        if (!resultCache || workingMapShared) return std::nullopt;
+        auto it = chains.find(key);
+        if (it != chains.end()) return it->second;
+        if (pristineSources.count(key)) return std::string();
+        return std::nullopt;
+    }
+
+    bool passthroughActive() const { return passthroughEnabled && !workingMapShared; }
+
+    // Paths whose key is not cached, so decoding ahead is not wasted on them. Checked through
+    // getKeys, as isCached would credit decode time the later lookup credits again.
+    std::vector<std::string> uncachedPaths(const std::vector<std::string>& keys, const std::vector<std::string>& paths) const {
+        std::vector<std::string> cachedKeys = cacheManager->getKeys();
+        std::unordered_set<std::string> cached(cachedKeys.begin(), cachedKeys.end());
+        std::vector<std::string> uncached;
+        for (size_t i = 0; i < keys.size(); ++i)
+            if (!cached.count(keys[i])) uncached.push_back(paths[i]);
+        return uncached;
+    }
+
+    // Copy the image's source file to outPath if passthrough applies; false if it must be encoded
+    bool copyIfUnchanged(const std::string& key, const std::string& outPath) {
+        if (!passthroughActive()) return false;
+        const std::string* source = nullptr;
+        auto pending = pendingMap.find(key);
+        if (pending != pendingMap.end() && !inMemoryKeys.count(key)) {
+            source = &pending->second;
+        } else if (workingMap.count(key)) {
+            auto pristine = pristineSources.find(key);
+            if (pristine != pristineSources.end()) source = &pristine->second;
+        }
+        if (!source || !sameExtension(*source, outPath)) return false;
+        std::filesystem::path parent = std::filesystem::path(outPath).parent_path();
+        if (!parent.empty()) std::filesystem::create_directories(parent);
+        copyFile(*source, outPath);
+        return true;
+    }
+
+    static bool sameExtension(const fs::path& a, const fs::path& b) {
+        std::string x = a.extension().string();
+        std::string y = b.extension().string();
+        std::transform(x.begin(), x.end(), x.begin(), ::tolower);
+        std::transform(y.begin(), y.end(), y.begin(), ::tolower);
+        return x == y;
+    }
+
+    static void mergeReport(BatchReport& into, BatchReport&& from) {
+        into.succeeded.insert(into.succeeded.end(), from.succeeded.begin(), from.succeeded.end());
+        into.failed.insert(into.failed.end(), from.failed.begin(), from.failed.end());
+    }
+
+    static std::string normalizeSubdir(const std::string& subdir) {
+        std::string s = std::filesystem::path(subdir).lexically_normal().generic_string();
+        while (!s.empty() && s.back() == '/') s.pop_back();
+        return s == "." ? std::string() : s;
+    }
+
+    // Profile of the deepest configured directory containing subdir; default settings if none
+    EncodeProfile profileFor(const std::string& subdir) const {
+        std::filesystem::path dir = normalizeSubdir(subdir);
+        for (;;) {
+            auto it = profiles.find(dir.generic_string());
+            if (it != profiles.end()) return it->second;
+            if (dir.empty()) return EncodeProfile{};
+            dir = dir.parent_path();
+        }
+    }
+
+    // Working-set state under one key, set aside while stream() uses the key
+    struct WorkingEntry {
+        std::optional<ImageType> image;
+        std::optional<std::string> pending;
+        std::optional<std::string> pristine;
+        std::optional<std::string> chain;
+    };
+
+    WorkingEntry takeWorkingEntry(const std::string& key) {
+        WorkingEntry entry;
+        if (auto it = workingMap.find(key); it != workingMap.end()) {
+            entry.image = std::move(it->second);
+            workingMap.erase(it);
+        }
+        if (auto it = pendingMap.find(key); it != pendingMap.end()) {
+            entry.pending = std::move(it->second);
+            pendingMap.erase(it);
+        }
+        if (auto it = pristineSources.find(key); it != pristineSources.end()) {
+            entry.pristine = std::move(it->second);
+            pristineSources.erase(it);
+        }
+        if (auto it = chains.find(key); it != chains.end()) {
+            entry.chain = std::move(it->second);
+            chains.erase(it);
+        }
+        return entry;
+    }
+
+    void restoreWorkingEntry(const std::string& key, WorkingEntry&& entry) {
+        if (entry.image) workingMap.insert_or_assign(key, std::move(*entry.image));
+        if (entry.pending) pendingMap[key] = std::move(*entry.pending);
+        if (entry.pristine) pristineSources[key] = std::move(*entry.pristine);
+        if (entry.chain) chains[key] = std::move(*entry.chain);
+    }
+
+    // Decode through the cache (if not cached yet) and put the image into the working set
+    typename ImageMap::iterator loadIntoWorkingSet(const std::string& key, const std::string& path) {
+        if (!cacheManager->isCached(key)) {
+            imageLoader->loadIntoCache(*cacheManager, path, key);
+        }
+        markPristine(key, path);
+        return workingMap.insert_or_assign(key, cacheManager->getCached(key)).first;
+    }
+
+    // Cached view of a registered image, decoding it if it was evicted or never loaded
+    ImageType peek(const std::string& key, const std::string& path) {
+        if (!cacheManager->isCached(key)) {
+            imageLoader->loadIntoCache(*cacheManager, path, key);
+        }
+        return cacheManager->getCachedShallow(key);
+    }
+
+    // Find an image in the working set, decoding it first if it is only registered
+    typename ImageMap::iterator acquire(const std::string& key) {
+        auto pending = pendingMap.find(key);
+        if (pending == pendingMap.end()) return assertInWorkingMap(key);
+        std::string path = std::move(pending->second);
+        pendingMap.erase(pending);
+        return loadIntoWorkingSet(key, path);
+    }
+
+    void materializeAll() {
+        while (!pendingMap.empty()) {
+            std::string key = pendingMap.begin()->first;
+            acquire(key);
+        }
+    }
+
+    // Register matching files in the working set without decoding them
+    void registerDirectory(const fs::path& base, const std::vector<std::string>& extensions) {
+        for (const auto& entry : fs::recursive_directory_iterator(base)) {
+            if (!entry.is_regular_file() || !hasAllowedExtension(entry.path(), extensions)) continue;
+            std::string key = fs::relative(entry.path(), inputFolder).generic_string();
+            if (!workingMap.count(key)) pendingMap[key] = entry.path().string();
+        }
+    }
+
+    // Case-insensitive extension check; an empty list accepts every file
+    static bool hasAllowedExtension(const fs::path& path, const std::vector<std::string>& extensions) {
+        if (extensions.empty()) return true;
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        for (const auto& allowed : extensions) {
+            std::string lowerAllowed = allowed;
+            std::transform(lowerAllowed.begin(), lowerAllowed.end(), lowerAllowed.begin(), ::tolower);
+            if (ext == lowerAllowed) return true;
+        }
+        return false;
+    }
+
+    // Walk the directory on this thread and decode on a bounded worker pool.
+    // With batched reads, the walker reads files in groups and workers decode from memory.
+    // Cache and working set are only touched under `mutex`, so the cache needs no locking of its own.
+    void loadDirectoryParallel(const fs::path& base, const std::vector<std::string>& extensions) {
+        std::mutex mutex;
+        BatchReport report;
+        const bool encodedCache = cacheManager->acceptsEncoded();
+        // Decode one file and publish it. `readBytes` yields the encoded file; `decodeFile`, if set,
+        // decodes straight from disk. Caches accepting encoded images receive the bytes.
+        auto ingest = [this, &mutex, &report, encodedCache](const std::string& key,
+                                                           const std::function<std::vector<unsigned char>()>& readBytes,
+                                                           const std::function<ImageType()>& decodeFile) {
+            try {
+                const bool fromBytes = encodedCache || !decodeFile;
+                std::vector<unsigned char> bytes;
+                if (fromBytes) bytes = readBytes();
+                auto start = std::chrono::steady_clock::now();
+                ImageType image = fromBytes ? imageLoader->loadFromBuffer(bytes) : decodeFile();
+                auto cost = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (encodedCache) {
+                    cacheManager->cacheEncoded(key, std::move(bytes));
+                    workingMap[key] = std::move(image);
+                } else {
+                    imageLoader->loadIntoCache(*cacheManager, image, key);
+                    cacheManager->noteDecodeCost(key, cost);
+                    workingMap[key] = cacheManager->getCached(key);
+                }
+                markPristine(key, (fs::path(inputFolder) / key).string());
+                report.succeeded.push_back(key);
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(mutex);
+                report.failed.push_back({key, e.what()});
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                report.failed.push_back({key, "unknown error"});
+            }
+        };
+        {
+            ThreadPool pool(loadWorkers, 4 * (loadWorkers == 0 ? ThreadPool::defaultConcurrency() : loadWorkers));
+            std::unique_ptr<BatchFileReader> reader;
+            if (readBatchSize > 0) reader = std::make_unique<BatchFileReader>(static_cast<unsigned>(readBatchSize), readWithIoUring);
+            std::vector<std::string> batchKeys;
+            std::vector<std::string> batchPaths;
+            auto flushBatch = [&] {
+                std::vector<FileBuffer> buffers = reader->read(batchPaths);
+                for (size_t i = 0; i < buffers.size(); ++i) {
+                    auto buffer = std::make_shared<FileBuffer>(std::move(buffers[i]));
+                    pool.submit([this, &ingest, key = batchKeys[i], buffer] {
+                        ingest(key, [&] {
+                            if (!buffer->ok()) throw std::runtime_error(buffer->error);
+                            return std::move(buffer->bytes);
+                        }, nullptr);
+                    });
+                }
+                batchKeys.clear();
+                batchPaths.clear();
+            };
+            for (const auto& entry : fs::recursive_directory_iterator(base)) {
+                if (!entry.is_regular_file() || !hasAllowedExtension(entry.path(), extensions)) continue;
+                std::string key = fs::relative(entry.path(), inputFolder).generic_string();
+                pendingMap.erase(key);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (cacheManager->isCached(key)) {
+                        workingMap[key] = cacheManager->getCached(key);
+                        markPristine(key, entry.path().string());
+                        report.succeeded.push_back(key);
+                        continue;
+                    }
+                }
+                if (reader) {
+                    batchKeys.push_back(key);
+                    batchPaths.push_back(entry.path().string());
+                    if (batchPaths.size() >= readBatchSize) flushBatch();
+                } else {
+                    pool.submit([this, &ingest, key, path = entry.path().string()] {
+                        ingest(key, [&] { return readFileBytes(path); },
+                                    [&] { return imageLoader->loadFromFile(path); });
+                    });
+                }
+            }
+            if (reader && !batchPaths.empty()) flushBatch();
+            pool.wait();
+        }
+        lastReport = std::move(report);
+    }
 
     // Check image exists in working map, throw if not found
     typename ImageMap::iterator assertInWorkingMap(const std::string& key) {
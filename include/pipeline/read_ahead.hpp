@@ -0,0 +1,204 @@
+#pragma once
+
+#include "pipeline/image_traits.hpp"
+#include "pipeline/thread_pool.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pipeline {
+
+/**
+ * @brief Decodes files ahead of a known access order on background threads.
+ *
+ * Given an order of file paths, decodes upcoming files so that take() finds them ready.
+ * Read-ahead depth is bounded by the bytes of decoded-but-not-taken images (sized with
+ * ImageTraits), not by a file count; in-flight decodes are charged at the running average size.
+ *
+ * @tparam ImageType The image type produced by the decode function.
+ */
+template <typename ImageType>
+class ReadAhead {
+public:
+    using DecodeFn = std::function<ImageType(const std::string&)>;
+
+    /**
+     * @brief Construct a read-ahead stage.
+     *
+     * @param decode Function decoding a file path into an image. Called from worker threads.
+     * @param maxBytes Budget for decoded images waiting to be taken.
+     * @param workers Number of decode threads.
+     */
+    ReadAhead(DecodeFn decode, size_t maxBytes, size_t workers = 2)
+        : decode_(std::move(decode)), maxBytes_(maxBytes), pool_(workers) {}
+
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+
+    /**
+     * @brief Replace the access order and start decoding its head.
+     *
+     * Images staged for a previous order are dropped.
+     *
+     * @param paths File paths in the order they will be requested.
+     */
+    void schedule(const std::vector<std::string>& paths) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+        for (auto it = slots_.begin(); it != slots_.end(); ) {
+            if (it->second.ready) {
+                stagedBytes_ -= it->second.bytes;
+                it = slots_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        order_.clear();
+        position_.clear();
+        for (const auto& path : paths) {
+            position_.emplace(normalize(path), order_.size());
+            order_.push_back(normalize(path));
+        }
+        next_ = 0;
+        topUp();
+    }
+
+    /**
+     * @brief Take a decoded image out of the stage.
+     *
+     * Waits if the file is currently being decoded. Staged images that come before
+     * `path` in the order are considered skipped and dropped.
+     *
+     * @param path File path to take.
+     * @return The decoded image, or std::nullopt if the file was not read ahead.
+     * @throws Whatever the decode function threw for this file.
+     */
+    std::optional<ImageType> take(const std::string& path) {
+        std::string normalized = normalize(path);
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto pos = position_.find(normalized);
+        if (pos != position_.end()) {
+            dropBefore(pos->second);
+            if (next_ <= pos->second && !slots_.count(normalized)) next_ = pos->second + 1;
+        }
+        auto it = slots_.find(normalized);
+        if (it == slots_.end()) {
+            topUp();
+            return std::nullopt;
+        }
+        slotReady_.wait(lock, [&] {
+            it = slots_.find(normalized);
+            return it == slots_.end() || it->second.ready;
+        });
+        if (it == slots_.end()) return std::nullopt;
+        Slot slot = std::move(it->second);
+        slots_.erase(it);
+        stagedBytes_ -= slot.bytes;
+        topUp();
+        if (slot.error) std::rethrow_exception(slot.error);
+        return std::move(slot.image);
+    }
+
+    /**
+     * @brief Bytes of decoded images currently waiting to be taken.
+     */
+    size_t stagedBytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stagedBytes_;
+    }
+
+private:
+    struct Slot {
+        bool ready = false;
+        std::optional<ImageType> image;
+        std::exception_ptr error;
+        size_t bytes = 0;
+        size_t generation = 0;
+    };
+
+    static std::string normalize(const std::string& path) {
+        return std::filesystem::path(path).lexically_normal().string();
+    }
+
+    size_t averageBytes() const { return decodedCount_ ? decodedBytes_ / decodedCount_ : 0; }
+
+    // Drop ready slots the consumer has already moved past. Caller holds mutex_.
+    void dropBefore(size_t position) {
+        for (auto it = slots_.begin(); it != slots_.end(); ) {
+            auto pos = position_.find(it->first);
+            if (it->second.ready && pos != position_.end() && pos->second < position) {
+                stagedBytes_ -= it->second.bytes;
+                it = slots_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // Start decodes until the worker count or the byte budget is reached. Caller holds mutex_.
+    void topUp() {
+        while (next_ < order_.size() && inFlight_ < pool_.size()) {
+            bool idle = stagedBytes_ == 0 && inFlight_ == 0;
+            if (!idle && stagedBytes_ + (inFlight_ + 1) * averageBytes() > maxBytes_) break;
+            const std::string& path = order_[next_++];
+            if (slots_.count(path)) continue;
+            slots_[path].generation = generation_;
+            ++inFlight_;
+            pool_.submit([this, path] { run(path); });
+        }
+    }
+
+    void run(const std::string& path) {
+        std::optional<ImageType> image;
+        std::exception_ptr error;
+        try {
+            image = decode_(path);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        --inFlight_;
+        auto it = slots_.find(path);
+        if (it != slots_.end()) {
+            if (it->second.generation != generation_) {
+                slots_.erase(it);
+            } else {
+                it->second.ready = true;
+                it->second.error = error;
+                if (image) {
+                    it->second.bytes = ImageTraits<ImageType>::byteSize(*image);
+                    decodedBytes_ += it->second.bytes;
+                    ++decodedCount_;
+                    stagedBytes_ += it->second.bytes;
+                }
+                it->second.image = std::move(image);
+            }
+        }
+        topUp();
+        slotReady_.notify_all();
+    }
+
+    DecodeFn decode_;
+    size_t maxBytes_;
+    mutable std::mutex mutex_;
+    std::condition_variable slotReady_;
+    std::vector<std::string> order_;                   ///< Scheduled access order (normalized paths)
+    std::unordered_map<std::string, size_t> position_; ///< Path to index in order_
+    std::unordered_map<std::string, Slot> slots_;      ///< In-flight and ready decodes
+    size_t next_ = 0;                                  ///< Next index of order_ to decode
+    size_t inFlight_ = 0;
+    size_t stagedBytes_ = 0;
+    size_t decodedBytes_ = 0;
+    size_t decodedCount_ = 0;
+    size_t generation_ = 0;
+    ThreadPool pool_; ///< Declared last so workers are joined before the state above is destroyed
+};
+
+} // namespace pipeline
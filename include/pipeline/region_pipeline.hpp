@@ -2,6 +2,7 @@
 
 #include "pipeline/region_filter.hpp"
 #include "pipeline/faces_meta.hpp"
+#include "pipeline/image_traits.hpp"
 #include <unordered_map>
 #include <string>
 #include <functional>
@@ -26,6 +27,8 @@ public:
         if (it == workingMap.end()) throw std::runtime_error("Key not found: " + key);
 
         auto& img = it->second;
+        // Detach from snapshots (e.g. queued async saves) before writing in place
+        ImageTraits<ImageType>::makeExclusive(img);
 
         auto& meta = metaMap[key];
         if (!meta.regionsDetected) {
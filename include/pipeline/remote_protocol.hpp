@@ -0,0 +1,362 @@
+#pragma once
+
+#if defined(__unix__)
+#define PIPELINE_HAS_REMOTE 1
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace pipeline {
+
+/**
+ * @brief Wire protocol shared by RemoteCacheManager and the reference cache server.
+ *
+ * Every request and response is one frame: a 32-byte little-endian header followed by the
+ * key and the value bytes.
+ *
+ *     magic u32 | op u8 | status u8 | kind u8 | reserved u8 | id u32 | keyLen u32 | valueLen u64 | aux u64
+ *
+ * A connection carries any number of requests back to back without waiting (pipelining);
+ * the server answers them in order, echoing op and id. aux carries a decode cost in
+ * nanoseconds (Put, SetCost, and Get/Contains responses).
+ */
+namespace remote {
+
+constexpr uint32_t kMagic = 0x43525850u; // "PXRC"
+constexpr size_t kHeaderSize = 32;
+constexpr size_t kMaxKey = 4096;
+constexpr uint64_t kMaxValue = uint64_t(4) << 30;
+
+enum class Op : uint8_t {
+    Get = 1,      ///< Response value: the payload
+    Put = 2,      ///< Request value: the payload; aux: decode cost
+    Contains = 3, ///< No payload transferred
+    Remove = 4,
+    Clear = 5,
+    Keys = 6,     ///< Response value: u32 length-prefixed keys
+    Stats = 7,    ///< Response value: u64 insertions, evictions, residentBytes, peakBytes, hits, misses
+    SetCost = 8   ///< aux: decode cost of the key
+};
+
+enum class Status : uint8_t {
+    Ok = 0,
+    NotFound = 1,
+    Error = 2 ///< Response value: message
+};
+
+/**
+ * @brief How a payload encodes its image.
+ */
+enum class PayloadKind : uint8_t {
+    None = 0,
+    Raw = 1,    ///< ImageTraits::encodeRaw format: uncompressed pixels
+    Encoded = 2 ///< Image file contents (JPEG, PNG, ...)
+};
+
+/**
+ * @brief Malformed frame or unusable endpoint.
+ */
+struct ProtocolError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+struct Frame {
+    Op op = Op::Get;
+    Status status = Status::Ok;
+    PayloadKind kind = PayloadKind::None;
+    uint32_t id = 0;
+    uint64_t aux = 0;
+    std::string key;
+    std::vector<unsigned char> value;
+};
+
+inline void putLE(unsigned char* out, uint64_t v, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) out[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+inline uint64_t getLE(const unsigned char* in, size_t bytes) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < bytes; ++i) v |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return v;
+}
+
+/**
+ * @brief Append a frame with the given key and value to a send buffer.
+ */
+inline void appendFrame(std::vector<unsigned char>& out, const Frame& header, const std::string& key,
+                        const unsigned char* value, size_t valueSize) {
+    size_t at = out.size();
+    out.resize(at + kHeaderSize + key.size() + valueSize);
+    unsigned char* h = out.data() + at;
+    putLE(h, kMagic, 4);
+    h[4] = static_cast<unsigned char>(header.op);
+    h[5] = static_cast<unsigned char>(header.status);
+    h[6] = static_cast<unsigned char>(header.kind);
+    h[7] = 0;
+    putLE(h + 8, header.id, 4);
+    putLE(h + 12, key.size(), 4);
+    putLE(h + 16, valueSize, 8);
+    putLE(h + 24, header.aux, 8);
+    std::memcpy(h + kHeaderSize, key.data(), key.size());
+    if (valueSize) std::memcpy(h + kHeaderSize + key.size(), value, valueSize);
+}
+
+inline void appendFrame(std::vector<unsigned char>& out, const Frame& frame) {
+    appendFrame(out, frame, frame.key, frame.value.data(), frame.value.size());
+}
+
+/**
+ * @brief Validate the frame header at the front of a receive buffer, as much of it as has arrived.
+ *
+ * Checked before anything is sized from the header, so garbage is rejected after 4 bytes.
+ *
+ * @param maxValue Largest value accepted (at most kMaxValue).
+ * @throws ProtocolError on a bad magic or oversized key/value.
+ */
+inline void checkHeader(const unsigned char* data, size_t size, uint64_t maxValue = kMaxValue) {
+    if (size >= 4 && getLE(data, 4) != kMagic) throw ProtocolError("Bad frame magic");
+    if (size < kHeaderSize) return;
+    if (getLE(data + 12, 4) > kMaxKey || getLE(data + 16, 8) > maxValue) throw ProtocolError("Frame too large");
+}
+
+/**
+ * @brief Parse one frame from the front of a receive buffer.
+ *
+ * @return Bytes consumed, or 0 if the buffer does not hold a whole frame yet.
+ * @throws ProtocolError on a bad magic or oversized key/value (see checkHeader).
+ */
+inline size_t parseFrame(const unsigned char* data, size_t size, Frame& frame, uint64_t maxValue = kMaxValue) {
+    checkHeader(data, size, maxValue);
+    if (size < kHeaderSize) return 0;
+    uint64_t keyLen = getLE(data + 12, 4);
+    uint64_t valueLen = getLE(data + 16, 8);
+    if (size - kHeaderSize < keyLen + valueLen) return 0;
+    frame.op = static_cast<Op>(data[4]);
+    frame.status = static_cast<Status>(data[5]);
+    frame.kind = static_cast<PayloadKind>(data[6]);
+    frame.id = static_cast<uint32_t>(getLE(data + 8, 4));
+    frame.aux = getLE(data + 24, 8);
+    const unsigned char* body = data + kHeaderSize;
+    frame.key.assign(reinterpret_cast<const char*>(body), keyLen);
+    frame.value.assign(body + keyLen, body + keyLen + valueLen);
+    return kHeaderSize + keyLen + valueLen;
+}
+
+/**
+ * @brief Size of the frame at the front of a buffer once its header has arrived (0 before).
+ * @throws ProtocolError if the header is invalid (see checkHeader).
+ */
+inline size_t frameSize(const unsigned char* data, size_t size, uint64_t maxValue = kMaxValue) {
+    checkHeader(data, size, maxValue);
+    if (size < kHeaderSize) return 0;
+    return kHeaderSize + getLE(data + 12, 4) + getLE(data + 16, 8);
+}
+
+/**
+ * @brief Where a cache server listens: "tcp://host:port", "host:port" or "unix:/path/to/socket".
+ */
+struct Endpoint {
+    bool local = false; ///< Unix domain socket
+    std::string host;   ///< Host name or address (TCP)
+    std::string port;   ///< Port (TCP)
+    std::string path;   ///< Socket path (Unix)
+
+    /**
+     * @throws ProtocolError if the address cannot be parsed.
+     */
+    static Endpoint parse(const std::string& address) {
+        Endpoint e;
+        std::string rest = address;
+        if (rest.rfind("unix:", 0) == 0) {
+            e.local = true;
+            e.path = rest.substr(5);
+            if (e.path.rfind("//", 0) == 0) e.path = e.path.substr(2);
+            if (e.path.empty() || e.path.size() >= sizeof(sockaddr_un{}.sun_path))
+                throw ProtocolError("Bad unix socket path: " + address);
+            return e;
+        }
+        if (rest.rfind("tcp://", 0) == 0) rest = rest.substr(6);
+        size_t colon = rest.rfind(':');
+        if (colon == std::string::npos || colon + 1 == rest.size()) throw ProtocolError("Missing port in cache address: " + address);
+        e.host = rest.substr(0, colon);
+        e.port = rest.substr(colon + 1);
+        if (e.host.size() > 2 && e.host.front() == '[' && e.host.back() == ']') e.host = e.host.substr(1, e.host.size() - 2);
+        return e;
+    }
+
+    std::string toString() const { return local ? "unix:" + path : host + ":" + port; }
+};
+
+/**
+ * @brief Owned socket descriptor.
+ */
+class Socket {
+public:
+    Socket() = default;
+    explicit Socket(int fd) : fd_(fd) {}
+    ~Socket() { close(); }
+
+    Socket(Socket&& other) noexcept : fd_(std::exchange(other.fd_, -1)) {}
+    Socket& operator=(Socket&& other) noexcept {
+        if (this != &other) {
+            close();
+            fd_ = std::exchange(other.fd_, -1);
+        }
+        return *this;
+    }
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+
+    int fd() const { return fd_; }
+    bool valid() const { return fd_ >= 0; }
+
+    void close() {
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+    }
+
+    /**
+     * @brief Connect to a server, giving up after timeout.
+     * @throws std::runtime_error if no address accepts the connection.
+     */
+    static Socket connect(const Endpoint& endpoint, std::chrono::milliseconds timeout) {
+        if (endpoint.local) {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            std::memcpy(addr.sun_path, endpoint.path.c_str(), endpoint.path.size() + 1);
+            Socket s(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+            if (s.valid() && s.connectWithin(reinterpret_cast<sockaddr*>(&addr), sizeof(addr), timeout)) return s;
+        } else {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* found = nullptr;
+            if (::getaddrinfo(endpoint.host.c_str(), endpoint.port.c_str(), &hints, &found) == 0) {
+                for (addrinfo* a = found; a; a = a->ai_next) {
+                    Socket s(::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol));
+                    if (!s.valid() || !s.connectWithin(a->ai_addr, a->ai_addrlen, timeout)) continue;
+                    int one = 1;
+                    ::setsockopt(s.fd(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // Frames are already batched
+                    ::freeaddrinfo(found);
+                    return s;
+                }
+                ::freeaddrinfo(found);
+            }
+        }
+        throw std::runtime_error("Cannot connect to cache server " + endpoint.toString());
+    }
+
+    /**
+     * @brief Bind and listen (non-blocking), replacing a stale Unix socket file.
+     * @throws std::runtime_error on failure.
+     */
+    static Socket listen(const Endpoint& endpoint) {
+        Socket s;
+        int result = -1;
+        if (endpoint.local) {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            std::memcpy(addr.sun_path, endpoint.path.c_str(), endpoint.path.size() + 1);
+            ::unlink(endpoint.path.c_str());
+            s = Socket(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+            if (s.valid()) result = ::bind(s.fd(), reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        } else {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_flags = AI_PASSIVE;
+            addrinfo* found = nullptr;
+            const char* host = endpoint.host.empty() || endpoint.host == "*" ? nullptr : endpoint.host.c_str();
+            if (::getaddrinfo(host, endpoint.port.c_str(), &hints, &found) != 0)
+                throw std::runtime_error("Cannot resolve " + endpoint.toString());
+            for (addrinfo* a = found; a && result != 0; a = a->ai_next) {
+                s = Socket(::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol));
+                if (!s.valid()) continue;
+                int one = 1;
+                ::setsockopt(s.fd(), SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+                result = ::bind(s.fd(), a->ai_addr, a->ai_addrlen);
+            }
+            ::freeaddrinfo(found);
+        }
+        if (result != 0 || ::listen(s.fd(), 128) != 0)
+            throw std::runtime_error("Cannot listen on " + endpoint.toString() + ": " + std::strerror(errno));
+        s.setNonBlocking();
+        return s;
+    }
+
+    void setNonBlocking() { ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) | O_NONBLOCK); }
+
+    /**
+     * @brief Send the whole buffer, waiting at most timeout for the peer to drain each chunk.
+     * @return false on error, timeout or closed connection.
+     */
+    bool sendAll(const unsigned char* data, size_t size, std::chrono::milliseconds timeout) {
+        while (size > 0) {
+            if (!wait(POLLOUT, timeout)) return false;
+            ssize_t n = ::send(fd_, data, size, MSG_NOSIGNAL);
+            if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Append whatever has arrived (at least one byte) to buffer, waiting at most timeout.
+     * @return false on error, timeout or closed connection.
+     */
+    bool receiveSome(std::vector<unsigned char>& buffer, size_t atMost, std::chrono::milliseconds timeout) {
+        for (;;) {
+            if (!wait(POLLIN, timeout)) return false;
+            size_t at = buffer.size();
+            buffer.resize(at + atMost);
+            ssize_t n = ::recv(fd_, buffer.data() + at, atMost, 0);
+            buffer.resize(at + (n > 0 ? static_cast<size_t>(n) : 0));
+            if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+            return n > 0;
+        }
+    }
+
+private:
+    bool connectWithin(const sockaddr* addr, socklen_t length, std::chrono::milliseconds timeout) {
+        setNonBlocking();
+        if (::connect(fd_, addr, length) == 0) return true;
+        if (errno != EINPROGRESS || !wait(POLLOUT, timeout)) return false;
+        int error = 0;
+        socklen_t errorLength = sizeof(error);
+        return ::getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &errorLength) == 0 && error == 0;
+    }
+
+    bool wait(short events, std::chrono::milliseconds timeout) {
+        pollfd p{fd_, events, 0};
+        int n;
+        do {
+            n = ::poll(&p, 1, static_cast<int>(timeout.count()));
+        } while (n < 0 && errno == EINTR);
+        return n > 0;
+    }
+
+    int fd_ = -1;
+};
+
+} // namespace remote
+
+} // namespace pipeline
+
+#endif // __unix__
@@ -0,0 +1,864 @@
+#pragma once
+
+#if defined(__unix__)
+#define PIPELINE_HAS_SHM 1
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pipeline {
+
+/**
+ * @brief Geometry of a shared image store, used when the segment is created.
+ *
+ * Processes attaching to an existing segment use the geometry it was created with.
+ */
+struct SharedMemoryCacheOptions {
+    size_t dataBytes = size_t(1) << 30; ///< Bytes of pixel storage.
+    size_t maxEntries = 4096;           ///< Maximum images, including ones being written (the index has 4/3 as many slots).
+    bool unlinkOnDestroy = false;       ///< Remove the segment's name when this process detaches (e.g. in the supervisor).
+};
+
+/**
+ * @brief Layout of a shared image store segment (native byte order, same-host processes only).
+ *
+ * - Header: geometry, a robust process-shared mutex guarding everything below, slab size
+ *   classes with their free lists, the pool of space returned by size classes, and the
+ *   process lease table.
+ * - Index: open-addressing hash table of fixed-size entries, each with a per-process
+ *   reference count.
+ * - Data: page-aligned pixel blocks carved from size classes growing by 1.25x. Free blocks
+ *   hold the offset of the next free block of their class; pool extents hold a PoolExtent.
+ */
+namespace shm {
+
+constexpr uint32_t kMagic = 0x48535850u; // "PXSH"
+constexpr uint32_t kVersion = 4;
+constexpr size_t kMaxKey = 256;
+constexpr size_t kMaxProcesses = 64;
+constexpr size_t kMaxClasses = 64;
+constexpr uint64_t kPage = 4096;
+constexpr uint64_t kNone = ~uint64_t(0);
+
+enum EntryState : uint32_t {
+    kEmpty = 0,     ///< Never used: ends a probe sequence
+    kLive = 1,      ///< Visible to lookups
+    kFilling = 2,   ///< Block reserved, pixels being written by the process holding its reference
+    kZombie = 3,    ///< Removed while still referenced; freed when the last reference goes
+    kTombstone = 4  ///< Free slot inside a probe sequence
+};
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> ready;
+    uint32_t slotCount;
+    uint64_t segmentSize;
+    uint64_t indexOffset;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+    pthread_mutex_t mutex;
+    uint64_t clock;       ///< Access counter for LRU order
+    uint64_t bumpOffset;  ///< Data bytes ever carved into blocks
+    uint64_t usedBytes;   ///< Bytes of blocks in use
+    uint64_t peakBytes;
+    uint32_t classCount;
+    uint32_t dirty;       ///< Set while the lock owner changes the index or the allocator
+    uint64_t classSize[kMaxClasses];
+    uint64_t freeList[kMaxClasses]; ///< Offset of the first free block per class; each links to the next
+    int32_t leases[kMaxProcesses];  ///< pid holding each process slot, 0 if free
+    uint64_t leaseStarts[kMaxProcesses]; ///< Start time of each lease's process (0 if unknown), so a reused pid is not taken for it
+    uint64_t pool; ///< Offset of the first free extent not owned by a size class, in address order
+    uint32_t maxEntries; ///< Cap on occupied index slots, at most 3/4 of slotCount
+    uint32_t occupied;   ///< Index slots that are neither empty nor tombstones
+};
+
+/**
+ * @brief Free extent in the pool, stored at its own offset.
+ */
+struct PoolExtent {
+    uint64_t next;
+    uint64_t size;
+};
+
+struct Entry {
+    uint32_t state;
+    uint32_t keyLength;
+    uint64_t hash;
+    char key[kMaxKey];
+    int32_t rows;
+    int32_t cols;
+    int32_t type;
+    int32_t sizeClass;
+    uint64_t offset;
+    uint64_t bytes;
+    uint64_t lastUse;
+    int64_t decodeNanos;
+    uint32_t refs[kMaxProcesses]; ///< Live references per process slot
+};
+
+} // namespace shm
+
+/**
+ * @brief Pixel buffers shared between processes through a named POSIX shared-memory segment.
+ *
+ * Every process constructs its own store on the same name (after fork, not before); the first
+ * one creates and initializes the segment. Images are copied in once and read in place by all
+ * processes through a read-only mapping, so readers cannot corrupt the shared pixels.
+ *
+ * Crash safety: the index mutex is robust (a lock held by a dead process is recovered), and
+ * references are counted per process slot. A slot whose process no longer exists (checked by
+ * pid and, on Linux, process start time) is reclaimed, dropping its references, when a process
+ * attaches, when a dead lock owner is detected, and before allocation gives up. A lock owner
+ * that died while changing the index or the allocator may have left free lists or pool links
+ * half written; the next owner then rebuilds the allocator from the images still in the
+ * index, keeping those that are live or referenced by a live process and dropping the rest.
+ *
+ * Full size classes evict their least recently used unreferenced image. A class with nothing
+ * to evict (e.g. after the workload's image sizes changed) takes space from the others: their
+ * free blocks go back to a shared pool, where adjacent extents merge, and the least recently
+ * used images of any class are evicted into it until a large enough extent forms. Likewise,
+ * once maxEntries images are stored, each insert evicts the least recently used one, which
+ * also keeps the index at most 3/4 full so probe sequences stay short. Inserts that
+ * cannot be placed (key longer than 256 bytes, image larger than the store, everything
+ * referenced) are skipped: this is a cache.
+ */
+class SharedImageStore {
+public:
+    /**
+     * @brief Pixel layout of a stored image.
+     */
+    struct ImageInfo {
+        int32_t rows = 0;
+        int32_t cols = 0;
+        int32_t type = 0;   ///< Pixel type (e.g. an OpenCV type), opaque to the store.
+        uint64_t bytes = 0; ///< Size of the contiguous pixel data.
+    };
+
+    /**
+     * @brief A reference to a stored image, held until release(entry).
+     */
+    struct Lease {
+        uint32_t entry;
+        const unsigned char* data;
+        ImageInfo info;
+    };
+
+    /**
+     * @brief Attach to the named segment, creating it if it does not exist.
+     *
+     * @param name Segment name, e.g. "/pixlink-cache".
+     * @param options Geometry, used only when creating the segment.
+     * @throws std::runtime_error if the segment cannot be created, mapped or validated, or all
+     *         process slots are taken by live processes.
+     */
+    SharedImageStore(const std::string& name, const SharedMemoryCacheOptions& options = {})
+        : name_(name), unlinkOnDestroy_(options.unlinkOnDestroy) {
+        fd_ = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        bool creator = fd_ >= 0;
+        if (!creator) {
+            if (errno != EEXIST) throw std::runtime_error("Failed to create shared memory: " + name);
+            fd_ = ::shm_open(name.c_str(), O_RDWR, 0600);
+            if (fd_ < 0) throw std::runtime_error("Failed to open shared memory: " + name);
+        }
+        try {
+            if (creator) create(options);
+            else attach();
+            lockForUpdate();
+            slot_ = takeSlot();
+            unlock();
+        } catch (...) {
+            unmap();
+            if (creator) ::shm_unlink(name.c_str());
+            throw;
+        }
+    }
+
+    ~SharedImageStore() {
+        lockForUpdate();
+        reclaimSlot(slot_);
+        unlock();
+        unmap();
+        if (unlinkOnDestroy_) ::shm_unlink(name_.c_str());
+    }
+
+    SharedImageStore(const SharedImageStore&) = delete;
+    SharedImageStore& operator=(const SharedImageStore&) = delete;
+
+    /**
+     * @brief Remove a segment name; processes attached keep their mapping until they detach.
+     */
+    static void unlink(const std::string& name) { ::shm_unlink(name.c_str()); }
+
+    /**
+     * @brief Copy an image into the store, replacing any image under the same key.
+     *
+     * The block is reserved under the lock, filled without it, then published.
+     *
+     * @param key Image key.
+     * @param info Layout of the image.
+     * @param fill Writes exactly info.bytes bytes of pixels to the given address.
+     * @return false if the image could not be placed.
+     */
+    bool insert(const std::string& key, const ImageInfo& info, const std::function<void(unsigned char*)>& fill) {
+        if (key.size() > shm::kMaxKey) return false;
+        int sizeClass = classFor(info.bytes);
+        if (sizeClass < 0) return false;
+        uint64_t hash = hashKey(key);
+
+        uint32_t index;
+        uint64_t offset;
+        lockForUpdate();
+        if (auto existing = find(key, hash)) retire(*existing);
+        std::optional<uint64_t> block = reserveSlot() ? allocate(sizeClass) : std::nullopt;
+        if (!block && reclaimDeadSlots()) block = allocate(sizeClass);
+        std::optional<uint32_t> free = block ? insertSlot(hash) : std::nullopt;
+        if (!free) {
+            if (block) freeBlock(sizeClass, *block);
+            unlock();
+            return false;
+        }
+        index = *free;
+        offset = *block;
+        ++header_->occupied;
+        shm::Entry& entry = entries_[index];
+        std::memset(&entry, 0, sizeof(entry));
+        entry.state = shm::kFilling;
+        entry.keyLength = static_cast<uint32_t>(key.size());
+        entry.hash = hash;
+        std::memcpy(entry.key, key.data(), key.size());
+        entry.rows = info.rows;
+        entry.cols = info.cols;
+        entry.type = info.type;
+        entry.sizeClass = sizeClass;
+        entry.offset = offset;
+        entry.bytes = info.bytes;
+        entry.refs[slot_] = 1;
+        unlock();
+
+        try {
+            fill(writable_ + offset);
+        } catch (...) {
+            lockForUpdate();
+            entry.refs[slot_] = 0;
+            retire(index);
+            unlock();
+            throw;
+        }
+
+        lockForUpdate();
+        entry.refs[slot_] = 0;
+        if (auto concurrent = find(key, hash)) retire(*concurrent); // Another process stored the key meanwhile
+        entry.lastUse = ++header_->clock;
+        entry.state = shm::kLive;
+        unlock();
+        return true;
+    }
+
+    /**
+     * @brief Take a reference to an image and mark it as recently used.
+     * @return The lease, or std::nullopt if the key is not stored.
+     */
+    std::optional<Lease> acquire(const std::string& key) {
+        lock();
+        std::optional<uint32_t> index = find(key, hashKey(key));
+        if (!index) {
+            unlock();
+            return std::nullopt;
+        }
+        shm::Entry& entry = entries_[*index];
+        ++entry.refs[slot_];
+        entry.lastUse = ++header_->clock;
+        Lease lease{*index, readable_ + entry.offset, ImageInfo{entry.rows, entry.cols, entry.type, entry.bytes}};
+        unlock();
+        return lease;
+    }
+
+    /**
+     * @brief Drop a reference taken by acquire.
+     */
+    void release(uint32_t index) {
+        lockForUpdate();
+        shm::Entry& entry = entries_[index];
+        if (entry.refs[slot_] > 0) --entry.refs[slot_];
+        if (entry.state == shm::kZombie && unreferenced(entry)) retire(index);
+        unlock();
+    }
+
+    /**
+     * @brief Check if a key is stored, optionally reading its recorded decode cost.
+     */
+    bool contains(const std::string& key, std::chrono::nanoseconds* decodeCost = nullptr) const {
+        lock();
+        std::optional<uint32_t> index = find(key, hashKey(key));
+        if (index && decodeCost) *decodeCost = std::chrono::nanoseconds(entries_[*index].decodeNanos);
+        unlock();
+        return index.has_value();
+    }
+
+    /**
+     * @brief Record how long an image took to decode, for cache statistics in every process.
+     */
+    void setDecodeCost(const std::string& key, std::chrono::nanoseconds cost) {
+        lock();
+        if (auto index = find(key, hashKey(key))) entries_[*index].decodeNanos = cost.count();
+        unlock();
+    }
+
+    /**
+     * @brief Remove an image; its block is freed once no process references it.
+     */
+    void remove(const std::string& key) {
+        lockForUpdate();
+        if (auto index = find(key, hashKey(key))) retire(*index);
+        unlock();
+    }
+
+    /**
+     * @brief Remove every image.
+     */
+    void clear() {
+        lockForUpdate();
+        for (uint32_t i = 0; i < header_->slotCount; ++i)
+            if (entries_[i].state == shm::kLive) retire(i);
+        unlock();
+    }
+
+    /**
+     * @brief Keys of all stored images.
+     */
+    std::vector<std::string> keys() const {
+        std::vector<std::string> result;
+        lock();
+        for (uint32_t i = 0; i < header_->slotCount; ++i)
+            if (entries_[i].state == shm::kLive) result.emplace_back(entries_[i].key, entries_[i].keyLength);
+        unlock();
+        return result;
+    }
+
+    /**
+     * @brief Bytes of pixel blocks in use (rounded up to size classes).
+     */
+    size_t usedBytes() const {
+        lock();
+        size_t used = header_->usedBytes;
+        unlock();
+        return used;
+    }
+
+    /**
+     * @brief Highest value usedBytes() has reached, across all processes.
+     */
+    size_t peakBytes() const {
+        lock();
+        size_t peak = header_->peakBytes;
+        unlock();
+        return peak;
+    }
+
+    /**
+     * @brief Number of images evicted to make room since this process attached.
+     */
+    uint64_t evictions() const { return evictions_.load(std::memory_order_relaxed); }
+
+private:
+    static uint64_t hashKey(const std::string& key) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (unsigned char c : key) hash = (hash ^ c) * 0x100000001B3ull;
+        return hash;
+    }
+
+    static uint64_t roundToPage(uint64_t bytes) { return (bytes + shm::kPage - 1) / shm::kPage * shm::kPage; }
+
+    void create(const SharedMemoryCacheOptions& options) {
+        uint64_t maxEntries = std::clamp<uint64_t>(options.maxEntries, 1, uint64_t(3) << 30);
+        uint64_t slots = (maxEntries * 4 + 2) / 3;
+        uint64_t indexOffset = roundToPage(sizeof(shm::Header));
+        uint64_t dataOffset = roundToPage(indexOffset + slots * sizeof(shm::Entry));
+        uint64_t dataSize = roundToPage(std::max<size_t>(options.dataBytes, shm::kPage));
+        if (::ftruncate(fd_, static_cast<off_t>(dataOffset + dataSize)) != 0)
+            throw std::runtime_error("Failed to size shared memory: " + name_);
+        map(dataOffset + dataSize, dataOffset, dataSize);
+
+        header_ = new (base_) shm::Header{};
+        header_->magic = shm::kMagic;
+        header_->version = shm::kVersion;
+        header_->slotCount = static_cast<uint32_t>(slots);
+        header_->maxEntries = static_cast<uint32_t>(maxEntries);
+        header_->segmentSize = dataOffset + dataSize;
+        header_->indexOffset = indexOffset;
+        header_->dataOffset = dataOffset;
+        header_->dataSize = dataSize;
+        header_->pool = shm::kNone;
+        // Size classes from one page, growing by 1.25x, up to the whole data region
+        uint32_t classes = 0;
+        for (uint64_t size = shm::kPage; classes < shm::kMaxClasses; size = roundToPage(size + size / 4)) {
+            header_->classSize[classes] = std::min(size, dataSize);
+            header_->freeList[classes++] = shm::kNone;
+            if (size >= dataSize) break;
+        }
+        header_->classCount = classes;
+
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        int rc = pthread_mutex_init(&header_->mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
+        if (rc != 0) throw std::runtime_error("Failed to initialize shared memory lock: " + name_);
+        entries_ = reinterpret_cast<shm::Entry*>(base_ + indexOffset); // Zero-filled by ftruncate: all kEmpty
+        header_->ready.store(1, std::memory_order_release);
+    }
+
+    void attach() {
+        // The creator may still be sizing and initializing the segment
+        struct stat st;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (::fstat(fd_, &st) == 0 && st.st_size < static_cast<off_t>(sizeof(shm::Header))) {
+            if (std::chrono::steady_clock::now() > deadline) throw std::runtime_error("Shared memory was never initialized: " + name_);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        void* probe = ::mmap(nullptr, sizeof(shm::Header), PROT_READ, MAP_SHARED, fd_, 0);
+        if (probe == MAP_FAILED) throw std::runtime_error("Failed to map shared memory: " + name_);
+        const auto* header = static_cast<const shm::Header*>(probe);
+        while (header->ready.load(std::memory_order_acquire) != 1) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                ::munmap(probe, sizeof(shm::Header));
+                throw std::runtime_error("Shared memory was never initialized: " + name_);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        bool valid = header->magic == shm::kMagic && header->version == shm::kVersion;
+        uint64_t size = header->segmentSize, dataOffset = header->dataOffset, dataSize = header->dataSize;
+        ::munmap(probe, sizeof(shm::Header));
+        if (!valid) throw std::runtime_error("Not a pixlink shared cache: " + name_);
+        map(size, dataOffset, dataSize);
+        header_ = reinterpret_cast<shm::Header*>(base_);
+        entries_ = reinterpret_cast<shm::Entry*>(base_ + header_->indexOffset);
+    }
+
+    void map(uint64_t size, uint64_t dataOffset, uint64_t dataSize) {
+        void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (base == MAP_FAILED) throw std::runtime_error("Failed to map shared memory: " + name_);
+        base_ = static_cast<unsigned char*>(base);
+        size_ = size;
+        void* readable = ::mmap(nullptr, dataSize, PROT_READ, MAP_SHARED, fd_, static_cast<off_t>(dataOffset));
+        if (readable == MAP_FAILED) throw std::runtime_error("Failed to map shared memory: " + name_);
+        readable_ = static_cast<const unsigned char*>(readable);
+        writable_ = base_ + dataOffset;
+        dataSize_ = dataSize;
+    }
+
+    void unmap() {
+        if (readable_) ::munmap(const_cast<unsigned char*>(readable_), dataSize_);
+        if (base_) ::munmap(base_, size_);
+        if (fd_ >= 0) ::close(fd_);
+        readable_ = nullptr;
+        base_ = nullptr;
+        fd_ = -1;
+    }
+
+    void lock() const {
+        int rc = pthread_mutex_lock(&header_->mutex);
+        if (rc == EOWNERDEAD) {
+            // The previous owner died inside a critical section: take over and drop its references,
+            // rebuilding the allocator first if it died halfway through changing it
+            pthread_mutex_consistent(&header_->mutex);
+            auto* self = const_cast<SharedImageStore*>(this);
+            bool interrupted = header_->dirty != 0;
+            header_->dirty = 1;
+            if (interrupted) self->recover();
+            else self->reclaimDeadSlots();
+            header_->dirty = 0;
+        } else if (rc != 0) {
+            throw std::runtime_error("Failed to lock shared memory: " + name_);
+        }
+    }
+
+    // Lock for a critical section that changes the index or the allocator (see recover)
+    void lockForUpdate() {
+        lock();
+        header_->dirty = 1;
+    }
+
+    void unlock() const {
+        header_->dirty = 0;
+        pthread_mutex_unlock(&header_->mutex);
+    }
+
+    // Start time of a process in clock ticks since boot; 0 where it cannot be read
+    static uint64_t processStartTime(int32_t pid) {
+#if defined(__linux__)
+        std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+        std::string stat((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t commEnd = stat.rfind(')'); // The command name may contain spaces and parentheses
+        if (commEnd == std::string::npos) return 0;
+        std::istringstream fields(stat.substr(commEnd + 1));
+        std::string skipped;
+        for (int field = 3; field < 22 && fields >> skipped; ++field) {}
+        uint64_t start = 0;
+        fields >> start; // Field 22: starttime
+        return start;
+#else
+        (void)pid;
+        return 0;
+#endif
+    }
+
+    // A pid may be reused after its process exits: also compare the recorded start time
+    bool alive(size_t slot) const {
+        int32_t pid = header_->leases[slot];
+        if (pid <= 0 || (::kill(pid, 0) != 0 && errno == ESRCH)) return false;
+        uint64_t recorded = header_->leaseStarts[slot];
+        uint64_t current = recorded ? processStartTime(pid) : 0;
+        return recorded == 0 || current == 0 || current == recorded;
+    }
+
+    static bool unreferenced(const shm::Entry& entry) {
+        for (uint32_t refs : entry.refs)
+            if (refs != 0) return false;
+        return true;
+    }
+
+    uint32_t takeSlot() {
+        for (size_t i = 0; i < shm::kMaxProcesses; ++i) {
+            if (header_->leases[i] != 0 && alive(i)) continue;
+            reclaimSlot(i);
+            header_->leases[i] = static_cast<int32_t>(::getpid());
+            header_->leaseStarts[i] = processStartTime(header_->leases[i]);
+            return static_cast<uint32_t>(i);
+        }
+        throw std::runtime_error("No free process slot in shared memory: " + name_);
+    }
+
+    // Drop every reference held by a process slot and free what only it kept alive
+    void reclaimSlot(size_t slot) {
+        for (uint32_t i = 0; i < header_->slotCount; ++i) {
+            shm::Entry& entry = entries_[i];
+            if (entry.state == shm::kEmpty || entry.state == shm::kTombstone) continue;
+            entry.refs[slot] = 0;
+            if ((entry.state == shm::kZombie || entry.state == shm::kFilling) && unreferenced(entry)) retire(i);
+        }
+        header_->leases[slot] = 0;
+        header_->leaseStarts[slot] = 0;
+    }
+
+    bool reclaimDeadSlots() {
+        bool reclaimed = false;
+        for (size_t i = 0; i < shm::kMaxProcesses; ++i) {
+            if (i == slot_ || header_->leases[i] == 0 || alive(i)) continue;
+            reclaimSlot(i);
+            reclaimed = true;
+        }
+        return reclaimed;
+    }
+
+    // Rebuild the index and allocator after a lock owner died in the middle of changing them.
+    // Free lists and pool links cannot be trusted, so every block not held by a kept image goes
+    // back to the pool. Kept: live images, and images being written or removed that a live
+    // process still references. Slots of dead processes are released.
+    void recover() {
+        std::vector<size_t> dead;
+        for (size_t i = 0; i < shm::kMaxProcesses; ++i) {
+            if (i == slot_ || header_->leases[i] == 0 || alive(i)) continue;
+            dead.push_back(i);
+            header_->leases[i] = 0;
+            header_->leaseStarts[i] = 0;
+        }
+        std::vector<std::pair<uint64_t, uint32_t>> blocks; // Offset and index of each kept image
+        for (uint32_t i = 0; i < header_->slotCount; ++i) {
+            shm::Entry& entry = entries_[i];
+            if (entry.state == shm::kEmpty) continue;
+            for (size_t slot : dead) entry.refs[slot] = 0;
+            bool keep = entry.state == shm::kLive ||
+                        ((entry.state == shm::kFilling || entry.state == shm::kZombie) && !unreferenced(entry));
+            keep = keep && entry.sizeClass >= 0 && static_cast<uint32_t>(entry.sizeClass) < header_->classCount &&
+                   entry.offset % shm::kPage == 0 && entry.offset <= header_->dataSize &&
+                   header_->classSize[entry.sizeClass] <= header_->dataSize - entry.offset;
+            if (keep) blocks.emplace_back(entry.offset, i);
+            else entry.state = shm::kTombstone;
+        }
+        std::sort(blocks.begin(), blocks.end());
+
+        for (uint32_t c = 0; c < header_->classCount; ++c) header_->freeList[c] = shm::kNone;
+        header_->pool = shm::kNone;
+        header_->usedBytes = 0;
+        header_->occupied = 0;
+        uint64_t end = 0, previous = shm::kNone;
+        for (auto [offset, index] : blocks) {
+            if (offset < end) { // Overlaps a block kept already: the entry was half written
+                entries_[index].state = shm::kTombstone;
+                continue;
+            }
+            if (offset > end) {
+                writeExtent(end, {shm::kNone, offset - end});
+                linkExtent(previous, end);
+                previous = end;
+            }
+            uint64_t size = header_->classSize[entries_[index].sizeClass];
+            end = offset + size;
+            header_->usedBytes += size;
+            ++header_->occupied;
+        }
+        header_->bumpOffset = end;
+        header_->peakBytes = std::max(header_->peakBytes, header_->usedBytes);
+
+        // Tombstones directly before an empty slot end no probe sequence (see freeSlot)
+        uint32_t slots = header_->slotCount;
+        for (uint32_t i = 0; i < slots; ++i) {
+            if (entries_[i].state != shm::kEmpty) continue;
+            for (uint32_t n = 0, j = (i + slots - 1) % slots; n < slots && entries_[j].state == shm::kTombstone;
+                 ++n, j = (j + slots - 1) % slots)
+                entries_[j].state = shm::kEmpty;
+        }
+    }
+
+    int classFor(uint64_t bytes) const {
+        for (uint32_t c = 0; c < header_->classCount; ++c)
+            if (header_->classSize[c] >= bytes) return static_cast<int>(c);
+        return -1;
+    }
+
+    std::optional<uint32_t> find(const std::string& key, uint64_t hash) const {
+        uint32_t slots = header_->slotCount;
+        for (uint32_t n = 0, i = static_cast<uint32_t>(hash % slots); n < slots; ++n, i = (i + 1) % slots) {
+            const shm::Entry& entry = entries_[i];
+            if (entry.state == shm::kEmpty) break;
+            if (entry.state == shm::kLive && entry.hash == hash && entry.keyLength == key.size() &&
+                std::memcmp(entry.key, key.data(), key.size()) == 0)
+                return i;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<uint32_t> insertSlot(uint64_t hash) const {
+        uint32_t slots = header_->slotCount;
+        for (uint32_t n = 0, i = static_cast<uint32_t>(hash % slots); n < slots; ++n, i = (i + 1) % slots)
+            if (entries_[i].state == shm::kEmpty || entries_[i].state == shm::kTombstone) return i;
+        return std::nullopt;
+    }
+
+    // Bring the occupied index slots under maxEntries, evicting least recently used images;
+    // false if everything left is referenced
+    bool reserveSlot() {
+        while (header_->occupied >= header_->maxEntries) {
+            if (std::optional<uint32_t> victim = leastRecentlyUsed(-1)) {
+                retire(*victim);
+                evictions_.fetch_add(1, std::memory_order_relaxed);
+            } else if (!reclaimDeadSlots()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Block of the class: from its free list, the pool or fresh space, else idle blocks of other
+    // classes, else the class's least recently used image, else images of other classes
+    std::optional<uint64_t> allocate(int sizeClass) {
+        uint64_t size = header_->classSize[sizeClass];
+        std::optional<uint64_t> offset = popFree(sizeClass);
+        if (!offset) offset = carve(size);
+        if (!offset && returnIdleBlocks()) offset = carve(size);
+        if (!offset) {
+            if (std::optional<uint32_t> victim = leastRecentlyUsed(sizeClass)) {
+                offset = entries_[*victim].offset;
+                evict(*victim);
+            }
+        }
+        if (!offset) offset = rebalance(size);
+        if (!offset) return std::nullopt;
+        header_->usedBytes += size;
+        header_->peakBytes = std::max(header_->peakBytes, header_->usedBytes);
+        return offset;
+    }
+
+    std::optional<uint64_t> popFree(int sizeClass) {
+        if (header_->freeList[sizeClass] == shm::kNone) return std::nullopt;
+        uint64_t offset = header_->freeList[sizeClass];
+        std::memcpy(&header_->freeList[sizeClass], writable_ + offset, sizeof(uint64_t));
+        return offset;
+    }
+
+    // Space from the first pool extent large enough, or from the never used tail of the data region
+    std::optional<uint64_t> carve(uint64_t size) {
+        for (uint64_t previous = shm::kNone, at = header_->pool; at != shm::kNone;) {
+            shm::PoolExtent extent = extentAt(at);
+            if (extent.size >= size) {
+                if (extent.size == size) {
+                    linkExtent(previous, extent.next);
+                } else {
+                    writeExtent(at + size, {extent.next, extent.size - size});
+                    linkExtent(previous, at + size);
+                }
+                return at;
+            }
+            previous = at;
+            at = extent.next;
+        }
+        if (header_->bumpOffset + size > header_->dataSize) return std::nullopt;
+        uint64_t offset = header_->bumpOffset;
+        header_->bumpOffset += size;
+        return offset;
+    }
+
+    // Move every free block of every class to the pool; true if there was any
+    bool returnIdleBlocks() {
+        bool returned = false;
+        for (uint32_t c = 0; c < header_->classCount; ++c) {
+            while (std::optional<uint64_t> block = popFree(static_cast<int>(c))) {
+                releaseExtent(*block, header_->classSize[c]);
+                returned = true;
+            }
+        }
+        return returned;
+    }
+
+    // Calcified classes: evict the least recently used images of any class into the pool until
+    // an extent of the requested size forms
+    std::optional<uint64_t> rebalance(uint64_t size) {
+        std::optional<uint64_t> offset;
+        while (!offset) {
+            std::optional<uint32_t> victim = leastRecentlyUsed(-1);
+            if (!victim) return std::nullopt;
+            const shm::Entry& entry = entries_[*victim];
+            releaseExtent(entry.offset, header_->classSize[entry.sizeClass]);
+            evict(*victim);
+            offset = carve(size);
+        }
+        return offset;
+    }
+
+    // Least recently used unreferenced image of a class (any class if negative)
+    std::optional<uint32_t> leastRecentlyUsed(int sizeClass) const {
+        std::optional<uint32_t> victim;
+        for (uint32_t i = 0; i < header_->slotCount; ++i) {
+            const shm::Entry& entry = entries_[i];
+            if (entry.state == shm::kLive && (sizeClass < 0 || entry.sizeClass == sizeClass) && unreferenced(entry) &&
+                (!victim || entry.lastUse < entries_[*victim].lastUse))
+                victim = i;
+        }
+        return victim;
+    }
+
+    // Drop an unreferenced image whose block the caller has taken over
+    void evict(uint32_t index) {
+        header_->usedBytes -= header_->classSize[entries_[index].sizeClass];
+        freeSlot(index);
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shm::PoolExtent extentAt(uint64_t offset) const {
+        shm::PoolExtent extent;
+        std::memcpy(&extent, writable_ + offset, sizeof(extent));
+        return extent;
+    }
+
+    void writeExtent(uint64_t offset, const shm::PoolExtent& extent) { std::memcpy(writable_ + offset, &extent, sizeof(extent)); }
+
+    // Point the pool head (no previous extent) or the previous extent at next
+    void linkExtent(uint64_t previous, uint64_t next) {
+        if (previous == shm::kNone) {
+            header_->pool = next;
+            return;
+        }
+        shm::PoolExtent extent = extentAt(previous);
+        extent.next = next;
+        writeExtent(previous, extent);
+    }
+
+    // Return space to the pool, merged with adjacent extents; space ending at the unused tail joins the tail
+    void releaseExtent(uint64_t offset, uint64_t size) {
+        uint64_t beforePrevious = shm::kNone, previous = shm::kNone, next = header_->pool;
+        while (next != shm::kNone && next < offset) {
+            beforePrevious = previous;
+            previous = next;
+            next = extentAt(next).next;
+        }
+        if (next != shm::kNone && offset + size == next) {
+            shm::PoolExtent following = extentAt(next);
+            size += following.size;
+            next = following.next;
+        }
+        if (previous != shm::kNone) {
+            shm::PoolExtent preceding = extentAt(previous);
+            if (previous + preceding.size == offset) {
+                offset = previous;
+                size += preceding.size;
+                previous = beforePrevious;
+            }
+        }
+        if (offset + size == header_->bumpOffset) { // Nothing lies beyond it, so next is kNone
+            header_->bumpOffset = offset;
+            linkExtent(previous, shm::kNone);
+            return;
+        }
+        writeExtent(offset, {next, size});
+        linkExtent(previous, offset);
+    }
+
+    void freeBlock(int sizeClass, uint64_t offset) {
+        std::memcpy(writable_ + offset, &header_->freeList[sizeClass], sizeof(uint64_t));
+        header_->freeList[sizeClass] = offset;
+        header_->usedBytes -= header_->classSize[sizeClass];
+    }
+
+    // Free an index slot: a tombstone keeps probe sequences through it intact, but tombstones
+    // directly before an empty slot end no sequence that the empty slot would not end anyway
+    void freeSlot(uint32_t index) {
+        uint32_t slots = header_->slotCount;
+        entries_[index].state = shm::kTombstone;
+        --header_->occupied;
+        if (entries_[(index + 1) % slots].state != shm::kEmpty) return;
+        for (uint32_t n = 0; n < slots && entries_[index].state == shm::kTombstone; ++n, index = (index + slots - 1) % slots)
+            entries_[index].state = shm::kEmpty;
+    }
+
+    // Take an entry out of lookups; free its block now, or when its last reference is released
+    void retire(uint32_t index) {
+        shm::Entry& entry = entries_[index];
+        if (!unreferenced(entry)) {
+            entry.state = shm::kZombie;
+            return;
+        }
+        freeBlock(entry.sizeClass, entry.offset);
+        freeSlot(index);
+    }
+
+    std::string name_;
+    bool unlinkOnDestroy_;
+    int fd_ = -1;
+    unsigned char* base_ = nullptr;      ///< Whole segment, read-write
+    size_t size_ = 0;
+    unsigned char* writable_ = nullptr;  ///< Data region in base_
+    const unsigned char* readable_ = nullptr; ///< Data region mapped again read-only, for leases
+    size_t dataSize_ = 0;
+    shm::Header* header_ = nullptr;
+    shm::Entry* entries_ = nullptr;
+    size_t slot_ = shm::kMaxProcesses;   ///< This process's lease slot (none until attached)
+    std::atomic<uint64_t> evictions_{0};
+};
+
+} // namespace pipeline
+
+#endif // __unix__
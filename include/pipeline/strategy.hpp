@@ -1,9 +1,17 @@
 #pragma once
 
+#include "pipeline/image_probe.hpp"
+#include "pipeline/batch_report.hpp"
+#include "pipeline/encode_profile.hpp"
+#include "pipeline/cache_stats.hpp"
+
+#include <chrono>
+#include <filesystem>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <stdexcept>
 
 namespace pipeline {
 
@@ -15,6 +23,41 @@ namespace pipeline {
 template <typename ImageType>
 using ImageMap = std::unordered_map<std::string, ImageType>;
 
+/**
+ * @brief Hints for decoding an image at reduced resolution.
+ *
+ * JPEG decoders can scale by 1/2, 1/4 or 1/8 in the DCT domain, which is much cheaper
+ * than a full decode; other formats may be decoded fully and resized, or ignore the hint.
+ */
+struct DecodeOptions {
+    int scaleDenominator = 1; ///< Decode at 1/N of the original size (1, 2, 4 or 8).
+    int minWidth = 0;         ///< If set, pick the largest reduction keeping at least this width.
+    int minHeight = 0;        ///< If set, pick the largest reduction keeping at least this height.
+
+    /**
+     * @brief true if these options ask for the original resolution.
+     */
+    bool isFullResolution() const { return scaleDenominator <= 1 && minWidth <= 0 && minHeight <= 0; }
+
+    /**
+     * @brief true if the reduction depends on the image size (see denominatorFor).
+     */
+    bool hasMinimumSize() const { return minWidth > 0 || minHeight > 0; }
+
+    /**
+     * @brief Resolve the reduction (1, 2, 4 or 8) for an image of the given size.
+     *
+     * With a minimum size, scaleDenominator (or 8 if unset) is the largest reduction tried.
+     */
+    int denominatorFor(int width, int height) const {
+        int limit = scaleDenominator > 1 ? scaleDenominator : (hasMinimumSize() ? 8 : 1);
+        int d = 1;
+        while (d * 2 <= limit && d < 8) d *= 2;
+        while (d > 1 && (width / d < minWidth || height / d < minHeight)) d /= 2;
+        return d;
+    }
+};
+
 /**
  * @brief Abstract interface for managing image caching.
  *
@@ -79,6 +122,50 @@ public:
      * @return std::vector<std::string> Vector containing all cached keys.
      */
     virtual std::vector<std::string> getKeys() const = 0;
+
+    /**
+     * @brief Whether the cache wants encoded file contents instead of decoded images.
+     *
+     * Loaders check this and call cacheEncoded() with the raw file bytes. Default: false.
+     */
+    virtual bool acceptsEncoded() const { return false; }
+
+    /**
+     * @brief Cache encoded file contents under the specified key; decoded on access.
+     *
+     * Only called if acceptsEncoded() returns true. The default throws.
+     *
+     * @param key Unique string identifier for the image.
+     * @param bytes Encoded image bytes (e.g. a whole JPEG file).
+     */
+    virtual void cacheEncoded(const std::string& key, std::vector<unsigned char> bytes) {
+        (void)key;
+        (void)bytes;
+        throw std::runtime_error("This cache does not accept encoded images");
+    }
+
+    /**
+     * @brief Snapshot of hit/miss/eviction counters and memory use.
+     *
+     * Caches without instrumentation return all zeros (the default).
+     *
+     * @return CacheStatsSnapshot Current counters.
+     */
+    virtual CacheStatsSnapshot stats() const { return {}; }
+
+    /**
+     * @brief Record how long it took to decode the image just cached under key.
+     *
+     * Called by loaders after cacheImage(); instrumented caches add this cost to
+     * decodeTimeSaved whenever isCached() later finds the key. The default ignores it.
+     *
+     * @param key Key of the cached image.
+     * @param cost Time spent decoding it.
+     */
+    virtual void noteDecodeCost(const std::string& key, std::chrono::nanoseconds cost) {
+        (void)key;
+        (void)cost;
+    }
 };
 
 /**
@@ -101,6 +188,49 @@ public:
      */
     virtual ImageType loadFromFile(const std::string& path) = 0;
 
+    /**
+     * @brief Decode an image from encoded file contents held in memory.
+     *
+     * The default throws; loaders that can decode from memory override it.
+     *
+     * @param bytes Encoded image bytes (e.g. a whole JPEG file).
+     * @return ImageType Decoded image data.
+     *
+     * @throws std::runtime_error on decode failure or if unsupported.
+     */
+    virtual ImageType loadFromBuffer(const std::vector<unsigned char>& bytes) {
+        (void)bytes;
+        throw std::runtime_error("Decoding from memory is not supported by this loader");
+    }
+
+    /**
+     * @brief Load an image from a file at reduced resolution.
+     *
+     * The default ignores the options and decodes at full resolution.
+     *
+     * @param path Filesystem path to the image file.
+     * @param options Requested reduction.
+     * @return ImageType Loaded image data.
+     *
+     * @throws std::runtime_error on load failure.
+     */
+    virtual ImageType loadScaled(const std::string& path, const DecodeOptions& options) {
+        (void)options;
+        return loadFromFile(path);
+    }
+
+    /**
+     * @brief Read an image's size, channels and format from its header without decoding it.
+     *
+     * The default parses the container header (see probeImageFile).
+     *
+     * @param path Filesystem path to the image file.
+     * @return ImageInfo Header information.
+     *
+     * @throws std::runtime_error if the header cannot be parsed.
+     */
+    virtual ImageInfo probe(const std::string& path) { return probeImageFile(path); }
+
     /**
      * @brief Load an image from a file and store it in the cache with a key.
      *
@@ -129,6 +259,15 @@ public:
      * @return std::vector<std::string> List of keys of loaded images.
      */
     virtual std::vector<std::string> loadDirectory(CacheManager<ImageType>& cache, const std::string& dir, const std::string& inputRoot, const std::vector<std::string>& extensions) = 0;
+
+    /**
+     * @brief Hint the order in which files are about to be loaded.
+     *
+     * Loaders may start decoding these files in the background. The default does nothing.
+     *
+     * @param paths Filesystem paths in expected access order.
+     */
+    virtual void prefetch(const std::vector<std::string>& paths) { (void)paths; }
 };
 
 /**
@@ -151,14 +290,70 @@ public:
      */
     virtual void save(const std::string& outputPath, const ImageType& image) = 0;
 
+    /**
+     * @brief Save a single image with the given encoder settings.
+     *
+     * The path is final (the profile's format override is already applied).
+     * The default ignores the encoder settings.
+     *
+     * @param outputPath Full filesystem path to save the image.
+     * @param image Image data to save.
+     * @param profile Encoder settings.
+     *
+     * @throws std::runtime_error on save failure.
+     */
+    virtual void save(const std::string& outputPath, const ImageType& image, const EncodeProfile& profile) {
+        (void)profile;
+        save(outputPath, image);
+    }
+
     /**
      * @brief Save all images from the provided map to the output directory.
      *
      * @param images Map of key to image data.
      * @param outputDir Directory path where images should be saved.
+     *
+     * @throws std::runtime_error on save failure.
      */
     virtual void saveAll(const ImageMap<ImageType>& images, const std::string& outputDir) = 0;
 
+    /**
+     * @brief Save all images from the provided map, reporting per-image failures rather than throwing.
+     *
+     * The default calls saveAll(images, outputDir): every key succeeds, or, if it throws, every
+     * key is reported failed with its error (the saver cannot tell which images were written).
+     * Override it to report image by image.
+     *
+     * @param images Map of key to image data.
+     * @param outputDir Directory path where images should be saved.
+     * @return BatchReport Keys saved and keys that failed, with their error.
+     */
+    virtual BatchReport saveAllReport(const ImageMap<ImageType>& images, const std::string& outputDir) {
+        BatchReport report;
+        try {
+            saveAll(images, outputDir);
+            for (const auto& entry : images) report.succeeded.push_back(entry.first);
+        } catch (const std::exception& e) {
+            for (const auto& entry : images) report.failed.push_back({entry.first, e.what()});
+        }
+        return report;
+    }
+
+    /**
+     * @brief Save all images from the provided map with the given encoder settings.
+     *
+     * Per-image failures are reported rather than thrown. The default ignores the profile.
+     *
+     * @param images Map of key to image data.
+     * @param outputDir Directory path where images should be saved.
+     * @param profile Encoder settings, including an optional format override.
+     * @return BatchReport Keys saved and keys that failed, with their error.
+     */
+    virtual BatchReport saveAll(const ImageMap<ImageType>& images, const std::string& outputDir, const EncodeProfile& profile) {
+        (void)profile;
+        return saveAllReport(images, outputDir);
+    }
+
     /**
      * @brief Save an image into a custom subdirectory under output directory using the key as filename.
      *
@@ -168,6 +363,82 @@ public:
      * @param key Original key/filename for the image.
      */
     virtual void saveAs(const ImageType& image, const std::string& outputDir, const std::string& customSubdir, const std::string& key) = 0;
+
+    /**
+     * @brief Save an image into a custom subdirectory with the given encoder settings.
+     *
+     * The default ignores the profile.
+     *
+     * @param image Image data to save.
+     * @param outputDir Base output directory.
+     * @param customSubdir Subdirectory under outputDir where to save.
+     * @param key Original key/filename for the image.
+     * @param profile Encoder settings, including an optional format override.
+     */
+    virtual void saveAs(const ImageType& image, const std::string& outputDir, const std::string& customSubdir, const std::string& key, const EncodeProfile& profile) {
+        (void)profile;
+        saveAs(image, outputDir, customSubdir, key);
+    }
+
+    /**
+     * @brief Whether encode() is supported. Default: false.
+     */
+    virtual bool supportsEncode() const { return false; }
+
+    /**
+     * @brief Encode an image into memory.
+     *
+     * Only called if supportsEncode() returns true. The default throws.
+     *
+     * @param image Image data to encode.
+     * @param extension Format as a file extension (e.g. ".jpg").
+     * @param profile Encoder settings.
+     * @return std::vector<unsigned char> Encoded file contents.
+     *
+     * @throws std::runtime_error on encode failure or if unsupported.
+     */
+    virtual std::vector<unsigned char> encode(const ImageType& image, const std::string& extension, const EncodeProfile& profile) {
+        (void)image;
+        (void)extension;
+        (void)profile;
+        throw std::runtime_error("Encoding to memory is not supported by this saver");
+    }
+
+    /**
+     * @brief Save one image to several destinations (see SaveTarget).
+     *
+     * The default saves each target separately; savers supporting encode() encode each
+     * distinct format/profile once and write the bytes to every destination sharing it.
+     * Per-destination failures are reported rather than thrown.
+     *
+     * @param image Image data to save.
+     * @param outputDir Base output directory.
+     * @param key Original key/filename for the image.
+     * @param targets Destinations; an unset profile means default encoder settings.
+     * @return BatchReport Output paths (relative to outputDir) saved and failed.
+     */
+    virtual BatchReport saveMany(const ImageType& image, const std::string& outputDir, const std::string& key, const std::vector<SaveTarget>& targets) {
+        BatchReport report;
+        for (const auto& target : targets) {
+            std::string relative = (std::filesystem::path(target.subdir) / target.filenameFor(key)).generic_string();
+            try {
+                save((std::filesystem::path(outputDir) / relative).string(), image, target.profile.value_or(EncodeProfile{}));
+                report.succeeded.push_back(relative);
+            } catch (const std::exception& e) {
+                report.failed.push_back({relative, e.what()});
+            }
+        }
+        return report;
+    }
+
+    /**
+     * @brief Block until every save issued so far has completed.
+     *
+     * Savers that write in the background override this. The default does nothing.
+     *
+     * @throws std::runtime_error (or the original exception) if a background save failed.
+     */
+    virtual void flush() {}
 };
 
 } // namespace pipeline
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "pipeline/strategy.hpp"
+#include "pipeline/image_traits.hpp"
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace pipeline {
+
+/**
+ * @brief 2Q cache (Johnson & Shasha): scan-resistant replacement for LRUCacheManager.
+ *
+ * New images enter a small FIFO (A1in). Images evicted from it leave their key in a ghost
+ * FIFO (A1out); only an image inserted again while its key is still remembered there goes to
+ * the main LRU (Am). A one-pass scan therefore cycles through A1in and never displaces the
+ * images that are reused, such as those repeatedly reset by a recipe.
+ *
+ * @tparam ImageType The image data type stored in the cache.
+ * @tparam Traits Provides byteSize(image), used for the byte statistics. Defaults to ImageTraits.
+ */
+template <typename ImageType, typename Traits = ImageTraits<ImageType>>
+class TwoQueueCacheManager : public CacheManager<ImageType> {
+public:
+    /**
+     * @brief Construct a new TwoQueueCacheManager.
+     *
+     * @param capacity Maximum number of images the cache can hold.
+     * @param inFraction Share of the capacity reserved for newly inserted images (A1in).
+     * @param ghostFraction Number of evicted keys remembered (A1out), relative to capacity.
+     */
+    explicit TwoQueueCacheManager(size_t capacity, double inFraction = 0.25, double ghostFraction = 0.5)
+        : capacity_(std::max<size_t>(capacity, 1))
+        , inCapacity_(std::max<size_t>(static_cast<size_t>(capacity_ * inFraction), 1))
+        , ghostCapacity_(std::max<size_t>(static_cast<size_t>(capacity_ * ghostFraction), 1)) {}
+
+    /**
+     * @brief Cache an image with the associated key.
+     *
+     * A key remembered in the ghost queue goes straight to the main LRU; other new keys
+     * enter the FIFO. Evicts as needed to stay within capacity.
+     *
+     * @param key The unique string key identifying the image.
+     * @param image The image data to cache.
+     */
+    void cacheImage(const std::string& key, const ImageType& image) override {
+        counters_.recordInsertion();
+        auto it = map_.find(key);
+        if (it != map_.end() && it->second.queue != Queue::Out) {
+            bytes_ -= Traits::byteSize(*it->second.image);
+            it->second.image = image;
+            it->second.decodeCost = std::chrono::nanoseconds(0);
+            bytes_ += Traits::byteSize(image);
+            peakBytes_ = std::max(peakBytes_, bytes_);
+            if (it->second.queue == Queue::Main) main_.splice(main_.begin(), main_, it->second.position);
+            return;
+        }
+        if (it != map_.end()) {
+            // Seen recently enough to still be remembered: treat as reused
+            out_.erase(it->second.position);
+            main_.push_front(key);
+            it->second = Node{image, Queue::Main, main_.begin(), std::chrono::nanoseconds(0)};
+        } else {
+            in_.push_front(key);
+            map_.emplace(key, Node{image, Queue::In, in_.begin(), std::chrono::nanoseconds(0)});
+        }
+        bytes_ += Traits::byteSize(image);
+        peakBytes_ = std::max(peakBytes_, bytes_);
+        while (in_.size() + main_.size() > capacity_) reclaim();
+    }
+
+    /**
+     * @brief Check if an image identified by key is cached.
+     * @param key The key to query.
+     * @return true if the image is cached, false otherwise.
+     */
+    bool isCached(const std::string& key) const override {
+        auto it = map_.find(key);
+        if (it == map_.end() || it->second.queue == Queue::Out) {
+            counters_.recordMiss(CacheOp::IsCached);
+            return false;
+        }
+        counters_.recordHit(CacheOp::IsCached);
+        counters_.recordDecodeSaved(it->second.decodeCost);
+        return true;
+    }
+
+    /**
+     * @brief Retrieve a cached image by key (deep copy). Refreshes it if in the main LRU.
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image.
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCached(const std::string& key) const override {
+        return touch(key, CacheOp::Get).clone();
+    }
+
+    /**
+     * @brief Retrieve a cached image by key without copying. Refreshes it if in the main LRU.
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image (shallow copy).
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCachedShallow(const std::string& key) const override {
+        return touch(key, CacheOp::GetShallow);
+    }
+
+    /**
+     * @brief Remove an image (and any ghost entry) from the cache by key.
+     * @param key The key of the image to remove.
+     */
+    void remove(const std::string& key) override {
+        auto it = map_.find(key);
+        if (it == map_.end()) return;
+        if (it->second.image) bytes_ -= Traits::byteSize(*it->second.image);
+        listOf(it->second.queue).erase(it->second.position);
+        map_.erase(it);
+    }
+
+    /**
+     * @brief Clear all cached images and ghost entries.
+     */
+    void clear() override {
+        map_.clear();
+        in_.clear();
+        main_.clear();
+        out_.clear();
+        bytes_ = 0;
+    }
+
+    /**
+     * @brief Get the cached keys: main LRU (most recent first), then the FIFO (newest first).
+     * @return std::vector<std::string> Vector of cached keys.
+     */
+    std::vector<std::string> getKeys() const override {
+        std::vector<std::string> keys(main_.begin(), main_.end());
+        keys.insert(keys.end(), in_.begin(), in_.end());
+        return keys;
+    }
+
+    /**
+     * @brief Snapshot of hit/miss/eviction counters, resident and peak bytes, and decode time saved.
+     * @return Current counters.
+     */
+    CacheStatsSnapshot stats() const override {
+        CacheStatsSnapshot s = counters_.snapshot();
+        s.residentBytes = bytes_;
+        s.peakBytes = peakBytes_;
+        return s;
+    }
+
+    /**
+     * @brief Remember the decode cost of a cached image, credited on later isCached hits.
+     * @param key Key of the cached image.
+     * @param cost Time spent decoding it.
+     */
+    void noteDecodeCost(const std::string& key, std::chrono::nanoseconds cost) override {
+        auto it = map_.find(key);
+        if (it != map_.end() && it->second.image) it->second.decodeCost = cost;
+    }
+
+private:
+    enum class Queue { In, Main, Out };
+
+    struct Node {
+        std::optional<ImageType> image; ///< Empty for ghost entries
+        Queue queue;
+        std::list<std::string>::iterator position;
+        std::chrono::nanoseconds decodeCost;
+    };
+
+    std::list<std::string>& listOf(Queue queue) const {
+        return queue == Queue::In ? in_ : queue == Queue::Main ? main_ : out_;
+    }
+
+    const ImageType& touch(const std::string& key, CacheOp op) const {
+        auto it = map_.find(key);
+        if (it == map_.end() || it->second.queue == Queue::Out) {
+            counters_.recordMiss(op);
+            throw std::runtime_error("Key not found in cache: " + key);
+        }
+        counters_.recordHit(op);
+        if (it->second.queue == Queue::Main) main_.splice(main_.begin(), main_, it->second.position);
+        return *it->second.image;
+    }
+
+    // Evict one image: the FIFO's oldest (remembered as a ghost) while it is over its share, else the LRU's
+    void reclaim() {
+        counters_.recordEviction();
+        if (in_.size() > inCapacity_ || main_.empty()) {
+            auto it = map_.find(in_.back());
+            in_.pop_back();
+            bytes_ -= Traits::byteSize(*it->second.image);
+            out_.push_front(it->first);
+            it->second = Node{std::nullopt, Queue::Out, out_.begin(), std::chrono::nanoseconds(0)};
+            if (out_.size() > ghostCapacity_) {
+                map_.erase(out_.back());
+                out_.pop_back();
+            }
+            return;
+        }
+        auto it = map_.find(main_.back());
+        main_.pop_back();
+        bytes_ -= Traits::byteSize(*it->second.image);
+        map_.erase(it);
+    }
+
+    size_t capacity_;      ///< Maximum resident images
+    size_t inCapacity_;    ///< Target size of the FIFO (A1in)
+    size_t ghostCapacity_; ///< Maximum remembered evicted keys (A1out)
+    mutable std::list<std::string> in_;   ///< A1in: newest first
+    mutable std::list<std::string> main_; ///< Am: most recently used first
+    mutable std::list<std::string> out_;  ///< A1out: ghost keys, newest first
+    std::unordered_map<std::string, Node> map_; ///< Key to node, for resident and ghost entries
+    size_t bytes_ = 0;
+    size_t peakBytes_ = 0;
+    mutable CacheStats counters_; ///< Updated by const lookups too
+};
+
+} // namespace pipeline
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "pipeline/strategy.hpp"
+#include "pipeline/image_traits.hpp"
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace pipeline {
+
+/**
+ * @brief Adaptive Replacement Cache (Megiddo & Modha): scan-resistant replacement for LRUCacheManager.
+ *
+ * Resident images are split between T1 (seen once) and T2 (reused), each an LRU list, and the
+ * keys recently evicted from each are remembered in ghost lists B1 and B2. A miss that hits a
+ * ghost list moves the target size of T1 towards whichever side would have kept the image, so
+ * the cache tunes itself between recency and frequency. A scan only churns T1.
+ *
+ * The read that directly follows an insertion (the pipeline loads then reads) does not count
+ * as reuse; later reads move the image to T2.
+ *
+ * @tparam ImageType The image data type stored in the cache.
+ * @tparam Traits Provides byteSize(image), used for the byte statistics. Defaults to ImageTraits.
+ */
+template <typename ImageType, typename Traits = ImageTraits<ImageType>>
+class ARCCacheManager : public CacheManager<ImageType> {
+public:
+    /**
+     * @brief Construct a new ARCCacheManager.
+     * @param capacity Maximum number of images the cache can hold (as many keys are remembered as ghosts).
+     */
+    explicit ARCCacheManager(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+    /**
+     * @brief Cache an image with the associated key, evicting per the ARC policy if full.
+     * @param key The unique string key identifying the image.
+     * @param image The image data to cache.
+     */
+    void cacheImage(const std::string& key, const ImageType& image) override {
+        counters_.recordInsertion();
+        auto it = map_.find(key);
+        if (it != map_.end() && resident(it->second.list)) {
+            bytes_ -= Traits::byteSize(*it->second.image);
+            it->second.image = image;
+            it->second.decodeCost = std::chrono::nanoseconds(0);
+            bytes_ += Traits::byteSize(image);
+            peakBytes_ = std::max(peakBytes_, bytes_);
+            return;
+        }
+
+        if (it != map_.end()) {
+            // Ghost hit: adapt the T1 target towards the list that would have kept the image
+            bool inB1 = it->second.list == List::B1;
+            if (inB1) {
+                p_ = std::min(capacity_, p_ + std::max<size_t>(b2_.size() / b1_.size(), 1));
+            } else {
+                size_t step = std::max<size_t>(b1_.size() / b2_.size(), 1);
+                p_ = p_ > step ? p_ - step : 0;
+            }
+            listFor(it->second.list).erase(it->second.position);
+            map_.erase(it);
+            if (t1_.size() + t2_.size() >= capacity_) replace(!inB1);
+            insert(key, image, List::T2, false);
+            return;
+        }
+
+        size_t l1 = t1_.size() + b1_.size();
+        size_t total = l1 + t2_.size() + b2_.size();
+        if (l1 >= capacity_) {
+            if (t1_.size() < capacity_) {
+                dropGhost(b1_);
+                if (t1_.size() + t2_.size() >= capacity_) replace(false);
+            } else {
+                evict(t1_, nullptr);
+            }
+        } else if (total >= capacity_) {
+            if (total >= 2 * capacity_) dropGhost(b2_);
+            if (t1_.size() + t2_.size() >= capacity_) replace(false);
+        }
+        insert(key, image, List::T1, true);
+    }
+
+    /**
+     * @brief Check if an image identified by key is cached.
+     * @param key The key to query.
+     * @return true if the image is cached, false otherwise.
+     */
+    bool isCached(const std::string& key) const override {
+        auto it = map_.find(key);
+        if (it == map_.end() || !resident(it->second.list)) {
+            counters_.recordMiss(CacheOp::IsCached);
+            return false;
+        }
+        counters_.recordHit(CacheOp::IsCached);
+        counters_.recordDecodeSaved(it->second.decodeCost);
+        return true;
+    }
+
+    /**
+     * @brief Retrieve a cached image by key (deep copy) and record the access.
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image.
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCached(const std::string& key) const override {
+        return touch(key, CacheOp::Get).clone();
+    }
+
+    /**
+     * @brief Retrieve a cached image by key without copying and record the access.
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image (shallow copy).
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCachedShallow(const std::string& key) const override {
+        return touch(key, CacheOp::GetShallow);
+    }
+
+    /**
+     * @brief Remove an image (and any ghost entry) from the cache by key.
+     * @param key The key of the image to remove.
+     */
+    void remove(const std::string& key) override {
+        auto it = map_.find(key);
+        if (it == map_.end()) return;
+        if (it->second.image) bytes_ -= Traits::byteSize(*it->second.image);
+        listFor(it->second.list).erase(it->second.position);
+        map_.erase(it);
+    }
+
+    /**
+     * @brief Clear all cached images and ghost entries, and reset the adaptation.
+     */
+    void clear() override {
+        map_.clear();
+        t1_.clear();
+        t2_.clear();
+        b1_.clear();
+        b2_.clear();
+        p_ = 0;
+        bytes_ = 0;
+    }
+
+    /**
+     * @brief Get the cached keys: T2 then T1, each most recently used first.
+     * @return std::vector<std::string> Vector of cached keys.
+     */
+    std::vector<std::string> getKeys() const override {
+        std::vector<std::string> keys(t2_.begin(), t2_.end());
+        keys.insert(keys.end(), t1_.begin(), t1_.end());
+        return keys;
+    }
+
+    /**
+     * @brief Current target size of T1 (images seen once), between 0 and capacity.
+     */
+    size_t recencyTarget() const { return p_; }
+
+    /**
+     * @brief Snapshot of hit/miss/eviction counters, resident and peak bytes, and decode time saved.
+     * @return Current counters.
+     */
+    CacheStatsSnapshot stats() const override {
+        CacheStatsSnapshot s = counters_.snapshot();
+        s.residentBytes = bytes_;
+        s.peakBytes = peakBytes_;
+        return s;
+    }
+
+    /**
+     * @brief Remember the decode cost of a cached image, credited on later isCached hits.
+     * @param key Key of the cached image.
+     * @param cost Time spent decoding it.
+     */
+    void noteDecodeCost(const std::string& key, std::chrono::nanoseconds cost) override {
+        auto it = map_.find(key);
+        if (it != map_.end() && it->second.image) it->second.decodeCost = cost;
+    }
+
+private:
+    enum class List { T1, T2, B1, B2 };
+
+    struct Node {
+        std::optional<ImageType> image; ///< Empty for ghost entries
+        List list;
+        std::list<std::string>::iterator position;
+        bool fresh;                     ///< Inserted and not read yet
+        std::chrono::nanoseconds decodeCost;
+    };
+
+    static bool resident(List list) { return list == List::T1 || list == List::T2; }
+
+    std::list<std::string>& listFor(List list) const {
+        switch (list) {
+            case List::T1: return t1_;
+            case List::T2: return t2_;
+            case List::B1: return b1_;
+            default: return b2_;
+        }
+    }
+
+    const ImageType& touch(const std::string& key, CacheOp op) const {
+        auto it = map_.find(key);
+        if (it == map_.end() || !resident(it->second.list)) {
+            counters_.recordMiss(op);
+            throw std::runtime_error("Key not found in cache: " + key);
+        }
+        counters_.recordHit(op);
+        Node& node = it->second;
+        if (node.fresh) {
+            node.fresh = false;
+        } else {
+            t2_.splice(t2_.begin(), listFor(node.list), node.position);
+            node.list = List::T2;
+        }
+        return *node.image;
+    }
+
+    void insert(const std::string& key, const ImageType& image, List list, bool fresh) {
+        listFor(list).push_front(key);
+        map_.emplace(key, Node{image, list, listFor(list).begin(), fresh, std::chrono::nanoseconds(0)});
+        bytes_ += Traits::byteSize(image);
+        peakBytes_ = std::max(peakBytes_, bytes_);
+    }
+
+    // Evict the LRU image of T1 or T2 (whichever is over its target) into the matching ghost list
+    void replace(bool ghostFromB2) {
+        bool fromT1 = !t1_.empty() && (t1_.size() > p_ || (ghostFromB2 && t1_.size() == p_) || t2_.empty());
+        if (fromT1) {
+            evict(t1_, &b1_);
+        } else if (!t2_.empty()) {
+            evict(t2_, &b2_);
+        }
+    }
+
+    void evict(std::list<std::string>& from, std::list<std::string>* ghosts) {
+        counters_.recordEviction();
+        auto it = map_.find(from.back());
+        from.pop_back();
+        bytes_ -= Traits::byteSize(*it->second.image);
+        if (!ghosts) {
+            map_.erase(it);
+            return;
+        }
+        ghosts->push_front(it->first);
+        it->second = Node{std::nullopt, ghosts == &b1_ ? List::B1 : List::B2, ghosts->begin(), false, std::chrono::nanoseconds(0)};
+    }
+
+    void dropGhost(std::list<std::string>& ghosts) {
+        if (ghosts.empty()) return;
+        map_.erase(ghosts.back());
+        ghosts.pop_back();
+    }
+
+    size_t capacity_; ///< Maximum resident images
+    size_t p_ = 0;    ///< Adaptive target size of T1
+    mutable std::list<std::string> t1_; ///< Resident, seen once; most recent first
+    mutable std::list<std::string> t2_; ///< Resident, reused; most recent first
+    mutable std::list<std::string> b1_; ///< Ghost keys evicted from T1
+    mutable std::list<std::string> b2_; ///< Ghost keys evicted from T2
+    mutable std::unordered_map<std::string, Node> map_; ///< Key to node, for resident and ghost entries
+    size_t bytes_ = 0;
+    size_t peakBytes_ = 0;
+    mutable CacheStats counters_; ///< Updated by const lookups too
+};
+
+} // namespace pipeline
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "pipeline/strategy.hpp"
+#include "pipeline/strategy_default.hpp"
+#include "pipeline/thread_pool.hpp"
+
+#include <memory>
+#include <string>
+
+namespace pipeline {
+
+/**
+ * @brief Image saver that encodes and writes on background threads.
+ *
+ * Wraps another saver. Each save takes a snapshot of the image (a shallow copy for types
+ * like cv::Mat), queues it and returns immediately, so encoding and disk I/O overlap with
+ * processing of the next image. In-place writers must detach first with
+ * ImageTraits::makeExclusive (RegionPipeline does) so queued snapshots stay intact.
+ *
+ * At most maxQueued saves wait in the queue; further saves block until a slot frees up.
+ * Call flush() (or Pipeline::flush) to wait for completion and receive the first error.
+ * The destructor waits for queued saves but drops their errors.
+ *
+ * @tparam ImageType The image type to save.
+ */
+template <typename ImageType>
+class AsyncImageSaver : public ImageSaver<ImageType> {
+public:
+    /**
+     * @brief Construct a new AsyncImageSaver.
+     *
+     * @param workers Number of encoder threads.
+     * @param maxQueued Maximum number of snapshots waiting to be written.
+     * @param inner Saver doing the actual encoding. Defaults to DefaultImageSaver.
+     */
+    explicit AsyncImageSaver(size_t workers = 1, size_t maxQueued = 16, std::unique_ptr<ImageSaver<ImageType>> inner = nullptr)
+        : inner_(inner != nullptr ? std::move(inner) : std::make_unique<DefaultImageSaver<ImageType>>())
+        , pool_(workers, maxQueued) {}
+
+    /**
+     * @brief Queue an image to be saved to a file.
+     * @param outputPath Output file path.
+     * @param image Image to save.
+     */
+    void save(const std::string& outputPath, const ImageType& image) override {
+        pool_.submit([this, outputPath, snapshot = image] { inner_->save(outputPath, snapshot); });
+    }
+
+    /**
+     * @brief Queue an image to be saved to a file with the given encoder settings.
+     * @param outputPath Output file path.
+     * @param image Image to save.
+     * @param profile Encoder settings.
+     */
+    void save(const std::string& outputPath, const ImageType& image, const EncodeProfile& profile) override {
+        pool_.submit([this, outputPath, profile, snapshot = image] { inner_->save(outputPath, snapshot, profile); });
+    }
+
+    /**
+     * @brief Wait for queued saves, then save all images of a map through the inner saver.
+     *
+     * Runs on the caller's thread so the per-key report is complete when it returns;
+     * use a parallel inner saver (e.g. DefaultImageSaver with ioWorkers) to spread the work.
+     *
+     * @param images Map of image keys to images.
+     * @param outputDir Directory to save images into.
+     * @throws The first exception raised by a previously queued save, or by the inner saver.
+     */
+    void saveAll(const ImageMap<ImageType>& images, const std::string& outputDir) override {
+        pool_.wait();
+        inner_->saveAll(images, outputDir);
+    }
+
+    /**
+     * @brief Wait for queued saves, then save all images of a map, reporting per-key failures.
+     * @param images Map of image keys to images.
+     * @param outputDir Directory to save images into.
+     * @return Keys saved and keys that failed, with their error.
+     * @throws The first exception raised by a previously queued save.
+     */
+    BatchReport saveAllReport(const ImageMap<ImageType>& images, const std::string& outputDir) override {
+        pool_.wait();
+        return inner_->saveAllReport(images, outputDir);
+    }
+
+    /**
+     * @brief Wait for queued saves, then save all images of a map with the given encoder settings.
+     * @param images Map of image keys to images.
+     * @param outputDir Directory to save images into.
+     * @param profile Encoder settings.
+     * @return Keys saved and keys that failed, with their error.
+     * @throws The first exception raised by a previously queued save.
+     */
+    BatchReport saveAll(const ImageMap<ImageType>& images, const std::string& outputDir, const EncodeProfile& profile) override {
+        pool_.wait();
+        return inner_->saveAll(images, outputDir, profile);
+    }
+
+    /**
+     * @brief Queue an image to be saved into a custom subdirectory.
+     * @param image Image to save.
+     * @param outputDir Root output directory.
+     * @param customSubdir Custom subdirectory name.
+     * @param key Key representing the image filename.
+     */
+    void saveAs(const ImageType& image, const std::string& outputDir, const std::string& customSubdir, const std::string& key) override {
+        pool_.submit([this, outputDir, customSubdir, key, snapshot = image] {
+            inner_->saveAs(snapshot, outputDir, customSubdir, key);
+        });
+    }
+
+    /**
+     * @brief Queue an image to be saved into a custom subdirectory with the given encoder settings.
+     * @param image Image to save.
+     * @param outputDir Root output directory.
+     * @param customSubdir Custom subdirectory name.
+     * @param key Key representing the image filename.
+     * @param profile Encoder settings.
+     */
+    void saveAs(const ImageType& image, const std::string& outputDir, const std::string& customSubdir, const std::string& key, const EncodeProfile& profile) override {
+        pool_.submit([this, outputDir, customSubdir, key, profile, snapshot = image] {
+            inner_->saveAs(snapshot, outputDir, customSubdir, key, profile);
+        });
+    }
+
+    /**
+     * @brief Whether the inner saver can encode to memory.
+     */
+    bool supportsEncode() const override { return inner_->supportsEncode(); }
+
+    /**
+     * @brief Encode an image into memory through the inner saver, on the caller's thread.
+     * @param image Image to encode.
+     * @param extension Format as a file extension (e.g. ".jpg").
+     * @param profile Encoder settings.
+     * @return Encoded file contents.
+     */
+    std::vector<unsigned char> encode(const ImageType& image, const std::string& extension, const EncodeProfile& profile) override {
+        return inner_->encode(image, extension, profile);
+    }
+
+    /**
+     * @brief Wait for queued saves, then save one image to several destinations through the inner saver.
+     * @param image Image to save.
+     * @param outputDir Root output directory.
+     * @param key Key representing the image filename.
+     * @param targets Destinations.
+     * @return Output paths (relative to outputDir) saved and failed.
+     * @throws The first exception raised by a previously queued save.
+     */
+    BatchReport saveMany(const ImageType& image, const std::string& outputDir, const std::string& key, const std::vector<SaveTarget>& targets) override {
+        pool_.wait();
+        return inner_->saveMany(image, outputDir, key, targets);
+    }
+
+    /**
+     * @brief Wait for all queued saves, then flush the inner saver.
+     * @throws The first exception raised by a queued save since the last flush.
+     */
+    void flush() override {
+        pool_.wait();
+        inner_->flush();
+    }
+
+private:
+    std::unique_ptr<ImageSaver<ImageType>> inner_; ///< Saver doing the encoding
+    ThreadPool pool_; ///< Encoder threads; declared last so queued saves finish before inner_ is destroyed
+};
+
+} // namespace pipeline
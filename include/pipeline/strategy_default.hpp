@@ -1,12 +1,19 @@
 #pragma once
 
+#include "pipeline/mapped_file.hpp"
+#include "pipeline/thread_pool.hpp"
+#include "pipeline/image_traits.hpp"
+
 #include <unordered_map>
 #include <vector>
 #include <string>
 #include <filesystem>
 #include <algorithm>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <unordered_set>
 
 namespace pipeline {
 
@@ -27,14 +34,31 @@ public:
      * @param key Unique string key to associate with the image.
      * @param image The image to cache.
      */
-    void cacheImage(const std::string& key, const ImageType& image) override { map[key] = image; }
+    void cacheImage(const std::string& key, const ImageType& image) override {
+        auto it = map.find(key);
+        if (it != map.end()) bytes -= ImageTraits<ImageType>::byteSize(it->second);
+        map[key] = image;
+        bytes += ImageTraits<ImageType>::byteSize(image);
+        peakBytes = std::max(peakBytes, bytes);
+        decodeCosts.erase(key);
+        counters.recordInsertion();
+    }
 
     /**
      * @brief Check if an image with the given key is cached.
      * @param key Key to check in the cache.
      * @return true if cached, false otherwise.
      */
-    bool isCached(const std::string& key) const override { return map.count(key) > 0; }
+    bool isCached(const std::string& key) const override {
+        if (map.count(key) == 0) {
+            counters.recordMiss(CacheOp::IsCached);
+            return false;
+        }
+        counters.recordHit(CacheOp::IsCached);
+        auto cost = decodeCosts.find(key);
+        if (cost != decodeCosts.end()) counters.recordDecodeSaved(cost->second);
+        return true;
+    }
 
     /**
      * @brief Get a cached image by key (shallow copy).
@@ -44,7 +68,11 @@ public:
      */
     ImageType getCachedShallow(const std::string& key) const override {
         auto it = map.find(key);
-        if (it == map.end()) throw std::runtime_error("Cache miss: " + key);
+        if (it == map.end()) {
+            counters.recordMiss(CacheOp::GetShallow);
+            throw std::runtime_error("Cache miss: " + key);
+        }
+        counters.recordHit(CacheOp::GetShallow);
         return it->second;
     }
 
@@ -56,7 +84,11 @@ public:
      */
     ImageType getCached(const std::string& key) const override {
         auto it = map.find(key);
-        if (it == map.end()) throw std::runtime_error("Cache miss: " + key);
+        if (it == map.end()) {
+            counters.recordMiss(CacheOp::Get);
+            throw std::runtime_error("Cache miss: " + key);
+        }
+        counters.recordHit(CacheOp::Get);
         return it->second;
     }
 
@@ -64,12 +96,22 @@ public:
      * @brief Remove an image from the cache.
      * @param key Key of the image to remove.
      */
-    void remove(const std::string& key) override { map.erase(key); }
+    void remove(const std::string& key) override {
+        auto it = map.find(key);
+        if (it == map.end()) return;
+        bytes -= ImageTraits<ImageType>::byteSize(it->second);
+        map.erase(it);
+        decodeCosts.erase(key);
+    }
 
     /**
      * @brief Clear the entire cache.
      */
-    void clear() override { map.clear(); }
+    void clear() override {
+        map.clear();
+        decodeCosts.clear();
+        bytes = 0;
+    }
 
     /**
      * @brief Get all keys currently in the cache.
@@ -81,8 +123,32 @@ public:
         return keys;
     }
 
+    /**
+     * @brief Snapshot of hit/miss counters, resident and peak bytes, and decode time saved.
+     * @return Current counters.
+     */
+    CacheStatsSnapshot stats() const override {
+        CacheStatsSnapshot s = counters.snapshot();
+        s.residentBytes = bytes;
+        s.peakBytes = peakBytes;
+        return s;
+    }
+
+    /**
+     * @brief Remember the decode cost of a cached image, credited on later isCached hits.
+     * @param key Key of the cached image.
+     * @param cost Time spent decoding it.
+     */
+    void noteDecodeCost(const std::string& key, std::chrono::nanoseconds cost) override {
+        if (map.count(key)) decodeCosts[key] = cost;
+    }
+
 private:
     ImageMap map; ///< Internal map storing cached images.
+    std::unordered_map<std::string, std::chrono::nanoseconds> decodeCosts; ///< Recorded decode time per key.
+    size_t bytes = 0; ///< Bytes of cached image data.
+    size_t peakBytes = 0; ///< Highest value of bytes.
+    mutable CacheStats counters; ///< Updated by const lookups too.
 };
 
 /**
@@ -105,14 +171,49 @@ public:
      */
     ImageType loadFromFile(const std::string& path) override;
 
+    /**
+     * @brief Decode an image from encoded bytes in memory.
+     * 
+     * Throws unless specialized for the ImageType.
+     * 
+     * @param bytes Encoded image bytes.
+     * @return Decoded image.
+     */
+    ImageType loadFromBuffer(const std::vector<unsigned char>& bytes) override {
+        return ImageLoader<ImageType>::loadFromBuffer(bytes);
+    }
+
+    /**
+     * @brief Load an image from a file at reduced resolution.
+     * 
+     * Falls back to loadFromFile unless specialized for the ImageType.
+     * 
+     * @param path Path to the image file.
+     * @param options Requested reduction.
+     * @return Loaded image.
+     */
+    ImageType loadScaled(const std::string& path, const DecodeOptions& options) override {
+        (void)options;
+        return loadFromFile(path);
+    }
+
     /**
      * @brief Load an image from a file and cache it.
+     * Caches that accept encoded images receive the file bytes without decoding.
      * @param cache Cache manager to store the loaded image.
      * @param path Path to the image file.
      * @param key Key to store the image under in the cache.
      */
     void loadIntoCache(CacheManager<ImageType>& cache, const std::string& path, const std::string& key) override {
-        cache.cacheImage(key, loadFromFile(path));
+        if (cache.acceptsEncoded()) {
+            cache.cacheEncoded(key, readFileBytes(path));
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        ImageType image = loadFromFile(path);
+        auto cost = std::chrono::steady_clock::now() - start;
+        cache.cacheImage(key, image);
+        cache.noteDecodeCost(key, std::chrono::duration_cast<std::chrono::nanoseconds>(cost));
     }
 
     /**
@@ -180,6 +281,15 @@ class DefaultImageSaver : public ImageSaver<ImageType> {
 public:
     using ImageMap = std::unordered_map<std::string, ImageType>;
 
+    /**
+     * @brief Construct a new DefaultImageSaver.
+     * 
+     * @param ioWorkers Number of threads saveAll and saveMany encode and write with. Kept separate from
+     *                  compute threads so the disk is not oversubscribed. 0 selects the
+     *                  hardware concurrency. With more than one, save() and encode() must be thread-safe.
+     */
+    explicit DefaultImageSaver(size_t ioWorkers = 1) : ioWorkers(ioWorkers) {}
+
     /**
      * @brief Save a single image to a file.
      * 
@@ -191,41 +301,238 @@ public:
     void save(const std::string& outputPath, const ImageType& image) override;
 
     /**
-     * @brief Save multiple images into an output directory.
+     * @brief Save a single image to a file with the given encoder settings.
      * 
-     * If image keys do not have extensions, ".jpg" is appended.
+     * Ignores the encoder settings unless specialized for the ImageType.
+     * 
+     * @param outputPath Output file path.
+     * @param image Image to save.
+     * @param profile Encoder settings.
+     */
+    void save(const std::string& outputPath, const ImageType& image, const EncodeProfile& profile) override {
+        (void)profile;
+        save(outputPath, image);
+    }
+
+    /**
+     * @brief Save multiple images into an output directory with default encoder settings.
      * 
      * @param images Map of image keys to images.
      * @param outputDir Directory to save images into.
+     * @throws std::runtime_error naming the first image that failed, after trying them all.
      */
     void saveAll(const ImageMap& images, const std::string& outputDir) override {
+        BatchReport report = saveAllReport(images, outputDir);
+        if (!report.ok()) throw std::runtime_error("Failed to save " + report.failed.front().key + ": " + report.failed.front().error);
+    }
+
+    /**
+     * @brief Save multiple images into an output directory with default encoder settings.
+     * 
+     * @param images Map of image keys to images.
+     * @param outputDir Directory to save images into.
+     * @return Keys saved and keys that failed, with their error.
+     */
+    BatchReport saveAllReport(const ImageMap& images, const std::string& outputDir) override {
+        return saveAll(images, outputDir, EncodeProfile{});
+    }
+
+    /**
+     * @brief Save multiple images into an output directory.
+     * 
+     * If image keys do not have extensions, ".jpg" is appended; the profile's format
+     * override replaces the extension.
+     * Images are saved on up to ioWorkers threads; a failing image does not stop the others.
+     * 
+     * @param images Map of image keys to images.
+     * @param outputDir Directory to save images into.
+     * @param profile Encoder settings.
+     * @return Keys saved and keys that failed, with their error.
+     */
+    BatchReport saveAll(const ImageMap& images, const std::string& outputDir, const EncodeProfile& profile) override {
         namespace fs = std::filesystem;
-        for (const auto& [key, img] : images) {
+        BatchReport report;
+        std::mutex reportMutex;
+        std::vector<const typename ImageMap::value_type*> entries;
+        entries.reserve(images.size());
+        for (const auto& entry : images) entries.push_back(&entry);
+
+        runParallel(entries.size(), [&](size_t i) {
+            const auto& [key, img] = *entries[i];
             fs::path p(key);
-            std::string filename = p.extension().empty() ? (key + ".jpg") : key;
+            std::string filename = profile.applyFormat(p.extension().empty() ? (key + ".jpg") : key);
             fs::path outPath = fs::path(outputDir) / filename;
-            save(outPath.string(), img);
-        }
+            try {
+                save(outPath.string(), img, profile);
+                std::lock_guard<std::mutex> lock(reportMutex);
+                report.succeeded.push_back(key);
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(reportMutex);
+                report.failed.push_back({key, e.what()});
+            }
+        });
+        return report;
+    }
+
+    /**
+     * @brief Save an image into a custom subdirectory with default encoder settings.
+     * 
+     * @param image Image to save.
+     * @param outputDir Root output directory.
+     * @param customSubdir Custom subdirectory name.
+     * @param key Key representing the image filename.
+     */
+    void saveAs(const ImageType& image, const std::string& outputDir, const std::string& customSubdir, const std::string& key) override {
+        saveAs(image, outputDir, customSubdir, key, EncodeProfile{});
     }
 
     /**
      * @brief Save an image into a custom subdirectory inside the output directory.
      * 
-     * If key does not have an extension, ".jpg" is appended.
+     * If key does not have an extension, ".jpg" is appended; the profile's format
+     * override replaces the extension.
      * 
      * @param image Image to save.
      * @param outputDir Root output directory.
      * @param customSubdir Custom subdirectory name.
      * @param key Key representing the image filename.
+     * @param profile Encoder settings.
      */
-    void saveAs(const ImageType& image, const std::string& outputDir, const std::string& customSubdir, const std::string& key) override {
+    void saveAs(const ImageType& image, const std::string& outputDir, const std::string& customSubdir, const std::string& key, const EncodeProfile& profile) override {
         namespace fs = std::filesystem;
         fs::path keyPath(key);
         std::string filename = keyPath.filename().string();
         if (keyPath.extension().empty()) filename += ".jpg";
-        fs::path outPath = fs::path(outputDir) / customSubdir / filename;
-        save(outPath.string(), image);
+        fs::path outPath = fs::path(outputDir) / customSubdir / profile.applyFormat(filename);
+        save(outPath.string(), image, profile);
+    }
+
+    /**
+     * @brief Whether encode() is supported. false unless specialized for the ImageType.
+     */
+    bool supportsEncode() const override { return false; }
+
+    /**
+     * @brief Encode an image into memory.
+     * 
+     * Throws unless specialized for the ImageType.
+     * 
+     * @param image Image to encode.
+     * @param extension Format as a file extension (e.g. ".jpg").
+     * @param profile Encoder settings.
+     * @return Encoded file contents.
+     */
+    std::vector<unsigned char> encode(const ImageType& image, const std::string& extension, const EncodeProfile& profile) override {
+        return ImageSaver<ImageType>::encode(image, extension, profile);
     }
+
+    /**
+     * @brief Save one image to several destinations, encoding each distinct format/profile once.
+     * 
+     * Encodes and writes run on up to ioWorkers threads. Falls back to one save per
+     * destination if encode() is not supported.
+     * 
+     * @param image Image to save.
+     * @param outputDir Root output directory.
+     * @param key Key representing the image filename.
+     * @param targets Destinations; an unset profile means default encoder settings.
+     * @return Output paths (relative to outputDir) saved and failed.
+     */
+    BatchReport saveMany(const ImageType& image, const std::string& outputDir, const std::string& key, const std::vector<SaveTarget>& targets) override {
+        namespace fs = std::filesystem;
+        if (!supportsEncode()) return ImageSaver<ImageType>::saveMany(image, outputDir, key, targets);
+
+        // Destinations sharing a format and encoder settings share one encode
+        struct Encoding {
+            std::string extension;
+            EncodeProfile profile;
+            std::vector<std::string> destinations; ///< Relative to outputDir
+            std::vector<unsigned char> bytes;
+            std::string error;
+        };
+        std::vector<Encoding> encodings;
+        for (const auto& target : targets) {
+            std::string relative = (fs::path(target.subdir) / target.filenameFor(key)).generic_string();
+            std::string extension = fs::path(relative).extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            EncodeProfile profile = target.profile.value_or(EncodeProfile{});
+            profile.format.clear(); // already applied to the destination
+            auto it = std::find_if(encodings.begin(), encodings.end(), [&](const Encoding& e) {
+                return e.extension == extension && e.profile == profile;
+            });
+            if (it == encodings.end()) it = encodings.insert(encodings.end(), Encoding{extension, profile, {}, {}, {}});
+            it->destinations.push_back(relative);
+        }
+
+        runParallel(encodings.size(), [&](size_t i) {
+            try {
+                encodings[i].bytes = encode(image, encodings[i].extension, encodings[i].profile);
+            } catch (const std::exception& e) {
+                encodings[i].error = e.what();
+            }
+        });
+
+        BatchReport report;
+        std::vector<std::pair<const Encoding*, const std::string*>> writes;
+        for (const auto& encoding : encodings)
+            for (const auto& destination : encoding.destinations) {
+                if (encoding.error.empty()) writes.emplace_back(&encoding, &destination);
+                else report.failed.push_back({destination, encoding.error});
+            }
+
+        std::mutex reportMutex;
+        runParallel(writes.size(), [&](size_t i) {
+            const auto& [encoding, destination] = writes[i];
+            std::string outPath = (fs::path(outputDir) / *destination).string();
+            try {
+                ensureParentDirectory(outPath);
+                writeFileBytes(outPath, encoding->bytes);
+                std::lock_guard<std::mutex> lock(reportMutex);
+                report.succeeded.push_back(*destination);
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(reportMutex);
+                report.failed.push_back({*destination, e.what()});
+            }
+        });
+        return report;
+    }
+
+protected:
+    /**
+     * @brief Create the parent directory of a file unless it is known to exist.
+     * 
+     * Directories created (or found) once are remembered, so repeated saves into the same
+     * folder skip the filesystem calls. Thread-safe.
+     * 
+     * @param outputPath Path of the file about to be written.
+     */
+    void ensureParentDirectory(const std::string& outputPath) {
+        std::string dir = std::filesystem::path(outputPath).parent_path().string();
+        if (dir.empty()) return;
+        std::lock_guard<std::mutex> lock(directoriesMutex);
+        if (knownDirectories.count(dir)) return;
+        std::filesystem::create_directories(dir);
+        knownDirectories.insert(dir);
+    }
+
+private:
+    // Run fn(0..count-1) on up to ioWorkers threads (inline if only one is needed)
+    template <typename Fn>
+    void runParallel(size_t count, Fn fn) {
+        size_t workers = std::min(ioWorkers == 0 ? ThreadPool::defaultConcurrency() : ioWorkers, count);
+        if (workers <= 1) {
+            for (size_t i = 0; i < count; ++i) fn(i);
+            return;
+        }
+        ThreadPool pool(workers, workers * 2);
+        for (size_t i = 0; i < count; ++i)
+            pool.submit([&fn, i] { fn(i); });
+        pool.wait();
+    }
+
+    size_t ioWorkers; ///< Threads used by saveAll and saveMany.
+    std::mutex directoriesMutex; ///< Guards knownDirectories.
+    std::unordered_set<std::string> knownDirectories; ///< Output directories known to exist.
 };
 
 } // namespace pipeline
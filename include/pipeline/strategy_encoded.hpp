@@ -0,0 +1,203 @@
+#pragma once
+
+#include "pipeline/strategy.hpp"
+#include "pipeline/strategy_default.hpp"
+#include <functional>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace pipeline {
+
+/**
+ * @brief Cache that keeps images as their encoded file bytes and decodes on access.
+ * 
+ * Loaders hand it the original JPEG/PNG bytes (see acceptsEncoded/cacheEncoded), which are
+ * typically 10-30x smaller than the decoded pixels. getCached/getCachedShallow decode on
+ * demand; an optional LRU hot set keeps the most recently decoded images to avoid repeated
+ * decodes of the same key.
+ * 
+ * Images handed over already decoded (cacheImage, e.g. Pipeline::load(image, name)) are
+ * encoded with the optional encode function, or kept decoded if none is given.
+ * 
+ * @tparam ImageType The image data type stored in the cache.
+ */
+template <typename ImageType>
+class EncodedCacheManager : public CacheManager<ImageType> {
+public:
+    using DecodeFn = std::function<ImageType(const std::vector<unsigned char>&)>;
+    using EncodeFn = std::function<std::vector<unsigned char>(const ImageType&)>;
+
+    /**
+     * @brief Construct a new EncodedCacheManager.
+     * 
+     * @param hotCapacity Number of decoded images kept on top of the encoded bytes (0 = none).
+     * @param decode Decoder for cached bytes. Defaults to DefaultImageLoader::loadFromBuffer.
+     * @param encode Optional encoder for images cached already decoded.
+     */
+    explicit EncodedCacheManager(size_t hotCapacity = 0, DecodeFn decode = nullptr, EncodeFn encode = nullptr)
+        : hotCapacity_(hotCapacity)
+        , decode_(decode != nullptr ? std::move(decode) : [](const std::vector<unsigned char>& bytes) { return DefaultImageLoader<ImageType>().loadFromBuffer(bytes); })
+        , encode_(std::move(encode)) {}
+
+    /**
+     * @brief This cache prefers encoded file contents.
+     */
+    bool acceptsEncoded() const override { return true; }
+
+    /**
+     * @brief Cache encoded bytes under a key, replacing any previous entry.
+     * 
+     * @param key The unique string key identifying the image.
+     * @param bytes Encoded image bytes.
+     */
+    void cacheEncoded(const std::string& key, std::vector<unsigned char> bytes) override {
+        remove(key);
+        encodedBytes_ += bytes.size();
+        entries_[key].bytes = std::move(bytes);
+    }
+
+    /**
+     * @brief Cache a decoded image, encoding it if an encoder was given.
+     * 
+     * @param key The unique string key identifying the image.
+     * @param image The image data to cache.
+     */
+    void cacheImage(const std::string& key, const ImageType& image) override {
+        if (encode_) {
+            cacheEncoded(key, encode_(image));
+            return;
+        }
+        remove(key);
+        entries_[key].decoded = image;
+    }
+
+    /**
+     * @brief Check if an image identified by key is cached.
+     * 
+     * @param key The key to query.
+     * @return true if the image is cached, false otherwise.
+     */
+    bool isCached(const std::string& key) const override {
+        return entries_.find(key) != entries_.end();
+    }
+
+    /**
+     * @brief Retrieve a cached image by key (deep copy), decoding it if not in the hot set.
+     * 
+     * @param key The key identifying the cached image.
+     * @return ImageType The decoded image.
+     * @throws std::runtime_error if the key is not found or decoding fails.
+     */
+    ImageType getCached(const std::string& key) const override {
+        auto hot = hot_.find(key);
+        if (hot != hot_.end()) {
+            hotOrder_.splice(hotOrder_.begin(), hotOrder_, hot->second.second);
+            return hot->second.first.clone();
+        }
+        const Entry& entry = findEntry(key);
+        if (entry.decoded) return entry.decoded->clone();
+        ImageType image = decode_(entry.bytes);
+        promote(key, image);
+        return hotCapacity_ > 0 ? image.clone() : image; // Don't alias the promoted copy
+    }
+
+    /**
+     * @brief Retrieve a cached image by key without copying the hot-set or pinned image.
+     * 
+     * @param key The key identifying the cached image.
+     * @return ImageType The decoded image (shallow copy where possible).
+     * @throws std::runtime_error if the key is not found or decoding fails.
+     */
+    ImageType getCachedShallow(const std::string& key) const override {
+        auto hot = hot_.find(key);
+        if (hot != hot_.end()) {
+            hotOrder_.splice(hotOrder_.begin(), hotOrder_, hot->second.second);
+            return hot->second.first;
+        }
+        const Entry& entry = findEntry(key);
+        if (entry.decoded) return *entry.decoded;
+        ImageType image = decode_(entry.bytes);
+        promote(key, image);
+        return image;
+    }
+
+    /**
+     * @brief Remove an image from the cache by key.
+     * 
+     * @param key The key of the image to remove.
+     */
+    void remove(const std::string& key) override {
+        auto it = entries_.find(key);
+        if (it == entries_.end()) return;
+        encodedBytes_ -= it->second.bytes.size();
+        entries_.erase(it);
+        auto hot = hot_.find(key);
+        if (hot != hot_.end()) {
+            hotOrder_.erase(hot->second.second);
+            hot_.erase(hot);
+        }
+    }
+
+    /**
+     * @brief Clear all cached images.
+     */
+    void clear() override {
+        entries_.clear();
+        hot_.clear();
+        hotOrder_.clear();
+        encodedBytes_ = 0;
+    }
+
+    /**
+     * @brief Get a list of all keys currently cached.
+     * 
+     * @return std::vector<std::string> Vector of cached keys.
+     */
+    std::vector<std::string> getKeys() const override {
+        std::vector<std::string> keys;
+        for (const auto& [k, _] : entries_) keys.push_back(k);
+        return keys;
+    }
+
+    /**
+     * @brief Total size of the encoded bytes held.
+     */
+    size_t encodedBytes() const { return encodedBytes_; }
+
+private:
+    struct Entry {
+        std::vector<unsigned char> bytes;  ///< Encoded image, empty if kept decoded
+        std::optional<ImageType> decoded;  ///< Set for images cached decoded without an encoder
+    };
+
+    const Entry& findEntry(const std::string& key) const {
+        auto it = entries_.find(key);
+        if (it == entries_.end()) throw std::runtime_error("Key not found in cache: " + key);
+        return it->second;
+    }
+
+    // Insert a freshly decoded image into the hot set, evicting the least recently used one
+    void promote(const std::string& key, const ImageType& image) const {
+        if (hotCapacity_ == 0) return;
+        if (hot_.size() == hotCapacity_) {
+            hot_.erase(hotOrder_.back());
+            hotOrder_.pop_back();
+        }
+        hotOrder_.push_front(key);
+        hot_[key] = {image, hotOrder_.begin()};
+    }
+
+    size_t hotCapacity_; ///< Maximum number of decoded images in the hot set
+    DecodeFn decode_;
+    EncodeFn encode_;
+    std::unordered_map<std::string, Entry> entries_; ///< Key to encoded (or pinned decoded) image
+    size_t encodedBytes_ = 0;
+    mutable std::list<std::string> hotOrder_; ///< Hot set usage order: front = most recently used
+    mutable std::unordered_map<std::string, std::pair<ImageType, typename std::list<std::string>::iterator>> hot_; ///< Decoded hot set
+};
+
+} // namespace pipeline
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "pipeline/strategy.hpp"
+#include "pipeline/image_traits.hpp"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
 #include <list>
 #include <unordered_map>
 #include <string>
@@ -9,17 +14,28 @@
 
 namespace pipeline {
 
+/**
+ * @brief Capacity of a cache expressed in bytes of image data rather than a number of images.
+ */
+struct ByteBudget {
+    size_t bytes; ///< Maximum total size of the cached images.
+};
+
 /**
  * @brief LRU (Least Recently Used) cache implementation for images.
  * 
- * This cache stores a fixed number of images identified by string keys.
- * When the capacity is exceeded, the least recently used image is evicted.
+ * This cache stores a fixed number of images identified by string keys, or images up to a
+ * total size (see ByteBudget). When the capacity is exceeded, the least recently used
+ * images are evicted.
  * 
  * @tparam ImageType The image data type stored in the cache.
+ * @tparam Traits Provides byteSize(image), used to size entries. Defaults to ImageTraits.
  */
-template <typename ImageType>
+template <typename ImageType, typename Traits = ImageTraits<ImageType>>
 class LRUCacheManager : public CacheManager<ImageType> {
 public:
+    using EvictionListener = std::function<void(const std::string& key, const ImageType& image)>;
+
     /**
      * @brief Construct a new LRUCacheManager with given capacity.
      * 
@@ -27,6 +43,18 @@ public:
      */
     explicit LRUCacheManager(size_t capacity) : capacity_(capacity) {}
 
+    /**
+     * @brief Construct a new LRUCacheManager bounded by the total size of its images.
+     * 
+     * Entries are sized with Traits::byteSize (for cv::Mat, total() * elemSize()). After an
+     * insert, least recently used images are evicted until the total fits the budget; an image
+     * larger than the whole budget is still kept, alone, until the next insert.
+     * 
+     * @param budget Maximum bytes of cached image data.
+     */
+    explicit LRUCacheManager(ByteBudget budget)
+        : capacity_(std::numeric_limits<size_t>::max()), maxBytes_(budget.bytes) {}
+
     /**
      * @brief Cache an image with the associated key.
      * 
@@ -39,17 +67,19 @@ public:
     void cacheImage(const std::string& key, const ImageType& image) override {
         auto it = map_.find(key);
         if (it != map_.end()) {
+            bytes_ -= Traits::byteSize(it->second.first);
             it->second.first = image;
             usage_.splice(usage_.begin(), usage_, it->second.second);
         } else {
-            if (map_.size() == capacity_) {
-                const std::string& lruKey = usage_.back();
-                map_.erase(lruKey);
-                usage_.pop_back();
-            }
+            if (!map_.empty() && map_.size() >= capacity_) evictLeastRecent();
             usage_.push_front(key);
             map_[key] = {image, usage_.begin()};
         }
+        decodeCosts_.erase(key);
+        counters_.recordInsertion();
+        bytes_ += Traits::byteSize(image);
+        while (bytes_ > maxBytes_ && map_.size() > 1) evictLeastRecent();
+        peakBytes_ = std::max(peakBytes_, bytes_);
     }
 
     /**
@@ -59,7 +89,14 @@ public:
      * @return true if the image is cached, false otherwise.
      */
     bool isCached(const std::string& key) const override {
-        return map_.find(key) != map_.end();
+        if (map_.find(key) == map_.end()) {
+            counters_.recordMiss(CacheOp::IsCached);
+            return false;
+        }
+        counters_.recordHit(CacheOp::IsCached);
+        auto cost = decodeCosts_.find(key);
+        if (cost != decodeCosts_.end()) counters_.recordDecodeSaved(cost->second);
+        return true;
     }
 
     /**
@@ -73,7 +110,11 @@ public:
      */
     ImageType getCached(const std::string& key) const override {
         auto it = map_.find(key);
-        if (it == map_.end()) throw std::runtime_error("Key not found in cache: " + key);
+        if (it == map_.end()) {
+            counters_.recordMiss(CacheOp::Get);
+            throw std::runtime_error("Key not found in cache: " + key);
+        }
+        counters_.recordHit(CacheOp::Get);
         usage_.splice(usage_.begin(), usage_, it->second.second);
         return it->second.first.clone();
     }
@@ -89,7 +130,11 @@ public:
      */
     ImageType getCachedShallow(const std::string& key) const override {
         auto it = map_.find(key);
-        if (it == map_.end()) throw std::runtime_error("Key not found in cache: " + key);
+        if (it == map_.end()) {
+            counters_.recordMiss(CacheOp::GetShallow);
+            throw std::runtime_error("Key not found in cache: " + key);
+        }
+        counters_.recordHit(CacheOp::GetShallow);
         usage_.splice(usage_.begin(), usage_, it->second.second);
         return it->second.first;
     }
@@ -104,8 +149,10 @@ public:
     void remove(const std::string& key) override {
         auto it = map_.find(key);
         if (it != map_.end()) {
+            bytes_ -= Traits::byteSize(it->second.first);
             usage_.erase(it->second.second);
             map_.erase(it);
+            decodeCosts_.erase(key);
         }
     }
 
@@ -115,6 +162,8 @@ public:
     void clear() override {
         map_.clear();
         usage_.clear();
+        decodeCosts_.clear();
+        bytes_ = 0;
     }
 
     /**
@@ -128,8 +177,63 @@ public:
         return keys;
     }
 
+    /**
+     * @brief Total size of the cached images, as measured by Traits::byteSize.
+     */
+    size_t currentBytes() const { return bytes_; }
+
+    /**
+     * @brief Highest value currentBytes() has reached.
+     */
+    size_t peakBytes() const { return peakBytes_; }
+
+    /**
+     * @brief Call a function with each image evicted to make room, just before it is dropped.
+     * 
+     * Not called for remove() or clear(). Used by SpillCacheManager to move evicted images to disk.
+     * 
+     * @param listener Receives the key and image; nullptr to stop listening.
+     */
+    void setEvictionListener(EvictionListener listener) { onEvict_ = std::move(listener); }
+
+    /**
+     * @brief Snapshot of hit/miss/eviction counters, resident and peak bytes, and decode time saved.
+     * @return Current counters.
+     */
+    CacheStatsSnapshot stats() const override {
+        CacheStatsSnapshot s = counters_.snapshot();
+        s.residentBytes = bytes_;
+        s.peakBytes = peakBytes_;
+        return s;
+    }
+
+    /**
+     * @brief Remember the decode cost of a cached image, credited on later isCached hits.
+     * @param key Key of the cached image.
+     * @param cost Time spent decoding it.
+     */
+    void noteDecodeCost(const std::string& key, std::chrono::nanoseconds cost) override {
+        if (map_.count(key)) decodeCosts_[key] = cost;
+    }
+
 private:
+    void evictLeastRecent() {
+        auto it = map_.find(usage_.back());
+        if (onEvict_) onEvict_(it->first, it->second.first);
+        bytes_ -= Traits::byteSize(it->second.first);
+        decodeCosts_.erase(it->first);
+        map_.erase(it);
+        usage_.pop_back();
+        counters_.recordEviction();
+    }
+
     size_t capacity_; ///< Maximum cache size
+    size_t maxBytes_ = std::numeric_limits<size_t>::max(); ///< Maximum total bytes
+    size_t bytes_ = 0; ///< Current total bytes
+    size_t peakBytes_ = 0; ///< Highest total bytes seen
+    std::unordered_map<std::string, std::chrono::nanoseconds> decodeCosts_; ///< Recorded decode time per key
+    mutable CacheStats counters_; ///< Updated by const lookups too
+    EvictionListener onEvict_; ///< Notified before each eviction
     mutable std::list<std::string> usage_; ///< Tracks usage order: front = most recently used
     mutable std::unordered_map<std::string, std::pair<ImageType, typename std::list<std::string>::iterator>> map_; ///< Key to image and usage iterator
 };
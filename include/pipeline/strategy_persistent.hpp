@@ -0,0 +1,476 @@
+#pragma once
+
+#include "pipeline/strategy.hpp"
+#include "pipeline/strategy_default.hpp"
+#include "pipeline/image_traits.hpp"
+#include "pipeline/mapped_file.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace pipeline {
+
+/**
+ * @brief Options for PersistentCacheManager.
+ */
+struct PersistentCacheOptions {
+    bool verifyContent = false;  ///< Also compare a hash of the source file, not just its size and mtime.
+    bool warmOnStart = true;     ///< Load the images accessed by the previous run into memory when constructed.
+    size_t warmLimit = 1024;     ///< Maximum images loaded by warming; warming also stops once the memory tier evicts.
+    uint64_t maxDiskBytes = uint64_t(8) << 30; ///< Total size of the raw files; least recently used ones are deleted first.
+};
+
+/**
+ * @brief Cache decorator that keeps decoded images across runs, in a local cache directory.
+ *
+ * Keys are paths relative to `inputRoot` (the pipeline's input folder). Every image cached
+ * under a key naming an existing file is also written as raw pixels (Traits::writeRaw) to the
+ * cache directory, together with the source's size and modification time (and a content hash
+ * with verifyContent). In a later run, a key missing from the memory tier is served from
+ * the cache directory as long as its source file is unchanged, skipping the decode.
+ *
+ * Raw files are named by a hash of their key and end with the key itself, which is checked
+ * when the file is read, so a hash collision is a miss rather than the wrong image. Their
+ * total size is bounded (PersistentCacheOptions::maxDiskBytes); the least recently used are
+ * deleted first.
+ *
+ * Each run records which keys it used; the next run preloads them into the memory tier
+ * (see PersistentCacheOptions::warmOnStart). remove() and clear() only affect the memory tier,
+ * since entries on disk are validated against their source; use purge() to delete them.
+ *
+ * Images cached under a key that names a file must be that file's decoded contents.
+ * Types whose Traits cannot write raw files (the primary ImageTraits) are not persisted.
+ *
+ * @tparam ImageType The image data type stored in the cache.
+ * @tparam Traits Provides writeRaw and readRaw. Defaults to ImageTraits.
+ */
+template <typename ImageType, typename Traits = ImageTraits<ImageType>>
+class PersistentCacheManager : public CacheManager<ImageType> {
+public:
+    /**
+     * @brief Open (or create) a persistent cache.
+     *
+     * @param memory In-memory tier. Defaults to DefaultCacheManager.
+     * @param inputRoot Directory that keys are relative to.
+     * @param cacheDir Directory holding the raw images, the entry journal and the access log.
+     * @param options Validation and warming options.
+     */
+    PersistentCacheManager(std::unique_ptr<CacheManager<ImageType>> memory, std::string inputRoot,
+                           std::string cacheDir, PersistentCacheOptions options = {})
+        : memory_(memory != nullptr ? std::move(memory) : std::make_unique<DefaultCacheManager<ImageType>>())
+        , inputRoot_(std::move(inputRoot))
+        , cacheDir_(std::move(cacheDir))
+        , options_(options) {
+        std::filesystem::create_directories(cacheDir_);
+        loadJournal();
+        std::vector<std::string> previousRun = readLines(cacheDir_ / "access.log");
+        accessLog_.open(cacheDir_ / "access.log", std::ios::trunc);
+        if (options_.warmOnStart) warm(previousRun);
+    }
+
+    PersistentCacheManager(const PersistentCacheManager&) = delete;
+    PersistentCacheManager& operator=(const PersistentCacheManager&) = delete;
+
+    /**
+     * @brief Cache an image in memory and, if its key names a file under inputRoot, on disk.
+     * @param key The unique string key identifying the image.
+     * @param image The image data to cache.
+     */
+    void cacheImage(const std::string& key, const ImageType& image) override {
+        counters_.recordInsertion();
+        memory_->cacheImage(key, image);
+        persist(key, image);
+        logAccess(key);
+    }
+
+    /**
+     * @brief Check if an image is in memory or stored on disk for the current version of its file.
+     * @param key The key to query.
+     * @return true if the image is cached, false otherwise.
+     */
+    bool isCached(const std::string& key) const override {
+        if (memory_->isCached(key)) {
+            counters_.recordHit(CacheOp::IsCached);
+            logAccess(key);
+            return true;
+        }
+        if (const Entry* entry = validEntry(key)) {
+            counters_.recordHit(CacheOp::IsCached);
+            counters_.recordDecodeSaved(entry->decodeCost);
+            logAccess(key);
+            return true;
+        }
+        counters_.recordMiss(CacheOp::IsCached);
+        return false;
+    }
+
+    /**
+     * @brief Retrieve a cached image (deep copy), reading it from disk into memory if needed.
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image.
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCached(const std::string& key) const override {
+        return fetch(key, CacheOp::Get).clone();
+    }
+
+    /**
+     * @brief Retrieve a cached image without copying, reading it from disk into memory if needed.
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image (shallow copy).
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCachedShallow(const std::string& key) const override {
+        return fetch(key, CacheOp::GetShallow);
+    }
+
+    /**
+     * @brief Remove an image from the memory tier. The copy on disk is kept.
+     * @param key The key of the image to remove.
+     */
+    void remove(const std::string& key) override { memory_->remove(key); }
+
+    /**
+     * @brief Clear the memory tier. Images on disk are kept.
+     */
+    void clear() override { memory_->clear(); }
+
+    /**
+     * @brief Get the keys held in the memory tier.
+     * @return std::vector<std::string> Vector of cached keys.
+     */
+    std::vector<std::string> getKeys() const override { return memory_->getKeys(); }
+
+    /**
+     * @brief Delete every image stored on disk (the memory tier is kept).
+     */
+    void purge() {
+        std::error_code ec;
+        for (const auto& [key, entry] : index_) std::filesystem::remove(rawPath(key), ec);
+        index_.clear();
+        validated_.clear();
+        diskUsage_.clear();
+        diskBytes_ = 0;
+        journal_.close();
+        journal_.open(cacheDir_ / "entries.log", std::ios::trunc);
+    }
+
+    /**
+     * @brief Load images into the memory tier from disk, skipping missing or stale ones.
+     *
+     * Stops after PersistentCacheOptions::warmLimit images, or as soon as the memory tier
+     * evicts: further images would only push out the ones just loaded.
+     *
+     * @param keys Keys to load, most important first.
+     * @return Number of images loaded.
+     */
+    size_t warm(const std::vector<std::string>& keys) {
+        size_t loaded = 0;
+        uint64_t evictions = memory_->stats().evictions;
+        for (const auto& key : keys) {
+            if (loaded >= options_.warmLimit || memory_->stats().evictions != evictions) break;
+            if (!fromMemory(key) && validEntry(key) && readIntoMemory(key)) ++loaded;
+        }
+        return loaded;
+    }
+
+    /**
+     * @brief Number of images read from disk instead of being decoded.
+     */
+    uint64_t diskHits() const { return diskHits_; }
+
+    /**
+     * @brief Total size of the raw files currently stored.
+     */
+    uint64_t diskBytes() const { return diskBytes_; }
+
+    /**
+     * @brief Counters of this cache as a whole; decode time saved includes images read from disk.
+     * @return Current counters.
+     */
+    CacheStatsSnapshot stats() const override {
+        CacheStatsSnapshot s = counters_.snapshot();
+        CacheStatsSnapshot memory = memory_->stats();
+        s.residentBytes = memory.residentBytes;
+        s.peakBytes = memory.peakBytes;
+        s.decodeTimeSaved += memory.decodeTimeSaved;
+        return s;
+    }
+
+    /**
+     * @brief Remember the decode cost of an image, in memory and in the stored entry.
+     * @param key Key of the cached image.
+     * @param cost Time spent decoding it.
+     */
+    void noteDecodeCost(const std::string& key, std::chrono::nanoseconds cost) override {
+        memory_->noteDecodeCost(key, cost);
+        auto it = index_.find(key);
+        if (it == index_.end()) return;
+        it->second.decodeCost = cost;
+        appendJournal(key, it->second);
+    }
+
+private:
+    /// Version of a source file; an entry is only valid for the version it was stored from.
+    struct Fingerprint {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        uint64_t hash = 0; ///< 0 unless verifyContent
+        bool operator==(const Fingerprint&) const = default;
+    };
+
+    struct Entry {
+        Fingerprint source;
+        std::chrono::nanoseconds decodeCost{0};
+        uint64_t bytes = 0; ///< Size of the raw file
+        std::list<std::string>::iterator position; ///< In diskUsage_
+    };
+
+    static constexpr uint32_t kKeyTrailerMagic = 0x594B5850u; // "PXKY": raw file ends with key, key length, magic
+
+    static uint64_t fnv1a(const unsigned char* data, size_t size, uint64_t hash = 0xCBF29CE484222325ull) {
+        for (size_t i = 0; i < size; ++i) hash = (hash ^ data[i]) * 0x100000001B3ull;
+        return hash;
+    }
+
+    std::optional<Fingerprint> fingerprint(const std::string& key) const {
+        std::filesystem::path path = std::filesystem::path(inputRoot_) / key;
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(path, ec)) return std::nullopt;
+        Fingerprint fp;
+        fp.size = std::filesystem::file_size(path, ec);
+        fp.mtime = static_cast<int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+        if (ec) return std::nullopt;
+        if (options_.verifyContent) {
+            MappedFile file(path.string());
+            if (file.valid()) {
+                fp.hash = fnv1a(file.data(), file.size());
+            } else {
+                std::vector<unsigned char> bytes = readFileBytes(path.string());
+                fp.hash = fnv1a(bytes.data(), bytes.size());
+            }
+        }
+        return fp;
+    }
+
+    std::filesystem::path rawPath(const std::string& key) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.raw",
+                      static_cast<unsigned long long>(fnv1a(reinterpret_cast<const unsigned char*>(key.data()), key.size())));
+        return cacheDir_ / name;
+    }
+
+    // Stored entry for the key if it matches the current version of its file (checked once per run)
+    const Entry* validEntry(const std::string& key) const {
+        auto it = index_.find(key);
+        if (it == index_.end()) return nullptr;
+        if (validated_.count(key)) return &it->second;
+        std::optional<Fingerprint> current = fingerprint(key);
+        if (!current || !(*current == it->second.source)) return nullptr;
+        validated_.insert(key);
+        return &it->second;
+    }
+
+    // Raw pixels of the file if it was written for this key (see appendKey)
+    static std::optional<ImageType> readKeyed(const MappedFile& file, const std::string& key) {
+        if (!file.valid() || file.size() < 8) return std::nullopt;
+        uint32_t keyLength = 0, magic = 0;
+        std::memcpy(&keyLength, file.data() + file.size() - 8, 4);
+        std::memcpy(&magic, file.data() + file.size() - 4, 4);
+        if (magic != kKeyTrailerMagic || keyLength != key.size() || file.size() - 8 < keyLength) return std::nullopt;
+        size_t pixels = file.size() - 8 - keyLength;
+        if (std::memcmp(file.data() + pixels, key.data(), keyLength) != 0) return std::nullopt;
+        return Traits::readRaw(file.data(), pixels);
+    }
+
+    static bool appendKey(const std::filesystem::path& path, const std::string& key) {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        uint32_t keyLength = static_cast<uint32_t>(key.size());
+        out.write(key.data(), static_cast<std::streamsize>(key.size()));
+        out.write(reinterpret_cast<const char*>(&keyLength), 4);
+        out.write(reinterpret_cast<const char*>(&kKeyTrailerMagic), 4);
+        return static_cast<bool>(out.flush());
+    }
+
+    std::optional<ImageType> readIntoMemory(const std::string& key) const {
+        MappedFile file(rawPath(key).string());
+        std::optional<ImageType> image = readKeyed(file, key);
+        if (!image) {
+            dropEntry(key); // Unreadable or another key's file: decode again next time
+            return std::nullopt;
+        }
+        memory_->cacheImage(key, *image);
+        memory_->noteDecodeCost(key, index_.at(key).decodeCost);
+        ++diskHits_;
+        return image;
+    }
+
+    // Memory-tier lookup without isCached, which would credit the decode cost a second time
+    std::optional<ImageType> fromMemory(const std::string& key) const {
+        try {
+            return memory_->getCachedShallow(key);
+        } catch (const std::runtime_error&) {
+            return std::nullopt;
+        }
+    }
+
+    ImageType fetch(const std::string& key, CacheOp op) const {
+        std::optional<ImageType> image = fromMemory(key);
+        if (!image && validEntry(key)) image = readIntoMemory(key);
+        if (image) {
+            counters_.recordHit(op);
+            logAccess(key);
+            return *image;
+        }
+        counters_.recordMiss(op);
+        throw std::runtime_error("Key not found in cache: " + key);
+    }
+
+    void persist(const std::string& key, const ImageType& image) {
+        validated_.erase(key);
+        std::optional<Fingerprint> source = fingerprint(key);
+        if (!source) return;
+        std::filesystem::path path = rawPath(key);
+        std::filesystem::path tmp = path;
+        tmp += ".tmp";
+        std::error_code ec;
+        if (!Traits::writeRaw(image, tmp.string()) || !appendKey(tmp, key)) {
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+        uint64_t bytes = std::filesystem::file_size(tmp, ec);
+        std::filesystem::rename(tmp, path, ec); // Atomic: a crash never leaves a torn file under the entry's name
+        if (ec) return;
+        forget(key);
+        Entry& entry = index_[key];
+        entry.source = *source;
+        entry.bytes = bytes;
+        diskUsage_.push_front(key);
+        entry.position = diskUsage_.begin();
+        diskBytes_ += bytes;
+        appendJournal(key, entry);
+        validated_.insert(key);
+        trimDisk();
+    }
+
+    // Delete least recently used raw files until they fit in maxDiskBytes
+    void trimDisk() const {
+        while (diskBytes_ > options_.maxDiskBytes && !diskUsage_.empty()) {
+            std::string key = diskUsage_.back();
+            dropEntry(key);
+        }
+    }
+
+    void dropEntry(const std::string& key) const {
+        std::error_code ec;
+        if (index_.count(key)) std::filesystem::remove(rawPath(key), ec);
+        forget(key);
+    }
+
+    // Remove the key's entry from the index without touching its file
+    void forget(const std::string& key) const {
+        validated_.erase(key);
+        auto it = index_.find(key);
+        if (it == index_.end()) return;
+        diskBytes_ -= it->second.bytes;
+        diskUsage_.erase(it->second.position);
+        index_.erase(it);
+    }
+
+    void touchDisk(const std::string& key) const {
+        auto it = index_.find(key);
+        if (it != index_.end()) diskUsage_.splice(diskUsage_.begin(), diskUsage_, it->second.position);
+    }
+
+    void logAccess(const std::string& key) const {
+        touchDisk(key);
+        if (accessLog_ && logged_.insert(key).second) accessLog_ << key << '\n';
+    }
+
+    // Journal lines: key \t size \t mtime \t hash \t decode ns; the last line for a key wins
+    void appendJournal(const std::string& key, const Entry& entry) {
+        if (key.find_first_of("\t\n") != std::string::npos) return;
+        journal_ << key << '\t' << entry.source.size << '\t' << entry.source.mtime << '\t'
+                 << entry.source.hash << '\t' << entry.decodeCost.count() << '\n';
+        journal_.flush();
+    }
+
+    // Read the journal, drop entries whose raw file is gone, then rewrite it compacted.
+    // Entries written last count as most recently used.
+    void loadJournal() {
+        std::vector<std::string> order;
+        for (const auto& line : readLines(cacheDir_ / "entries.log")) {
+            std::istringstream fields(line);
+            std::string key;
+            Entry entry;
+            int64_t cost = 0;
+            if (!std::getline(fields, key, '\t')) continue;
+            if (!(fields >> entry.source.size >> entry.source.mtime >> entry.source.hash >> cost)) continue;
+            entry.decodeCost = std::chrono::nanoseconds(cost);
+            index_[key] = entry;
+            order.push_back(key);
+        }
+        std::unordered_set<std::string> placed;
+        for (auto key = order.rbegin(); key != order.rend(); ++key) {
+            auto it = index_.find(*key);
+            if (it == index_.end() || !placed.insert(*key).second) continue;
+            std::error_code ec;
+            uint64_t bytes = std::filesystem::file_size(rawPath(*key), ec);
+            if (ec) {
+                index_.erase(it);
+                continue;
+            }
+            it->second.bytes = bytes;
+            diskBytes_ += bytes;
+            diskUsage_.push_back(*key);
+            it->second.position = std::prev(diskUsage_.end());
+        }
+        trimDisk();
+        std::error_code ec;
+        std::filesystem::path compacted = cacheDir_ / "entries.log.tmp";
+        {
+            journal_.open(compacted, std::ios::trunc);
+            for (auto key = diskUsage_.rbegin(); key != diskUsage_.rend(); ++key) appendJournal(*key, index_.at(*key)); // Most recent last
+            journal_.close();
+        }
+        std::filesystem::rename(compacted, cacheDir_ / "entries.log", ec);
+        journal_.open(cacheDir_ / "entries.log", std::ios::app);
+    }
+
+    static std::vector<std::string> readLines(const std::filesystem::path& path) {
+        std::vector<std::string> lines;
+        std::ifstream in(path);
+        for (std::string line; std::getline(in, line); )
+            if (!line.empty()) lines.push_back(line);
+        return lines;
+    }
+
+    std::unique_ptr<CacheManager<ImageType>> memory_; ///< In-memory tier
+    std::string inputRoot_;
+    std::filesystem::path cacheDir_;
+    PersistentCacheOptions options_;
+    std::ofstream journal_; ///< entries.log, appended as entries are stored
+    // Lookups validate entries, load images from disk and log accesses, so they update these too
+    mutable std::unordered_map<std::string, Entry> index_; ///< Stored entries by key
+    mutable std::unordered_set<std::string> validated_;    ///< Keys whose entry matched the source this run
+    mutable std::unordered_set<std::string> logged_;       ///< Keys already written to the access log
+    mutable std::ofstream accessLog_;                      ///< access.log: keys used by this run, in first-use order
+    mutable std::list<std::string> diskUsage_;             ///< Keys with a raw file, most recently used first
+    mutable uint64_t diskBytes_ = 0;                       ///< Total size of the raw files
+    mutable uint64_t diskHits_ = 0;
+    mutable CacheStats counters_; ///< Updated by const lookups too
+};
+
+} // namespace pipeline
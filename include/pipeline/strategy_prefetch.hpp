@@ -0,0 +1,121 @@
+#pragma once
+
+#include "pipeline/strategy.hpp"
+#include "pipeline/strategy_default.hpp"
+#include "pipeline/read_ahead.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pipeline {
+
+/**
+ * @brief Image loader that decodes upcoming files on background threads.
+ * 
+ * Wraps another loader. After prefetch() is given an access order (see Pipeline::prefetch),
+ * the next images are decoded ahead; a later loadFromFile/loadIntoCache for one of them
+ * returns the already decoded image instead of stalling on the decode.
+ * Images are inserted into the cache on the caller's thread, so any CacheManager works.
+ * 
+ * @tparam ImageType The image type to load.
+ */
+template <typename ImageType>
+class PrefetchingImageLoader : public ImageLoader<ImageType> {
+public:
+    /**
+     * @brief Construct a new PrefetchingImageLoader.
+     * 
+     * @param maxBytes Maximum bytes of decoded images held ahead of the consumer.
+     * @param workers Number of background decode threads.
+     * @param inner Loader doing the actual decoding. Defaults to DefaultImageLoader.
+     */
+    explicit PrefetchingImageLoader(size_t maxBytes, size_t workers = 2, std::unique_ptr<ImageLoader<ImageType>> inner = nullptr)
+        : inner_(inner != nullptr ? std::move(inner) : std::make_unique<DefaultImageLoader<ImageType>>())
+        , readAhead_([this](const std::string& path) { return inner_->loadFromFile(path); }, maxBytes, workers) {}
+
+    /**
+     * @brief Load an image, taking it from the read-ahead stage when available.
+     * @param path Path to the image file.
+     * @return Loaded image.
+     */
+    ImageType loadFromFile(const std::string& path) override {
+        if (auto image = readAhead_.take(path)) return std::move(*image);
+        return inner_->loadFromFile(path);
+    }
+
+    /**
+     * @brief Decode an image from memory through the inner loader.
+     * @param bytes Encoded image bytes.
+     * @return Decoded image.
+     */
+    ImageType loadFromBuffer(const std::vector<unsigned char>& bytes) override {
+        return inner_->loadFromBuffer(bytes);
+    }
+
+    /**
+     * @brief Load a reduced-resolution image through the inner loader (never prefetched).
+     * @param path Path to the image file.
+     * @param options Requested reduction.
+     * @return Loaded image.
+     */
+    ImageType loadScaled(const std::string& path, const DecodeOptions& options) override {
+        return inner_->loadScaled(path, options);
+    }
+
+    /**
+     * @brief Read header information through the inner loader.
+     * @param path Path to the image file.
+     * @return Header information.
+     */
+    ImageInfo probe(const std::string& path) override { return inner_->probe(path); }
+
+    /**
+     * @brief Load an image from a file (prefetched if possible) and cache it.
+     * Caches that accept encoded images are served by the inner loader instead.
+     * @param cache Cache manager to store the loaded image.
+     * @param path Path to the image file.
+     * @param key Key to store the image under in the cache.
+     */
+    void loadIntoCache(CacheManager<ImageType>& cache, const std::string& path, const std::string& key) override {
+        if (cache.acceptsEncoded()) {
+            inner_->loadIntoCache(cache, path, key);
+            return;
+        }
+        cache.cacheImage(key, loadFromFile(path));
+    }
+
+    /**
+     * @brief Cache an existing image under a specified key.
+     * @param cache Cache manager to store the image.
+     * @param image The image to cache.
+     * @param key Key to store the image under.
+     */
+    void loadIntoCache(CacheManager<ImageType>& cache, const ImageType& image, const std::string& key) override {
+        inner_->loadIntoCache(cache, image, key);
+    }
+
+    /**
+     * @brief Recursively load a directory through the inner loader.
+     */
+    std::vector<std::string> loadDirectory(CacheManager<ImageType>& cache, const std::string& dir, const std::string& inputRoot, const std::vector<std::string>& extensions) override {
+        return inner_->loadDirectory(cache, dir, inputRoot, extensions);
+    }
+
+    /**
+     * @brief Set the access order and start decoding its head.
+     * @param paths File paths in expected access order.
+     */
+    void prefetch(const std::vector<std::string>& paths) override { readAhead_.schedule(paths); }
+
+    /**
+     * @brief Bytes of decoded images currently held ahead of the consumer.
+     */
+    size_t stagedBytes() const { return readAhead_.stagedBytes(); }
+
+private:
+    std::unique_ptr<ImageLoader<ImageType>> inner_;
+    ReadAhead<ImageType> readAhead_; ///< Declared after inner_ so its workers stop first
+};
+
+} // namespace pipeline
@@ -0,0 +1,557 @@
+#pragma once
+
+#include "pipeline/remote_protocol.hpp"
+
+#ifdef PIPELINE_HAS_REMOTE
+
+#include "pipeline/strategy.hpp"
+#include "pipeline/strategy_default.hpp"
+#include "pipeline/image_traits.hpp"
+#include "pipeline/encode_profile.hpp"
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace pipeline {
+
+/**
+ * @brief How RemoteCacheManager ships images it is handed decoded.
+ */
+enum class RemotePayload {
+    Raw,    ///< Uncompressed pixels (ImageTraits::encodeRaw): large, but free to decode
+    Encoded ///< Image file bytes: loaders hand over the original files, decoded images are encoded
+};
+
+/**
+ * @brief Settings of a RemoteCacheManager.
+ */
+struct RemoteCacheOptions {
+    RemotePayload payload = RemotePayload::Raw;
+    std::string encodeFormat = ".png";            ///< Encoded payloads: format for images cached decoded (lossless by default).
+    EncodeProfile encodeProfile = EncodeProfile::fast(); ///< Encoded payloads: encoder settings.
+    size_t hotCapacity = 16;                       ///< Images kept locally after being stored or fetched (at least 1).
+    size_t maxPendingWrites = 32;                  ///< Puts/removes queued before they are sent as one batch.
+    std::chrono::milliseconds timeout{5000};       ///< Per connect, send and receive.
+    std::chrono::milliseconds retryInterval{2000}; ///< Wait before reconnecting after a failure.
+};
+
+/**
+ * @brief Cache backed by a cache server (see src/cache_server.cpp), shared by every machine using it.
+ *
+ * Talks the frame protocol of remote_protocol.hpp over TCP or a Unix socket. Writes (cacheImage,
+ * cacheEncoded, remove, noteDecodeCost) are queued and sent in batches without waiting for
+ * replies; reads send the queue along and then wait, so a batch costs one round trip.
+ * getMany()/prefetch() fetch many keys in one round trip as well.
+ *
+ * Since Pipeline checks isCached before every read, isCached fetches the image and keeps it in
+ * a small local hot set; images just stored are kept there too, so Pipeline's load-then-read
+ * needs no round trip.
+ *
+ * The server being down or slow makes the cache behave as empty: writes are dropped and lookups
+ * miss (counted by networkErrors()), and reconnection is attempted after retryInterval.
+ * Images fetched are decoded according to how they were stored, so raw and encoded clients can
+ * share one server. Thread-safe; requests are serialized on one connection.
+ *
+ * @tparam ImageType The image data type stored in the cache.
+ * @tparam Traits Provides encodeRaw/readRaw (raw payloads) and byteSize. Defaults to ImageTraits.
+ */
+template <typename ImageType, typename Traits = ImageTraits<ImageType>>
+class RemoteCacheManager : public CacheManager<ImageType> {
+public:
+    /**
+     * @brief Construct a RemoteCacheManager. Connects lazily, on the first request.
+     *
+     * @param address Server address: "tcp://host:port", "host:port" or "unix:/path/to/socket".
+     * @param options Payload format, batching and timeouts.
+     * @throws remote::ProtocolError if the address cannot be parsed.
+     */
+    explicit RemoteCacheManager(const std::string& address, RemoteCacheOptions options = {})
+        : endpoint_(remote::Endpoint::parse(address)), options_(std::move(options)) {
+        options_.hotCapacity = std::max<size_t>(options_.hotCapacity, 1); // isCached hands its fetch to the next get
+    }
+
+    /**
+     * @brief Send queued writes before disconnecting (errors are ignored).
+     */
+    ~RemoteCacheManager() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        exchange({});
+    }
+
+    RemoteCacheManager(const RemoteCacheManager&) = delete;
+    RemoteCacheManager& operator=(const RemoteCacheManager&) = delete;
+
+    /**
+     * @brief In Encoded mode, loaders hand over the original file bytes.
+     */
+    bool acceptsEncoded() const override { return options_.payload == RemotePayload::Encoded; }
+
+    /**
+     * @brief Queue encoded file bytes for the server; decoded locally when read back.
+     *
+     * @param key The unique string key identifying the image.
+     * @param bytes Encoded image bytes.
+     */
+    void cacheEncoded(const std::string& key, std::vector<unsigned char> bytes) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queueWrite(remote::Op::Put, key, remote::PayloadKind::Encoded, 0, bytes);
+        remember(key, Hot{std::nullopt, std::move(bytes), 0});
+        counters_.recordInsertion();
+    }
+
+    /**
+     * @brief Queue an image for the server, as raw pixels or encoded per the options.
+     *
+     * Images that cannot be serialized are only kept in the local hot set.
+     *
+     * @param key The unique string key identifying the image.
+     * @param image The image data to cache.
+     */
+    void cacheImage(const std::string& key, const ImageType& image) override {
+        std::vector<unsigned char> payload;
+        remote::PayloadKind kind = remote::PayloadKind::None;
+        if (options_.payload == RemotePayload::Raw) {
+            if (Traits::encodeRaw(image, payload)) kind = remote::PayloadKind::Raw;
+        } else {
+            DefaultImageSaver<ImageType> saver;
+            if (saver.supportsEncode()) {
+                payload = saver.encode(image, options_.encodeFormat, options_.encodeProfile);
+                kind = remote::PayloadKind::Encoded;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (kind != remote::PayloadKind::None) queueWrite(remote::Op::Put, key, kind, 0, payload);
+        remember(key, Hot{image, {}, 0});
+        counters_.recordInsertion();
+    }
+
+    /**
+     * @brief Check if an image is cached here or on the server, fetching it if so.
+     *
+     * @param key The key to query.
+     * @return true if the image is cached, false otherwise (including when the server is unreachable).
+     */
+    bool isCached(const std::string& key) const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Hot* hot = lookup(key);
+        if (!hot) {
+            counters_.recordMiss(CacheOp::IsCached);
+            return false;
+        }
+        counters_.recordHit(CacheOp::IsCached);
+        counters_.recordDecodeSaved(std::chrono::nanoseconds(hot->decodeNanos));
+        return true;
+    }
+
+    /**
+     * @brief Retrieve a cached image (deep copy).
+     *
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image.
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCached(const std::string& key) const override {
+        return image(key, CacheOp::Get).clone();
+    }
+
+    /**
+     * @brief Retrieve a cached image without copying the local hot copy.
+     *
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image.
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCachedShallow(const std::string& key) const override {
+        return image(key, CacheOp::GetShallow);
+    }
+
+    /**
+     * @brief Fetch several images in one round trip.
+     *
+     * @param keys Keys to fetch.
+     * @return One entry per key, std::nullopt for images not cached or not decodable.
+     */
+    std::vector<std::optional<ImageType>> getMany(const std::vector<std::string>& keys) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::optional<ImageType>> images(keys.size());
+        std::vector<size_t> missing;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (const Hot* hot = lookup(keys[i], false)) images[i] = hot->image;
+            else missing.push_back(i);
+        }
+        std::vector<std::string> missingKeys;
+        for (size_t i : missing) missingKeys.push_back(keys[i]);
+        std::vector<std::optional<Hot>> found = fetch(missingKeys);
+        for (size_t j = 0; j < missing.size(); ++j) {
+            if (!found[j] || !decode(*found[j])) continue;
+            images[missing[j]] = found[j]->image;
+            remember(keys[missing[j]], std::move(*found[j]));
+        }
+        return images;
+    }
+
+    /**
+     * @brief Fetch images about to be used into the local hot set, in one round trip.
+     *
+     * Only the first hotCapacity keys are useful.
+     *
+     * @param keys Keys in the order they will be used.
+     */
+    void prefetch(const std::vector<std::string>& keys) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::string> missing;
+        for (size_t i = 0; i < keys.size() && i < options_.hotCapacity; ++i)
+            if (!hot_.count(keys[i])) missing.push_back(keys[i]);
+        std::vector<std::optional<Hot>> found = fetch(missing);
+        for (size_t i = 0; i < missing.size(); ++i)
+            if (found[i]) remember(missing[i], std::move(*found[i])); // Encoded payloads are decoded on first use
+    }
+
+    /**
+     * @brief Remove an image from the server (queued) and the hot set.
+     * @param key The key of the image to remove.
+     */
+    void remove(const std::string& key) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        forget(key);
+        queueWrite(remote::Op::Remove, key, remote::PayloadKind::None, 0, {});
+    }
+
+    /**
+     * @brief Remove every image from the server, for all its clients.
+     */
+    void clear() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hot_.clear();
+        order_.clear();
+        hotBytes_ = 0;
+        queueWrite(remote::Op::Clear, {}, remote::PayloadKind::None, 0, {});
+        exchange({});
+    }
+
+    /**
+     * @brief Get the keys of all images on the server.
+     * @return std::vector<std::string> Vector of cached keys (empty if the server is unreachable).
+     */
+    std::vector<std::string> getKeys() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::string> keys;
+        auto responses = exchange({request(remote::Op::Keys, {})});
+        if (!responses || (*responses)[0].status != remote::Status::Ok) return keys;
+        const std::vector<unsigned char>& v = (*responses)[0].value;
+        for (size_t at = 0; at + 4 <= v.size();) {
+            size_t length = static_cast<size_t>(remote::getLE(v.data() + at, 4));
+            at += 4;
+            if (length > v.size() - at) break;
+            keys.emplace_back(reinterpret_cast<const char*>(v.data() + at), length);
+            at += length;
+        }
+        return keys;
+    }
+
+    /**
+     * @brief Queue the decode cost of an image for the server, credited on isCached hits by every client.
+     * @param key Key of the cached image.
+     * @param cost Time spent decoding it.
+     */
+    void noteDecodeCost(const std::string& key, std::chrono::nanoseconds cost) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queueWrite(remote::Op::SetCost, key, remote::PayloadKind::None, static_cast<uint64_t>(cost.count()), {});
+        auto it = hot_.find(key);
+        if (it != hot_.end()) it->second.first.decodeNanos = static_cast<uint64_t>(cost.count());
+    }
+
+    /**
+     * @brief This client's counters; residentBytes/peakBytes are those of the local hot set.
+     * @return Current counters.
+     */
+    CacheStatsSnapshot stats() const override {
+        CacheStatsSnapshot s = counters_.snapshot();
+        std::lock_guard<std::mutex> lock(mutex_);
+        s.residentBytes = hotBytes_;
+        s.peakBytes = peakHotBytes_;
+        return s;
+    }
+
+    /**
+     * @brief Counters of the server, across all its clients (isCached fields count its lookups).
+     * @return Server counters, or std::nullopt if the server is unreachable.
+     */
+    std::optional<CacheStatsSnapshot> serverStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto responses = exchange({request(remote::Op::Stats, {})});
+        if (!responses || (*responses)[0].status != remote::Status::Ok || (*responses)[0].value.size() < 48) return std::nullopt;
+        const unsigned char* v = (*responses)[0].value.data();
+        CacheStatsSnapshot s;
+        s.insertions = remote::getLE(v, 8);
+        s.evictions = remote::getLE(v + 8, 8);
+        s.residentBytes = static_cast<size_t>(remote::getLE(v + 16, 8));
+        s.peakBytes = static_cast<size_t>(remote::getLE(v + 24, 8));
+        s.isCachedHits = remote::getLE(v + 32, 8);
+        s.isCachedMisses = remote::getLE(v + 40, 8);
+        return s;
+    }
+
+    /**
+     * @brief Send queued writes now and wait for the server to apply them.
+     * @return false if the server could not be reached (the writes are dropped).
+     */
+    bool flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return exchange({}).has_value();
+    }
+
+    /**
+     * @brief Number of requests lost to connection errors or timeouts.
+     */
+    uint64_t networkErrors() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return networkErrors_;
+    }
+
+private:
+    struct Hot {
+        std::optional<ImageType> image;     ///< Decoded image, once needed
+        std::vector<unsigned char> encoded; ///< Encoded file bytes not decoded yet
+        uint64_t decodeNanos = 0;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Sent {
+        remote::Op op;
+        uint32_t id;
+    };
+
+    ImageType image(const std::string& key, CacheOp op) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Hot* hot = lookup(key);
+        if (!hot) {
+            counters_.recordMiss(op);
+            throw std::runtime_error("Key not found in cache: " + key);
+        }
+        counters_.recordHit(op);
+        return *hot->image;
+    }
+
+    /**
+     * @brief Find a decoded image in the hot set, fetching it from the server if allowed.
+     */
+    const Hot* lookup(const std::string& key, bool allowFetch = true) const {
+        auto it = hot_.find(key);
+        if (it == hot_.end() && allowFetch) {
+            std::vector<std::optional<Hot>> found = fetch({key});
+            if (found[0]) remember(key, std::move(*found[0]));
+            it = hot_.find(key);
+        }
+        if (it == hot_.end()) return nullptr;
+        Hot& hot = it->second.first;
+        size_t before = sizeOf(hot);
+        if (!decode(hot)) {
+            forget(key);
+            return nullptr;
+        }
+        hotBytes_ = hotBytes_ - before + sizeOf(hot);
+        peakHotBytes_ = std::max(peakHotBytes_, hotBytes_);
+        order_.splice(order_.begin(), order_, it->second.second);
+        return &hot;
+    }
+
+    /**
+     * @brief Decode an entry's encoded bytes if needed.
+     * @return false if the entry holds no usable image.
+     */
+    static bool decode(Hot& hot) {
+        if (hot.image) return true;
+        try {
+            hot.image = DefaultImageLoader<ImageType>().loadFromBuffer(hot.encoded);
+            hot.encoded = {};
+        } catch (const std::exception&) {
+            return false;
+        }
+        return true;
+    }
+
+    static size_t sizeOf(const Hot& hot) { return (hot.image ? Traits::byteSize(*hot.image) : 0) + hot.encoded.size(); }
+
+    /**
+     * @brief Get images from the server in one round trip.
+     * @return One entry per key, std::nullopt if not found or unreadable (or the server is unreachable).
+     */
+    std::vector<std::optional<Hot>> fetch(const std::vector<std::string>& keys) const {
+        std::vector<std::optional<Hot>> found(keys.size());
+        std::vector<remote::Frame> requests;
+        for (const auto& key : keys) requests.push_back(request(remote::Op::Get, key));
+        if (requests.empty()) return found;
+        auto responses = exchange(std::move(requests));
+        if (!responses) return found;
+        for (size_t i = 0; i < keys.size() && i < responses->size(); ++i) {
+            remote::Frame& response = (*responses)[i];
+            if (response.status != remote::Status::Ok) continue;
+            Hot hot{std::nullopt, {}, response.aux};
+            if (response.kind == remote::PayloadKind::Raw) {
+                try {
+                    hot.image = Traits::readRaw(response.value.data(), response.value.size());
+                } catch (const std::exception&) {
+                    // Unreadable payload: a miss
+                }
+                if (!hot.image) continue;
+            } else if (response.kind == remote::PayloadKind::Encoded) {
+                hot.encoded = std::move(response.value);
+            } else {
+                continue;
+            }
+            found[i] = std::move(hot);
+        }
+        return found;
+    }
+
+    void remember(const std::string& key, Hot hot) const {
+        forget(key);
+        while (hot_.size() >= options_.hotCapacity) forget(order_.back());
+        order_.push_front(key);
+        hotBytes_ += sizeOf(hot);
+        peakHotBytes_ = std::max(peakHotBytes_, hotBytes_);
+        hot_.emplace(key, std::make_pair(std::move(hot), order_.begin()));
+    }
+
+    void forget(const std::string& key) const {
+        auto it = hot_.find(key);
+        if (it == hot_.end()) return;
+        hotBytes_ -= sizeOf(it->second.first);
+        order_.erase(it->second.second);
+        hot_.erase(it);
+    }
+
+    remote::Frame request(remote::Op op, const std::string& key) const {
+        remote::Frame frame;
+        frame.op = op;
+        frame.id = nextId_++;
+        frame.key = key;
+        return frame;
+    }
+
+    void queueWrite(remote::Op op, const std::string& key, remote::PayloadKind kind, uint64_t aux, const std::vector<unsigned char>& value) const {
+        if (key.size() > remote::kMaxKey) return;
+        remote::Frame header = request(op, {});
+        header.kind = kind;
+        header.aux = aux;
+        remote::appendFrame(queued_, header, key, value.data(), value.size());
+        queuedFrames_.push_back({op, header.id});
+        if (queuedFrames_.size() >= options_.maxPendingWrites) exchange({});
+    }
+
+    /**
+     * @brief Send the queued writes followed by requests, then read all their responses.
+     *
+     * Responses must echo the op and id of the frames sent, in order; anything else means the
+     * connection is out of step and is treated like a network failure.
+     *
+     * @return One response per request (not per queued write), in order; requests with a key too
+     *         long to send get NotFound. std::nullopt if the server could not be reached, in which
+     *         case everything sent is counted as lost.
+     */
+    std::optional<std::vector<remote::Frame>> exchange(std::vector<remote::Frame> requests) const {
+        std::vector<unsigned char> out = std::move(queued_);
+        queued_.clear();
+        std::vector<Sent> sent = std::move(queuedFrames_);
+        queuedFrames_.clear();
+        size_t writes = sent.size();
+        std::vector<remote::Frame> responses(requests.size());
+        std::vector<size_t> slots; // Response index of each request sent
+        for (size_t i = 0; i < requests.size(); ++i) {
+            const remote::Frame& frame = requests[i];
+            if (frame.key.size() > remote::kMaxKey) {
+                responses[i].op = frame.op;
+                responses[i].id = frame.id;
+                responses[i].status = remote::Status::NotFound;
+                continue;
+            }
+            remote::appendFrame(out, frame);
+            sent.push_back({frame.op, frame.id});
+            slots.push_back(i);
+        }
+        if (sent.empty()) return responses;
+        if (!connected()) {
+            networkErrors_ += sent.size();
+            return std::nullopt;
+        }
+
+        bool ok = socket_.sendAll(out.data(), out.size(), options_.timeout);
+        std::vector<unsigned char> in;
+        size_t consumed = 0;
+        for (size_t received = 0; ok && received < sent.size();) {
+            remote::Frame frame;
+            size_t used = 0;
+            try {
+                used = remote::parseFrame(in.data() + consumed, in.size() - consumed, frame);
+            } catch (const remote::ProtocolError&) {
+                ok = false;
+                break;
+            }
+            if (used == 0) {
+                // Read the rest of the frame in one go when its size is known
+                size_t need = remote::frameSize(in.data() + consumed, in.size() - consumed);
+                size_t chunk = std::max<size_t>(need > in.size() - consumed ? need - (in.size() - consumed) : 0, 256 * 1024);
+                ok = socket_.receiveSome(in, chunk, options_.timeout);
+                continue;
+            }
+            consumed += used;
+            if (frame.op != sent[received].op || frame.id != sent[received].id) {
+                ok = false; // Out of step: the payload may belong to another key
+                break;
+            }
+            if (received >= writes) responses[slots[received - writes]] = std::move(frame);
+            ++received;
+            if (consumed == in.size()) {
+                in.clear();
+                consumed = 0;
+            }
+        }
+        if (!ok) {
+            socket_.close();
+            retryAt_ = Clock::now() + options_.retryInterval;
+            networkErrors_ += sent.size();
+            return std::nullopt;
+        }
+        return responses;
+    }
+
+    bool connected() const {
+        if (socket_.valid()) return true;
+        if (Clock::now() < retryAt_) return false;
+        try {
+            socket_ = remote::Socket::connect(endpoint_, options_.timeout);
+            return true;
+        } catch (const std::exception&) {
+            retryAt_ = Clock::now() + options_.retryInterval;
+            return false;
+        }
+    }
+
+    remote::Endpoint endpoint_;
+    RemoteCacheOptions options_;
+
+    mutable std::mutex mutex_; ///< Guards everything below
+    mutable remote::Socket socket_;
+    mutable Clock::time_point retryAt_{};
+    mutable uint32_t nextId_ = 1;
+    mutable std::vector<unsigned char> queued_; ///< Encoded writes not sent yet
+    mutable std::vector<Sent> queuedFrames_;    ///< Op and id of each frame in queued_
+    mutable uint64_t networkErrors_ = 0;
+    mutable std::unordered_map<std::string, std::pair<Hot, std::list<std::string>::iterator>> hot_;
+    mutable std::list<std::string> order_; ///< Hot keys, most recently used first
+    mutable size_t hotBytes_ = 0;
+    mutable size_t peakHotBytes_ = 0;
+    mutable CacheStats counters_; ///< Updated by const lookups too
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_HAS_REMOTE
@@ -0,0 +1,352 @@
+#pragma once
+
+#include "pipeline/strategy.hpp"
+#include "pipeline/strategy_lru.hpp"
+#include "pipeline/image_traits.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdexcept>
+
+namespace pipeline {
+
+/**
+ * @brief Thread-safe LRU cache split into independently locked shards.
+ *
+ * Keys are spread over N shards by hash; each shard has its own mutex, LRU list and share of
+ * the capacity (count or bytes), so threads touching different keys rarely contend.
+ * isCached answers most misses without locking: each shard keeps atomic per-bucket key
+ * counts, and a zero count proves the key is absent.
+ *
+ * To share one instance between several pipelines, hand each pipeline a SharedCache.
+ *
+ * @tparam ImageType The image data type stored in the cache.
+ * @tparam Traits Provides byteSize(image), used to size entries. Defaults to ImageTraits.
+ */
+template <typename ImageType, typename Traits = ImageTraits<ImageType>>
+class ShardedCacheManager : public CacheManager<ImageType> {
+public:
+    /**
+     * @brief Construct a cache holding at most `capacity` images in total.
+     *
+     * @param capacity Maximum number of images, split across shards so the shares add up to it.
+     * @param shards Number of shards (at least 1, at most capacity).
+     */
+    explicit ShardedCacheManager(size_t capacity, size_t shards = 16)
+        : shards_(std::clamp<size_t>(shards, 1, std::max<size_t>(capacity, 1))) {
+        for (size_t i = 0; i < shards_.size(); ++i) shards_[i].capacity = shareOf(capacity, i);
+    }
+
+    /**
+     * @brief Construct a cache bounded by the total size of its images.
+     *
+     * Each shard gets an equal share of the budget (the shares add up to it exactly) and evicts
+     * its least recently used images to stay within it. An image larger than a shard's share is
+     * kept alone in its shard; the total is then brought back within the budget by evicting
+     * from the other shards, one image per shard in turn. An image larger than the whole budget
+     * is not cached. Each cacheImage returns with the total within the budget, although
+     * concurrent inserts can exceed it briefly.
+     *
+     * @param budget Maximum bytes of cached image data.
+     * @param shards Number of shards (at least 1).
+     */
+    explicit ShardedCacheManager(ByteBudget budget, size_t shards = 16)
+        : shards_(std::max<size_t>(shards, 1))
+        , maxBytes_(budget.bytes) {
+        for (size_t i = 0; i < shards_.size(); ++i) shards_[i].maxBytes = shareOf(budget.bytes, i);
+    }
+
+    /**
+     * @brief Cache an image with the associated key, evicting least recently used images of its shard.
+     *
+     * Images of other shards are evicted too if the byte budget is still exceeded (see the
+     * ByteBudget constructor).
+     *
+     * @param key The unique string key identifying the image.
+     * @param image The image data to cache.
+     */
+    void cacheImage(const std::string& key, const ImageType& image) override {
+        size_t hash = std::hash<std::string>{}(key);
+        Shard& shard = shardFor(hash);
+        size_t size = Traits::byteSize(image);
+        if (size > maxBytes_) { // Can never fit: keep neither it nor an older copy
+            remove(key);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.map.find(key);
+            if (it != shard.map.end()) {
+                addBytes(shard, size, it->second.bytes);
+                it->second.image = image;
+                it->second.bytes = size;
+                it->second.decodeCost = std::chrono::nanoseconds(0);
+                shard.usage.splice(shard.usage.begin(), shard.usage, it->second.position);
+            } else {
+                if (!shard.map.empty() && shard.map.size() >= shard.capacity) evictLeastRecent(shard);
+                shard.usage.push_front(key);
+                shard.map.emplace(key, Entry{image, size, shard.usage.begin(), std::chrono::nanoseconds(0)});
+                shard.presence[bucketOf(hash)].fetch_add(1, std::memory_order_release);
+                addBytes(shard, size, 0);
+            }
+            counters_.recordInsertion();
+            while (shard.bytes > shard.maxBytes && shard.map.size() > 1) evictLeastRecent(shard);
+        }
+        if (currentBytes() > maxBytes_) evictAcrossShards(shard);
+    }
+
+    /**
+     * @brief Check if an image identified by key is cached.
+     *
+     * Lock-free for most absent keys.
+     *
+     * @param key The key to query.
+     * @return true if the image is cached, false otherwise.
+     */
+    bool isCached(const std::string& key) const override {
+        size_t hash = std::hash<std::string>{}(key);
+        const Shard& shard = shardFor(hash);
+        if (shard.presence[bucketOf(hash)].load(std::memory_order_acquire) != 0) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.map.find(key);
+            if (it != shard.map.end()) {
+                counters_.recordHit(CacheOp::IsCached);
+                counters_.recordDecodeSaved(it->second.decodeCost);
+                return true;
+            }
+        }
+        counters_.recordMiss(CacheOp::IsCached);
+        return false;
+    }
+
+    /**
+     * @brief Retrieve a deep copy of a cached image and mark it as recently used.
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image.
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCached(const std::string& key) const override {
+        return lookup(key, CacheOp::Get).clone();
+    }
+
+    /**
+     * @brief Retrieve a shallow copy of a cached image and mark it as recently used.
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image (shallow copy).
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCachedShallow(const std::string& key) const override {
+        return lookup(key, CacheOp::GetShallow);
+    }
+
+    /**
+     * @brief Remove an image from the cache by key. No-op if absent.
+     * @param key The key of the image to remove.
+     */
+    void remove(const std::string& key) override {
+        size_t hash = std::hash<std::string>{}(key);
+        Shard& shard = shardFor(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it != shard.map.end()) erase(shard, it);
+    }
+
+    /**
+     * @brief Clear all cached images.
+     */
+    void clear() override {
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            while (!shard.map.empty()) erase(shard, shard.map.begin());
+        }
+    }
+
+    /**
+     * @brief Get all cached keys, shard by shard (most to least recently used within a shard).
+     * @return std::vector<std::string> Vector of cached keys.
+     */
+    std::vector<std::string> getKeys() const override {
+        std::vector<std::string> keys;
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            keys.insert(keys.end(), shard.usage.begin(), shard.usage.end());
+        }
+        return keys;
+    }
+
+    /**
+     * @brief Total size of the cached images, as measured by Traits::byteSize.
+     */
+    size_t currentBytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Highest value currentBytes() has reached.
+     */
+    size_t peakBytes() const { return peakBytes_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Number of shards.
+     */
+    size_t shardCount() const { return shards_.size(); }
+
+    /**
+     * @brief Snapshot of hit/miss/eviction counters, resident and peak bytes, and decode time saved.
+     * @return Current counters.
+     */
+    CacheStatsSnapshot stats() const override {
+        CacheStatsSnapshot s = counters_.snapshot();
+        s.residentBytes = currentBytes();
+        s.peakBytes = peakBytes();
+        return s;
+    }
+
+    /**
+     * @brief Remember the decode cost of a cached image, credited on later isCached hits.
+     * @param key Key of the cached image.
+     * @param cost Time spent decoding it.
+     */
+    void noteDecodeCost(const std::string& key, std::chrono::nanoseconds cost) override {
+        Shard& shard = shardFor(std::hash<std::string>{}(key));
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it != shard.map.end()) it->second.decodeCost = cost;
+    }
+
+private:
+    static constexpr size_t kBuckets = 1024; ///< Presence counters per shard
+
+    struct Entry {
+        ImageType image;
+        size_t bytes;
+        std::list<std::string>::iterator position;
+        std::chrono::nanoseconds decodeCost;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        mutable std::list<std::string> usage; ///< Front = most recently used
+        std::unordered_map<std::string, Entry> map;
+        std::array<std::atomic<uint32_t>, kBuckets> presence{}; ///< Keys per hash bucket; 0 = none cached
+        size_t capacity = std::numeric_limits<size_t>::max();
+        size_t maxBytes = std::numeric_limits<size_t>::max();
+        size_t bytes = 0;
+    };
+
+    // Shard i's part of a total: equal shares, the remainder going one unit each to the first shards
+    size_t shareOf(size_t total, size_t i) const {
+        return total / shards_.size() + (i < total % shards_.size() ? 1 : 0);
+    }
+
+    Shard& shardFor(size_t hash) { return shards_[hash % shards_.size()]; }
+    const Shard& shardFor(size_t hash) const { return shards_[hash % shards_.size()]; }
+
+    // Independent of the shard index, which uses the low bits modulo the shard count
+    static size_t bucketOf(size_t hash) {
+        return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> 54) % kBuckets;
+    }
+
+    ImageType lookup(const std::string& key, CacheOp op) const {
+        size_t hash = std::hash<std::string>{}(key);
+        const Shard& shard = shardFor(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            counters_.recordMiss(op);
+            throw std::runtime_error("Key not found in cache: " + key);
+        }
+        counters_.recordHit(op);
+        shard.usage.splice(shard.usage.begin(), shard.usage, it->second.position);
+        return it->second.image;
+    }
+
+    void addBytes(Shard& shard, size_t added, size_t removed) {
+        shard.bytes = shard.bytes + added - removed;
+        size_t total = bytes_.fetch_add(added - removed, std::memory_order_relaxed) + added - removed;
+        size_t peak = peakBytes_.load(std::memory_order_relaxed);
+        while (total > peak && !peakBytes_.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {}
+    }
+
+    void erase(Shard& shard, typename std::unordered_map<std::string, Entry>::iterator it) {
+        shard.presence[bucketOf(std::hash<std::string>{}(it->first))].fetch_sub(1, std::memory_order_release);
+        shard.bytes -= it->second.bytes;
+        bytes_.fetch_sub(it->second.bytes, std::memory_order_relaxed);
+        shard.usage.erase(it->second.position);
+        shard.map.erase(it);
+    }
+
+    void evictLeastRecent(Shard& shard) {
+        erase(shard, shard.map.find(shard.usage.back()));
+        counters_.recordEviction();
+    }
+
+    // Bring the total back within the byte budget after `full` kept an image larger than its
+    // share: evict one image from each other shard in turn, then from `full` itself if
+    // concurrent inserts filled the others again. Locks one shard at a time.
+    void evictAcrossShards(Shard& full) {
+        size_t first = static_cast<size_t>(&full - shards_.data());
+        bool evicted = true;
+        while (evicted && currentBytes() > maxBytes_) {
+            evicted = false;
+            for (size_t i = 1; i < shards_.size() && currentBytes() > maxBytes_; ++i) {
+                Shard& shard = shards_[(first + i) % shards_.size()];
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (shard.map.empty()) continue;
+                evictLeastRecent(shard);
+                evicted = true;
+            }
+        }
+        std::lock_guard<std::mutex> lock(full.mutex);
+        while (currentBytes() > maxBytes_ && !full.map.empty()) evictLeastRecent(full);
+    }
+
+    std::vector<Shard> shards_;
+    size_t maxBytes_ = std::numeric_limits<size_t>::max(); ///< Budget of all shards together
+    std::atomic<size_t> bytes_{0};
+    std::atomic<size_t> peakBytes_{0};
+    mutable CacheStats counters_;
+};
+
+/**
+ * @brief CacheManager handle forwarding to a cache shared with other pipelines.
+ *
+ * Pipeline owns its cache through a unique_ptr; give each pipeline its own SharedCache
+ * pointing at one thread-safe cache (e.g. ShardedCacheManager) to share images between them.
+ *
+ * @tparam ImageType The image data type stored in the cache.
+ */
+template <typename ImageType>
+class SharedCache : public CacheManager<ImageType> {
+public:
+    /**
+     * @brief Construct a handle to a shared cache.
+     * @param cache The shared cache; must be thread-safe if pipelines run concurrently.
+     */
+    explicit SharedCache(std::shared_ptr<CacheManager<ImageType>> cache) : cache_(std::move(cache)) {}
+
+    void cacheImage(const std::string& key, const ImageType& image) override { cache_->cacheImage(key, image); }
+    bool isCached(const std::string& key) const override { return cache_->isCached(key); }
+    ImageType getCached(const std::string& key) const override { return cache_->getCached(key); }
+    ImageType getCachedShallow(const std::string& key) const override { return cache_->getCachedShallow(key); }
+    void remove(const std::string& key) override { cache_->remove(key); }
+    void clear() override { cache_->clear(); }
+    std::vector<std::string> getKeys() const override { return cache_->getKeys(); }
+    bool acceptsEncoded() const override { return cache_->acceptsEncoded(); }
+    void cacheEncoded(const std::string& key, std::vector<unsigned char> bytes) override { cache_->cacheEncoded(key, std::move(bytes)); }
+    CacheStatsSnapshot stats() const override { return cache_->stats(); }
+    void noteDecodeCost(const std::string& key, std::chrono::nanoseconds cost) override { cache_->noteDecodeCost(key, cost); }
+
+private:
+    std::shared_ptr<CacheManager<ImageType>> cache_;
+};
+
+} // namespace pipeline
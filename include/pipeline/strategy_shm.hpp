@@ -0,0 +1,197 @@
+#pragma once
+
+#include "pipeline/shm_store.hpp"
+
+#if defined(HAVE_OPENCV_CORE) && defined(PIPELINE_HAS_SHM)
+
+#include "pipeline/strategy.hpp"
+#include <opencv2/core.hpp>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace pipeline {
+
+namespace detail {
+
+/**
+ * @brief Releases the store reference of a cv::Mat view when OpenCV frees the view's last header.
+ *
+ * Stateless: each view's UMatData::userdata holds the store and entry to release, and keeps
+ * the store (and its mapping) alive while the view exists.
+ */
+class SharedViewAllocator : public cv::MatAllocator {
+public:
+    struct Token {
+        std::shared_ptr<SharedImageStore> store;
+        uint32_t entry;
+    };
+
+    static const SharedViewAllocator& instance() {
+        static SharedViewAllocator allocator;
+        return allocator;
+    }
+
+    cv::UMatData* allocate(int, const int*, int, void*, size_t*, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return nullptr; // Views are never (re)allocated through this allocator
+    }
+
+    bool allocate(cv::UMatData*, cv::AccessFlag, cv::UMatUsageFlags) const override { return false; }
+
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) return;
+        std::unique_ptr<Token> token(static_cast<Token*>(u->userdata));
+        delete u;
+        if (token) token->store->release(token->entry);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief cv::Mat cache shared by the processes of a host through POSIX shared memory.
+ *
+ * Each process constructs one on the same segment name (see SharedImageStore); an image
+ * decoded by any of them is stored once and served to all. getCachedShallow returns a cv::Mat
+ * header directly over the shared pages, mapped read-only: writing to it crashes instead of
+ * corrupting other processes' images (Pipeline only writes to deep copies). The image stays
+ * pinned in the segment until the last header referring to it is released.
+ *
+ * Thread-safe. Images that cannot be placed (see SharedImageStore) are simply not cached, so
+ * isCached should be checked before getCached, as Pipeline does.
+ */
+class SharedMemoryCacheManager : public CacheManager<cv::Mat> {
+public:
+    /**
+     * @brief Attach to (or create) a shared cache.
+     *
+     * @param name Segment name, e.g. "/pixlink-cache".
+     * @param options Geometry used if this process creates the segment.
+     * @throws std::runtime_error if the segment cannot be used.
+     */
+    explicit SharedMemoryCacheManager(const std::string& name, const SharedMemoryCacheOptions& options = {})
+        : store_(std::make_shared<SharedImageStore>(name, options)) {}
+
+    /**
+     * @brief Copy an image into shared memory, replacing any previous image under the key.
+     * @param key The unique string key identifying the image.
+     * @param image The image data to cache (2D).
+     */
+    void cacheImage(const std::string& key, const cv::Mat& image) override {
+        if (image.empty() || image.dims != 2) return;
+        size_t rowBytes = static_cast<size_t>(image.cols) * image.elemSize();
+        SharedImageStore::ImageInfo info{image.rows, image.cols, image.type(), rowBytes * static_cast<size_t>(image.rows)};
+        bool stored = store_->insert(key, info, [&](unsigned char* pixels) {
+            for (int r = 0; r < image.rows; ++r) std::memcpy(pixels + r * rowBytes, image.ptr(r), rowBytes);
+        });
+        if (stored) counters_.recordInsertion();
+    }
+
+    /**
+     * @brief Check if an image is in the shared cache (possibly stored by another process).
+     * @param key The key to query.
+     * @return true if the image is cached, false otherwise.
+     */
+    bool isCached(const std::string& key) const override {
+        std::chrono::nanoseconds cost{0};
+        if (!store_->contains(key, &cost)) {
+            counters_.recordMiss(CacheOp::IsCached);
+            return false;
+        }
+        counters_.recordHit(CacheOp::IsCached);
+        counters_.recordDecodeSaved(cost);
+        return true;
+    }
+
+    /**
+     * @brief Retrieve a private deep copy of a cached image.
+     * @param key The key identifying the cached image.
+     * @return cv::Mat The cached image.
+     * @throws std::runtime_error if the key is not found.
+     */
+    cv::Mat getCached(const std::string& key) const override {
+        return view(key, CacheOp::Get).clone();
+    }
+
+    /**
+     * @brief Retrieve a read-only header over the shared pixels (no copy).
+     * @param key The key identifying the cached image.
+     * @return cv::Mat View of the cached image; do not write to it.
+     * @throws std::runtime_error if the key is not found.
+     */
+    cv::Mat getCachedShallow(const std::string& key) const override {
+        return view(key, CacheOp::GetShallow);
+    }
+
+    /**
+     * @brief Remove an image for all processes (its pages are freed once no view refers to them).
+     * @param key The key of the image to remove.
+     */
+    void remove(const std::string& key) override { store_->remove(key); }
+
+    /**
+     * @brief Remove every image, for all processes.
+     */
+    void clear() override { store_->clear(); }
+
+    /**
+     * @brief Get the keys of all images in the shared cache.
+     * @return std::vector<std::string> Vector of cached keys.
+     */
+    std::vector<std::string> getKeys() const override { return store_->keys(); }
+
+    /**
+     * @brief This process's hit/miss counters, with the segment's resident and peak bytes.
+     *
+     * Evictions count images this process evicted to make room.
+     *
+     * @return Current counters.
+     */
+    CacheStatsSnapshot stats() const override {
+        CacheStatsSnapshot s = counters_.snapshot();
+        s.evictions = store_->evictions();
+        s.residentBytes = store_->usedBytes();
+        s.peakBytes = store_->peakBytes();
+        return s;
+    }
+
+    /**
+     * @brief Record the decode cost of a cached image, credited on isCached hits in every process.
+     * @param key Key of the cached image.
+     * @param cost Time spent decoding it.
+     */
+    void noteDecodeCost(const std::string& key, std::chrono::nanoseconds cost) override {
+        store_->setDecodeCost(key, cost);
+    }
+
+private:
+    cv::Mat view(const std::string& key, CacheOp op) const {
+        std::optional<SharedImageStore::Lease> lease = store_->acquire(key);
+        if (!lease) {
+            counters_.recordMiss(op);
+            throw std::runtime_error("Key not found in cache: " + key);
+        }
+        counters_.recordHit(op);
+        auto* pixels = const_cast<unsigned char*>(lease->data); // Mapped read-only; cv::Mat has no const view
+        cv::Mat image(lease->info.rows, lease->info.cols, lease->info.type, pixels);
+        // Hand the header a UMatData so OpenCV's reference counting tells us when the last copy goes
+        cv::UMatData* u = new cv::UMatData(&detail::SharedViewAllocator::instance());
+        u->data = u->origdata = pixels;
+        u->size = lease->info.bytes;
+        u->refcount = 1;
+        u->userdata = new detail::SharedViewAllocator::Token{store_, lease->entry};
+        image.u = u;
+        return image;
+    }
+
+    std::shared_ptr<SharedImageStore> store_; ///< Shared with live views
+    mutable CacheStats counters_;
+};
+
+} // namespace pipeline
+
+#endif // HAVE_OPENCV_CORE && PIPELINE_HAS_SHM
@@ -0,0 +1,360 @@
+#pragma once
+
+#include "pipeline/strategy.hpp"
+#include "pipeline/strategy_lru.hpp"
+#include "pipeline/image_traits.hpp"
+#include "pipeline/mapped_file.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace pipeline {
+
+/**
+ * @brief Bloom filter over string keys: answers "definitely absent" without touching the index.
+ *
+ * Uses k = 4 probes derived from one hash (double hashing). Keys cannot be removed, so owners
+ * rebuild it from their live keys once too many have been dropped.
+ */
+class BloomFilter {
+public:
+    /**
+     * @brief Construct a filter sized for `expectedKeys` keys at about 1-2% false positives.
+     */
+    explicit BloomFilter(size_t expectedKeys) {
+        size_t bits = 64;
+        while (bits < expectedKeys * 10) bits <<= 1;
+        words_.assign(bits / 64, 0);
+    }
+
+    void add(const std::string& key) {
+        auto [h1, h2] = hashes(key);
+        for (unsigned i = 0; i < kProbes; ++i) {
+            size_t bit = static_cast<size_t>(h1 + i * h2) & (words_.size() * 64 - 1);
+            words_[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+
+    /**
+     * @brief false if the key was never added; true if it probably was.
+     */
+    bool mayContain(const std::string& key) const {
+        auto [h1, h2] = hashes(key);
+        for (unsigned i = 0; i < kProbes; ++i) {
+            size_t bit = static_cast<size_t>(h1 + i * h2) & (words_.size() * 64 - 1);
+            if (!(words_[bit / 64] & (uint64_t(1) << (bit % 64)))) return false;
+        }
+        return true;
+    }
+
+    void clear() { std::fill(words_.begin(), words_.end(), 0); }
+
+private:
+    static constexpr unsigned kProbes = 4;
+
+    static std::pair<uint64_t, uint64_t> hashes(const std::string& key) {
+        uint64_t h = std::hash<std::string>{}(key);
+        uint64_t h2 = (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9ull;
+        return {h, (h2 ^ (h2 >> 32)) | 1};
+    }
+
+    std::vector<uint64_t> words_;
+};
+
+/**
+ * @brief Two-tier cache: an LRUCacheManager in memory, backed by raw image files on a local disk.
+ *
+ * Images evicted from the memory tier are written uncompressed (Traits::writeRaw) to a scratch
+ * directory instead of being dropped. A lookup that misses in memory checks a Bloom filter and
+ * an in-memory index; on a disk hit the file is memory-mapped, rebuilt with Traits::readRaw and
+ * promoted back into memory. Reading raw pixels from a fast disk is much cheaper than decoding
+ * a large JPEG again.
+ *
+ * The disk tier is bounded in bytes and evicts its least recently used files. Files stay on disk
+ * while their image is promoted, so an image evicted again is not rewritten. Each instance writes
+ * into its own freshly created subdirectory of the scratch directory, so several caches (or
+ * processes) can share one scratch directory. Scratch files are deleted by clear(), and the
+ * subdirectory by the destructor.
+ *
+ * Types whose Traits cannot write raw files (the primary ImageTraits) behave like a plain LRU.
+ *
+ * @tparam ImageType The image data type stored in the cache.
+ * @tparam Traits Provides byteSize, writeRaw and readRaw. Defaults to ImageTraits.
+ */
+template <typename ImageType, typename Traits = ImageTraits<ImageType>>
+class SpillCacheManager : public CacheManager<ImageType> {
+public:
+    /**
+     * @brief Construct a spilling cache.
+     *
+     * @param memory Memory tier (count- or byte-bounded LRU); its eviction listener is taken over.
+     * @param scratchDir Directory for raw files, created if needed. Should be on a fast local disk.
+     *        The files go into a new, uniquely named subdirectory.
+     * @param diskBudget Maximum total size of the raw files.
+     * @param expectedDiskEntries Sizing hint for the Bloom filter.
+     * @throws std::runtime_error if memory is null.
+     */
+    SpillCacheManager(std::unique_ptr<LRUCacheManager<ImageType, Traits>> memory, std::string scratchDir,
+                      ByteBudget diskBudget, size_t expectedDiskEntries = 4096)
+        : memory_(std::move(memory))
+        , scratchDir_(makeInstanceDir(scratchDir))
+        , maxDiskBytes_(diskBudget.bytes)
+        , bloom_(expectedDiskEntries) {
+        if (!memory_) {
+            std::error_code ec;
+            std::filesystem::remove(scratchDir_, ec);
+            throw std::runtime_error("SpillCacheManager requires a memory tier");
+        }
+        memory_->setEvictionListener([this](const std::string& key, const ImageType& image) { spill(key, image); });
+    }
+
+    ~SpillCacheManager() override {
+        memory_->setEvictionListener(nullptr);
+        dropAllFiles();
+        std::error_code ec;
+        std::filesystem::remove(scratchDir_, ec);
+    }
+
+    SpillCacheManager(const SpillCacheManager&) = delete;
+    SpillCacheManager& operator=(const SpillCacheManager&) = delete;
+
+    /**
+     * @brief Cache an image in memory, discarding any older copy on disk.
+     * @param key The unique string key identifying the image.
+     * @param image The image data to cache.
+     */
+    void cacheImage(const std::string& key, const ImageType& image) override {
+        dropFile(key);
+        counters_.recordInsertion();
+        memory_->cacheImage(key, image);
+    }
+
+    /**
+     * @brief Check if an image is cached in memory or on disk.
+     * @param key The key to query.
+     * @return true if the image is cached, false otherwise.
+     */
+    bool isCached(const std::string& key) const override {
+        if (memory_->isCached(key) || onDisk(key)) {
+            counters_.recordHit(CacheOp::IsCached);
+            return true;
+        }
+        counters_.recordMiss(CacheOp::IsCached);
+        return false;
+    }
+
+    /**
+     * @brief Retrieve a cached image (deep copy), promoting it from disk if needed.
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image.
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCached(const std::string& key) const override {
+        return fetch(key, CacheOp::Get).clone();
+    }
+
+    /**
+     * @brief Retrieve a cached image without copying, promoting it from disk if needed.
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image (shallow copy).
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCachedShallow(const std::string& key) const override {
+        return fetch(key, CacheOp::GetShallow);
+    }
+
+    /**
+     * @brief Remove an image from memory and disk.
+     * @param key The key of the image to remove.
+     */
+    void remove(const std::string& key) override {
+        memory_->remove(key);
+        dropFile(key);
+    }
+
+    /**
+     * @brief Clear both tiers and delete the scratch files.
+     */
+    void clear() override {
+        memory_->clear();
+        dropAllFiles();
+    }
+
+    /**
+     * @brief Get the cached keys: memory tier first, then images only on disk.
+     * @return std::vector<std::string> Vector of cached keys.
+     */
+    std::vector<std::string> getKeys() const override {
+        std::vector<std::string> keys = memory_->getKeys();
+        std::vector<std::string> inMemory = keys;
+        std::sort(inMemory.begin(), inMemory.end());
+        for (const auto& key : diskUsage_)
+            if (!std::binary_search(inMemory.begin(), inMemory.end(), key)) keys.push_back(key);
+        return keys;
+    }
+
+    /**
+     * @brief Total size of the raw files on disk.
+     */
+    size_t diskBytes() const { return diskBytes_; }
+
+    /**
+     * @brief Number of images found on disk after missing in memory.
+     */
+    uint64_t diskHits() const { return diskHits_; }
+
+    /**
+     * @brief Counters of this cache as a whole; evictions count images dropped from disk.
+     *
+     * Resident bytes are the memory tier's (see diskBytes for the disk tier).
+     *
+     * @return Current counters.
+     */
+    CacheStatsSnapshot stats() const override {
+        CacheStatsSnapshot s = counters_.snapshot();
+        CacheStatsSnapshot memory = memory_->stats();
+        s.residentBytes = memory.residentBytes;
+        s.peakBytes = memory.peakBytes;
+        s.decodeTimeSaved = memory.decodeTimeSaved;
+        return s;
+    }
+
+    /**
+     * @brief Remember the decode cost of an image held in memory.
+     * @param key Key of the cached image.
+     * @param cost Time spent decoding it.
+     */
+    void noteDecodeCost(const std::string& key, std::chrono::nanoseconds cost) override {
+        memory_->noteDecodeCost(key, cost);
+    }
+
+private:
+    struct DiskEntry {
+        std::string path;
+        size_t bytes;
+        std::list<std::string>::iterator position;
+    };
+
+    bool onDisk(const std::string& key) const {
+        return bloom_.mayContain(key) && index_.count(key) > 0;
+    }
+
+    // Memory-tier lookup without isCached, which would credit the decode cost a second time
+    std::optional<ImageType> fromMemory(const std::string& key) const {
+        try {
+            return memory_->getCachedShallow(key);
+        } catch (const std::runtime_error&) {
+            return std::nullopt;
+        }
+    }
+
+    ImageType fetch(const std::string& key, CacheOp op) const {
+        if (auto image = fromMemory(key)) {
+            counters_.recordHit(op);
+            return *image;
+        }
+        if (onDisk(key)) {
+            auto it = index_.find(key);
+            MappedFile file(it->second.path);
+            std::optional<ImageType> image = file.valid() ? Traits::readRaw(file.data(), file.size()) : std::nullopt;
+            if (image) {
+                counters_.recordHit(op);
+                ++diskHits_;
+                diskUsage_.splice(diskUsage_.begin(), diskUsage_, it->second.position);
+                memory_->cacheImage(key, *image); // May spill another image
+                return *image;
+            }
+            dropFile(key); // Unreadable: forget it
+        }
+        counters_.recordMiss(op);
+        throw std::runtime_error("Key not found in cache: " + key);
+    }
+
+    // Create a subdirectory no other instance uses; create_directory fails if the name is taken
+    static std::string makeInstanceDir(const std::string& parent) {
+        std::filesystem::create_directories(parent);
+        std::random_device seed;
+        std::mt19937_64 random((uint64_t(seed()) << 32) ^ seed());
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            char name[24];
+            std::snprintf(name, sizeof(name), "spill-%016llx", static_cast<unsigned long long>(random()));
+            std::filesystem::path dir = std::filesystem::path(parent) / name;
+            if (std::filesystem::create_directory(dir)) return dir.string();
+        }
+        throw std::runtime_error("Cannot create a scratch directory in " + parent);
+    }
+
+    // Memory-tier eviction: keep the image as a raw file unless it is already on disk
+    void spill(const std::string& key, const ImageType& image) {
+        if (index_.count(key)) return;
+        std::string path = (std::filesystem::path(scratchDir_) / (std::to_string(nextFile_++) + ".raw")).string();
+        std::error_code ec;
+        if (!Traits::writeRaw(image, path)) {
+            std::filesystem::remove(path, ec);
+            counters_.recordEviction();
+            return;
+        }
+        size_t size = static_cast<size_t>(std::filesystem::file_size(path, ec));
+        if (ec) size = Traits::byteSize(image);
+        diskUsage_.push_front(key);
+        index_.emplace(key, DiskEntry{path, size, diskUsage_.begin()});
+        bloom_.add(key);
+        diskBytes_ += size;
+        while (diskBytes_ > maxDiskBytes_ && !diskUsage_.empty()) {
+            dropFile(diskUsage_.back());
+            counters_.recordEviction();
+        }
+    }
+
+    void dropFile(const std::string& key) const {
+        auto it = index_.find(key);
+        if (it == index_.end()) return;
+        std::error_code ec;
+        std::filesystem::remove(it->second.path, ec);
+        diskBytes_ -= it->second.bytes;
+        diskUsage_.erase(it->second.position);
+        index_.erase(it);
+        // The filter cannot forget keys; rebuild it once dropped keys outnumber live ones
+        if (++droppedSinceRebuild_ > index_.size() + 64) {
+            bloom_.clear();
+            for (const auto& entry : index_) bloom_.add(entry.first);
+            droppedSinceRebuild_ = 0;
+        }
+    }
+
+    void dropAllFiles() {
+        std::error_code ec;
+        for (const auto& entry : index_) std::filesystem::remove(entry.second.path, ec);
+        index_.clear();
+        diskUsage_.clear();
+        bloom_.clear();
+        diskBytes_ = 0;
+        droppedSinceRebuild_ = 0;
+    }
+
+    std::unique_ptr<LRUCacheManager<ImageType, Traits>> memory_; ///< Memory tier
+    std::string scratchDir_;
+    size_t maxDiskBytes_;
+    // The disk tier changes during const lookups (promotions spill, unreadable files are dropped)
+    mutable size_t diskBytes_ = 0;
+    uint64_t nextFile_ = 0;
+    mutable size_t droppedSinceRebuild_ = 0;
+    mutable uint64_t diskHits_ = 0;
+    mutable std::list<std::string> diskUsage_; ///< Keys on disk, most recently used first
+    mutable std::unordered_map<std::string, DiskEntry> index_; ///< Key to raw file
+    mutable BloomFilter bloom_; ///< Fast negative lookups for index_
+    mutable CacheStats counters_; ///< Updated by const lookups too
+};
+
+} // namespace pipeline
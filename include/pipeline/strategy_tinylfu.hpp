@@ -0,0 +1,335 @@
+#pragma once
+
+#include "pipeline/strategy.hpp"
+#include "pipeline/image_traits.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdexcept>
+
+namespace pipeline {
+
+/**
+ * @brief Count-min sketch of access frequencies with 4-bit counters and periodic aging.
+ *
+ * Estimates how often a key was seen using four counters per key (one per row, the minimum
+ * wins) packed 16 per 64-bit word. After about 10 increments per expected key, every counter
+ * is halved so old popularity fades.
+ */
+class FrequencySketch {
+public:
+    /**
+     * @brief Construct a sketch sized for about `expectedKeys` distinct keys.
+     */
+    explicit FrequencySketch(size_t expectedKeys) {
+        size_t words = 1;
+        while (words * 4 < expectedKeys) words <<= 1; // 16 counters per word, 4 rows
+        table_.assign(words, 0);
+        sampleSize_ = std::max<size_t>(words * 16 * 10 / 4, 10);
+    }
+
+    /**
+     * @brief Record one access to the key.
+     */
+    void increment(const std::string& key) {
+        uint64_t hash = spread(std::hash<std::string>{}(key));
+        bool added = false;
+        for (unsigned row = 0; row < kRows; ++row) {
+            auto [word, shift] = slot(hash, row);
+            if (((table_[word] >> shift) & 0xF) != 0xF) {
+                table_[word] += uint64_t(1) << shift;
+                added = true;
+            }
+        }
+        if (added && ++additions_ >= sampleSize_) age();
+    }
+
+    /**
+     * @brief Estimated number of accesses to the key (at most 15).
+     */
+    unsigned frequency(const std::string& key) const {
+        uint64_t hash = spread(std::hash<std::string>{}(key));
+        unsigned estimate = 0xF;
+        for (unsigned row = 0; row < kRows; ++row) {
+            auto [word, shift] = slot(hash, row);
+            estimate = std::min(estimate, static_cast<unsigned>((table_[word] >> shift) & 0xF));
+        }
+        return estimate;
+    }
+
+    /**
+     * @brief Forget all recorded accesses.
+     */
+    void clear() {
+        std::fill(table_.begin(), table_.end(), 0);
+        additions_ = 0;
+    }
+
+private:
+    static constexpr unsigned kRows = 4;
+
+    static uint64_t spread(uint64_t hash) {
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    // Word index and bit offset of the key's counter in the given row
+    std::pair<size_t, unsigned> slot(uint64_t hash, unsigned row) const {
+        static constexpr std::array<uint64_t, kRows> seeds = {
+            0x97CB3127B2A6D1D3ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0x9E3779B97F4A7C15ull};
+        uint64_t h = (hash + seeds[row]) * seeds[row];
+        size_t word = static_cast<size_t>(h >> 32) & (table_.size() - 1);
+        unsigned counter = row * 4 + static_cast<unsigned>(h & 3); // rows use disjoint counters within a word
+        return {word, counter * 4};
+    }
+
+    void age() {
+        for (auto& word : table_) word = (word >> 1) & 0x7777777777777777ull;
+        additions_ /= 2;
+    }
+
+    std::vector<uint64_t> table_;
+    size_t sampleSize_;
+    size_t additions_ = 0;
+};
+
+/**
+ * @brief W-TinyLFU cache: frequency-based admission in front of a segmented LRU.
+ *
+ * New images enter a small LRU window (1% of capacity). An image leaving the window is only
+ * admitted to the main cache if the FrequencySketch says it has been accessed more often than
+ * the main cache's eviction victim; otherwise it is dropped. The main cache is a segmented LRU:
+ * images reused while on probation are promoted to the protected segment (80% of the main cache).
+ * Popular images thus survive scans and one-off loads.
+ *
+ * The read that directly follows an insertion (the pipeline loads then reads) is not counted
+ * as a separate access.
+ *
+ * @tparam ImageType The image data type stored in the cache.
+ * @tparam Traits Provides byteSize(image), used for the byte statistics. Defaults to ImageTraits.
+ */
+template <typename ImageType, typename Traits = ImageTraits<ImageType>>
+class TinyLFUCacheManager : public CacheManager<ImageType> {
+public:
+    /**
+     * @brief Construct a new TinyLFUCacheManager.
+     * @param capacity Maximum number of images the cache can hold.
+     */
+    explicit TinyLFUCacheManager(size_t capacity)
+        : capacity_(std::max<size_t>(capacity, 1))
+        , windowCapacity_(std::max<size_t>(capacity_ / 100, 1))
+        , mainCapacity_(capacity_ > windowCapacity_ ? capacity_ - windowCapacity_ : 0)
+        , protectedCapacity_(mainCapacity_ * 8 / 10)
+        , sketch_(capacity_) {}
+
+    /**
+     * @brief Cache an image with the associated key.
+     *
+     * A new image goes into the window; the image it pushes out of the window then competes
+     * with the main cache's victim for admission.
+     *
+     * @param key The unique string key identifying the image.
+     * @param image The image data to cache.
+     */
+    void cacheImage(const std::string& key, const ImageType& image) override {
+        counters_.recordInsertion();
+        sketch_.increment(key);
+        auto it = map_.find(key);
+        if (it != map_.end()) {
+            bytes_ -= Traits::byteSize(it->second.image);
+            it->second.image = image;
+            it->second.decodeCost = std::chrono::nanoseconds(0);
+            bytes_ += Traits::byteSize(image);
+            peakBytes_ = std::max(peakBytes_, bytes_);
+            return;
+        }
+        window_.push_front(key);
+        map_.emplace(key, Node{image, Segment::Window, window_.begin(), true, std::chrono::nanoseconds(0)});
+        bytes_ += Traits::byteSize(image);
+        peakBytes_ = std::max(peakBytes_, bytes_);
+        if (window_.size() > windowCapacity_) admitFromWindow();
+    }
+
+    /**
+     * @brief Check if an image identified by key is cached.
+     * @param key The key to query.
+     * @return true if the image is cached, false otherwise.
+     */
+    bool isCached(const std::string& key) const override {
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            counters_.recordMiss(CacheOp::IsCached);
+            return false;
+        }
+        counters_.recordHit(CacheOp::IsCached);
+        counters_.recordDecodeSaved(it->second.decodeCost);
+        return true;
+    }
+
+    /**
+     * @brief Retrieve a cached image by key (deep copy) and record the access.
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image.
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCached(const std::string& key) const override {
+        return touch(key, CacheOp::Get).clone();
+    }
+
+    /**
+     * @brief Retrieve a cached image by key without copying and record the access.
+     * @param key The key identifying the cached image.
+     * @return ImageType The cached image (shallow copy).
+     * @throws std::runtime_error if the key is not found.
+     */
+    ImageType getCachedShallow(const std::string& key) const override {
+        return touch(key, CacheOp::GetShallow);
+    }
+
+    /**
+     * @brief Remove an image from the cache by key. Its access history is kept.
+     * @param key The key of the image to remove.
+     */
+    void remove(const std::string& key) override {
+        auto it = map_.find(key);
+        if (it == map_.end()) return;
+        bytes_ -= Traits::byteSize(it->second.image);
+        listFor(it->second.segment).erase(it->second.position);
+        map_.erase(it);
+    }
+
+    /**
+     * @brief Clear all cached images and the access history.
+     */
+    void clear() override {
+        map_.clear();
+        window_.clear();
+        probation_.clear();
+        protected_.clear();
+        sketch_.clear();
+        bytes_ = 0;
+    }
+
+    /**
+     * @brief Get the cached keys: protected, probation, then window, each most recently used first.
+     * @return std::vector<std::string> Vector of cached keys.
+     */
+    std::vector<std::string> getKeys() const override {
+        std::vector<std::string> keys(protected_.begin(), protected_.end());
+        keys.insert(keys.end(), probation_.begin(), probation_.end());
+        keys.insert(keys.end(), window_.begin(), window_.end());
+        return keys;
+    }
+
+    /**
+     * @brief Snapshot of hit/miss/eviction counters, resident and peak bytes, and decode time saved.
+     * @return Current counters.
+     */
+    CacheStatsSnapshot stats() const override {
+        CacheStatsSnapshot s = counters_.snapshot();
+        s.residentBytes = bytes_;
+        s.peakBytes = peakBytes_;
+        return s;
+    }
+
+    /**
+     * @brief Remember the decode cost of a cached image, credited on later isCached hits.
+     * @param key Key of the cached image.
+     * @param cost Time spent decoding it.
+     */
+    void noteDecodeCost(const std::string& key, std::chrono::nanoseconds cost) override {
+        auto it = map_.find(key);
+        if (it != map_.end()) it->second.decodeCost = cost;
+    }
+
+private:
+    enum class Segment { Window, Probation, Protected };
+
+    struct Node {
+        ImageType image;
+        Segment segment;
+        std::list<std::string>::iterator position;
+        bool fresh;                     ///< Inserted and not read yet
+        std::chrono::nanoseconds decodeCost;
+    };
+
+    std::list<std::string>& listFor(Segment segment) const {
+        return segment == Segment::Window ? window_ : segment == Segment::Probation ? probation_ : protected_;
+    }
+
+    const ImageType& touch(const std::string& key, CacheOp op) const {
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            counters_.recordMiss(op);
+            throw std::runtime_error("Key not found in cache: " + key);
+        }
+        counters_.recordHit(op);
+        Node& node = it->second;
+        if (node.fresh) {
+            node.fresh = false;
+            return node.image;
+        }
+        sketch_.increment(key);
+        if (node.segment == Segment::Probation) {
+            protected_.splice(protected_.begin(), probation_, node.position);
+            node.segment = Segment::Protected;
+            if (protected_.size() > protectedCapacity_) {
+                // Demote the protected segment's least recent image back to probation
+                Node& demoted = map_.find(protected_.back())->second;
+                probation_.splice(probation_.begin(), protected_, demoted.position);
+                demoted.segment = Segment::Probation;
+            }
+        } else {
+            listFor(node.segment).splice(listFor(node.segment).begin(), listFor(node.segment), node.position);
+        }
+        return node.image;
+    }
+
+    // Move the window's least recent image to probation if it is admitted, else drop it
+    void admitFromWindow() {
+        const std::string& candidate = window_.back();
+        if (probation_.size() + protected_.size() >= mainCapacity_) {
+            std::list<std::string>& victims = probation_.empty() ? protected_ : probation_;
+            if (victims.empty() || sketch_.frequency(candidate) <= sketch_.frequency(victims.back())) {
+                evict(window_);
+                return;
+            }
+            evict(victims);
+        }
+        Node& node = map_.find(candidate)->second;
+        probation_.splice(probation_.begin(), window_, node.position);
+        node.segment = Segment::Probation;
+    }
+
+    void evict(std::list<std::string>& from) {
+        counters_.recordEviction();
+        auto it = map_.find(from.back());
+        bytes_ -= Traits::byteSize(it->second.image);
+        from.pop_back();
+        map_.erase(it);
+    }
+
+    size_t capacity_;          ///< Maximum resident images
+    size_t windowCapacity_;    ///< Size of the admission window
+    size_t mainCapacity_;      ///< Size of the main cache (probation + protected)
+    size_t protectedCapacity_; ///< Maximum size of the protected segment
+    mutable std::list<std::string> window_;    ///< Most recent first
+    mutable std::list<std::string> probation_; ///< Main cache, seen once since admission; most recent first
+    mutable std::list<std::string> protected_; ///< Main cache, reused; most recent first
+    mutable std::unordered_map<std::string, Node> map_;
+    mutable FrequencySketch sketch_;
+    size_t bytes_ = 0;
+    size_t peakBytes_ = 0;
+    mutable CacheStats counters_; ///< Updated by const lookups too
+};
+
+} // namespace pipeline
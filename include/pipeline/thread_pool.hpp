@@ -0,0 +1,131 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace pipeline {
+
+/**
+ * @brief Fixed-size worker pool with an optionally bounded task queue.
+ *
+ * submit() blocks while the queue is full, so a fast producer (e.g. a directory walk)
+ * cannot run arbitrarily far ahead of the workers. The first exception escaping a task
+ * is kept and rethrown by wait(). The destructor drains all queued tasks before joining.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Construct a pool and start its workers.
+     *
+     * @param threads Number of workers. 0 selects the hardware concurrency.
+     * @param maxQueued Maximum number of pending tasks before submit() blocks. 0 means unbounded.
+     */
+    explicit ThreadPool(size_t threads = 0, size_t maxQueued = 0) : maxQueued_(maxQueued) {
+        if (threads == 0) threads = defaultConcurrency();
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            workers_.emplace_back([this] { run(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        taskReady_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queue a task, blocking while the queue is at capacity.
+     *
+     * @param task Callable to run on a worker thread.
+     */
+    void submit(std::function<void()> task) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        spaceReady_.wait(lock, [this] { return maxQueued_ == 0 || queue_.size() < maxQueued_; });
+        queue_.push_back(std::move(task));
+        lock.unlock();
+        taskReady_.notify_one();
+    }
+
+    /**
+     * @brief Block until every queued task has finished.
+     *
+     * @throws The first exception thrown by a task since the last wait().
+     */
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return queue_.empty() && active_ == 0; });
+        if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+
+    /**
+     * @brief Number of tasks queued or running.
+     */
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size() + active_;
+    }
+
+    /**
+     * @brief Number of worker threads.
+     */
+    size_t size() const { return workers_.size(); }
+
+    /**
+     * @brief Hardware concurrency, never less than 1.
+     */
+    static size_t defaultConcurrency() {
+        unsigned n = std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }
+
+private:
+    void run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                taskReady_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                task = std::move(queue_.front());
+                queue_.pop_front();
+                ++active_;
+            }
+            spaceReady_.notify_one();
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_) error_ = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            --active_;
+            if (queue_.empty() && active_ == 0) idle_.notify_all();
+        }
+    }
+
+    size_t maxQueued_; ///< Queue bound, 0 = unbounded
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> queue_;
+    mutable std::mutex mutex_;
+    std::condition_variable taskReady_;
+    std::condition_variable spaceReady_;
+    std::condition_variable idle_;
+    size_t active_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+};
+
+} // namespace pipeline
@@ -0,0 +1,298 @@
+#include "pipeline/remote_protocol.hpp"
+#include "pipeline/strategy_lru.hpp"
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef PIPELINE_HAS_REMOTE
+
+namespace remote = pipeline::remote;
+
+/**
+ * @brief A payload as stored by the server; copies share it.
+ */
+struct Stored {
+    remote::PayloadKind kind = remote::PayloadKind::None;
+    std::vector<unsigned char> bytes;
+    uint64_t decodeNanos = 0;
+};
+
+struct Blob {
+    std::shared_ptr<Stored> data;
+    Blob clone() const { return *this; } // Payloads are never modified in place
+};
+
+struct BlobTraits {
+    static size_t byteSize(const Blob& blob) { return blob.data ? blob.data->bytes.size() : 0; }
+};
+
+using Store = pipeline::LRUCacheManager<Blob, BlobTraits>;
+
+/**
+ * @brief One client connection with its unparsed input and unsent output.
+ */
+struct Connection {
+    remote::Socket socket;
+    std::vector<unsigned char> in;
+    std::vector<unsigned char> out;
+    size_t sent = 0;
+};
+
+constexpr size_t kMaxUnsent = size_t(64) << 20;   // Stop reading a client that does not read its responses
+constexpr size_t kMaxReadPerRound = size_t(4) << 20; // Serve other clients between reads from a fast writer
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+/**
+ * @brief Apply one request to the store and append its response.
+ */
+void handle(Store& store, remote::Frame& request, std::vector<unsigned char>& out) {
+    remote::Frame response;
+    response.op = request.op;
+    response.id = request.id;
+    const unsigned char* value = nullptr;
+    size_t valueSize = 0;
+    std::vector<unsigned char> scratch;
+    switch (request.op) {
+    case remote::Op::Get:
+    case remote::Op::Contains: {
+        if (store.isCached(request.key)) {
+            Blob blob = store.getCachedShallow(request.key);
+            response.kind = blob.data->kind;
+            response.aux = blob.data->decodeNanos;
+            if (request.op == remote::Op::Get) {
+                value = blob.data->bytes.data();
+                valueSize = blob.data->bytes.size();
+            }
+            remote::appendFrame(out, response, {}, value, valueSize); // blob keeps the bytes alive until here
+            return;
+        }
+        response.status = remote::Status::NotFound;
+        break;
+    }
+    case remote::Op::Put:
+        if (request.kind != remote::PayloadKind::Raw && request.kind != remote::PayloadKind::Encoded) {
+            response.status = remote::Status::Error;
+            break;
+        }
+        store.cacheImage(request.key, Blob{std::make_shared<Stored>(Stored{request.kind, std::move(request.value), request.aux})});
+        break;
+    case remote::Op::SetCost:
+        try {
+            store.getCachedShallow(request.key).data->decodeNanos = request.aux;
+            store.noteDecodeCost(request.key, std::chrono::nanoseconds(request.aux));
+        } catch (const std::runtime_error&) {
+            response.status = remote::Status::NotFound;
+        }
+        break;
+    case remote::Op::Remove:
+        store.remove(request.key);
+        break;
+    case remote::Op::Clear:
+        store.clear();
+        break;
+    case remote::Op::Keys:
+        for (const auto& key : store.getKeys()) {
+            size_t at = scratch.size();
+            scratch.resize(at + 4 + key.size());
+            remote::putLE(scratch.data() + at, key.size(), 4);
+            std::copy(key.begin(), key.end(), scratch.begin() + static_cast<std::ptrdiff_t>(at + 4));
+        }
+        break;
+    case remote::Op::Stats: {
+        pipeline::CacheStatsSnapshot s = store.stats();
+        const uint64_t fields[] = {s.insertions, s.evictions, s.residentBytes, s.peakBytes, s.isCachedHits, s.isCachedMisses};
+        scratch.resize(sizeof(fields));
+        for (size_t i = 0; i < 6; ++i) remote::putLE(scratch.data() + 8 * i, fields[i], 8);
+        break;
+    }
+    default:
+        response.status = remote::Status::Error;
+        break;
+    }
+    remote::appendFrame(out, response, {}, scratch.data(), scratch.size());
+}
+
+/**
+ * @brief Answer the complete requests buffered from a client, while its unsent output is
+ * below kMaxUnsent. The rest stays buffered until the client has read some responses.
+ *
+ * @param maxValue Largest payload accepted.
+ * @throws remote::ProtocolError on a malformed frame.
+ */
+void parseRequests(Store& store, Connection& c, uint64_t maxValue) {
+    size_t consumed = 0;
+    remote::Frame request;
+    while (c.out.size() - c.sent < kMaxUnsent) {
+        size_t used = remote::parseFrame(c.in.data() + consumed, c.in.size() - consumed, request, maxValue);
+        if (!used) break;
+        consumed += used;
+        handle(store, request, c.out);
+    }
+    c.in.erase(c.in.begin(), c.in.begin() + static_cast<std::ptrdiff_t>(consumed));
+}
+
+/**
+ * @brief Read what a client sent (up to kMaxReadPerRound) and answer the complete requests
+ * (see parseRequests). Stops reading once kMaxUnsent bytes of responses are waiting.
+ *
+ * The input buffer only grows by bytes actually received, and each frame header is
+ * validated as it arrives, so a client cannot make the server allocate more than it sends.
+ *
+ * @param maxValue Largest payload accepted.
+ * @return false if the connection should be closed.
+ */
+bool readRequests(Store& store, Connection& c, uint64_t maxValue) {
+    constexpr size_t kChunk = 256 * 1024;
+    unsigned char chunk[kChunk];
+    bool open = true;
+    try {
+        for (size_t received = 0; open && received < kMaxReadPerRound && c.out.size() - c.sent < kMaxUnsent;) {
+            ssize_t n = ::recv(c.socket.fd(), chunk, kChunk, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n <= 0) {
+                open = false; // Still answer what arrived before the client hung up
+                break;
+            }
+            c.in.insert(c.in.end(), chunk, chunk + n);
+            received += static_cast<size_t>(n);
+            parseRequests(store, c, maxValue);
+        }
+    } catch (const remote::ProtocolError& e) {
+        std::cerr << "Closing connection: " << e.what() << "\n";
+        return false;
+    }
+    if (c.in.capacity() > kMaxReadPerRound && c.in.size() < kMaxReadPerRound) c.in.shrink_to_fit(); // After a large payload
+    return open;
+}
+
+/**
+ * @brief Send as much pending output as the socket takes.
+ * @return false if the connection should be closed.
+ */
+bool writeResponses(Connection& c) {
+    while (c.sent < c.out.size()) {
+        ssize_t n = ::send(c.socket.fd(), c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (n <= 0) return false;
+        c.sent += static_cast<size_t>(n);
+    }
+    c.out.clear();
+    c.sent = 0;
+    return true;
+}
+
+void usage() {
+    std::cerr << "Usage: pixlink-cache-server [--listen ADDRESS]... [--memory-mb N]\n"
+              << "  --listen ADDRESS  tcp://host:port, host:port or unix:/path (default tcp://127.0.0.1:7070)\n"
+              << "  --memory-mb N     Bytes of payloads kept, least recently used evicted first (default 1024)\n";
+}
+
+/**
+ * @brief Reference cache server for RemoteCacheManager.
+ * Keeps payloads in memory, bounded by bytes, and serves any number of clients from one thread.
+ * Stops on SIGINT/SIGTERM, printing its counters.
+ */
+int main(int argc, char** argv) {
+    std::vector<std::string> addresses;
+    size_t memoryMiB = 1024;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--listen" && i + 1 < argc) {
+            addresses.push_back(argv[++i]);
+        } else if (arg == "--memory-mb" && i + 1 < argc) {
+            memoryMiB = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (addresses.empty()) addresses.push_back("tcp://127.0.0.1:7070");
+
+    struct sigaction onStop {};
+    onStop.sa_handler = [](int) { stopRequested = 1; };
+    ::sigaction(SIGINT, &onStop, nullptr); // No SA_RESTART: poll returns EINTR
+    ::sigaction(SIGTERM, &onStop, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<remote::Socket> listeners;
+    try {
+        for (const auto& address : addresses) {
+            listeners.push_back(remote::Socket::listen(remote::Endpoint::parse(address)));
+            std::cout << "Listening on " << address << "\n";
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    Store store(pipeline::ByteBudget{memoryMiB << 20});
+    const uint64_t maxValue = std::min<uint64_t>(remote::kMaxValue, memoryMiB << 20); // Larger payloads could never be kept
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::vector<pollfd> fds;
+    while (!stopRequested) {
+        fds.clear();
+        for (const auto& l : listeners) fds.push_back({l.fd(), POLLIN, 0});
+        for (const auto& c : connections) {
+            short events = c->out.size() - c->sent < kMaxUnsent ? POLLIN : 0;
+            if (c->sent < c->out.size()) events |= POLLOUT;
+            fds.push_back({c->socket.fd(), events, 0});
+        }
+        if (::poll(fds.data(), fds.size(), -1) < 0) continue;
+
+        for (size_t i = 0; i < listeners.size(); ++i) {
+            if (!(fds[i].revents & POLLIN)) continue;
+            int fd;
+            while ((fd = ::accept(listeners[i].fd(), nullptr, nullptr)) >= 0) {
+                auto c = std::make_unique<Connection>();
+                c->socket = remote::Socket(fd);
+                c->socket.setNonBlocking();
+                int one = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // Fails harmlessly on Unix sockets
+                connections.push_back(std::move(c));
+            }
+        }
+        // Connections accepted above have no pollfd yet and are served next round
+        size_t polled = fds.size() - listeners.size();
+        std::vector<bool> closed(connections.size(), false);
+        for (size_t j = 0; j < polled; ++j) {
+            Connection& c = *connections[j];
+            short revents = fds[listeners.size() + j].revents;
+            bool ok = true;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) ok = readRequests(store, c, maxValue);
+            if (ok && (revents & (POLLIN | POLLOUT))) ok = writeResponses(c);
+            if (ok && (revents & POLLOUT) && !c.in.empty()) { // Requests held back while output was full
+                try {
+                    parseRequests(store, c, maxValue);
+                } catch (const remote::ProtocolError& e) {
+                    std::cerr << "Closing connection: " << e.what() << "\n";
+                    ok = false;
+                }
+            }
+            closed[j] = !ok;
+        }
+        for (size_t j = polled; j-- > 0;)
+            if (closed[j]) connections.erase(connections.begin() + static_cast<std::ptrdiff_t>(j));
+    }
+
+    std::cout << store.stats() << "\n";
+    return 0;
+}
+
+#else
+
+/**
+ * @brief Fallback main on platforms without POSIX sockets.
+ */
+int main() {
+    std::cerr << "The cache server needs POSIX sockets.\n";
+    return 1;
+}
+
+#endif
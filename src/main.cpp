@@ -1,17 +1,20 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <string>
+
+#ifdef HAVE_OPENCV_CORE
+
 #include "pipeline/pipeline.hpp"
 #include "pipeline/strategy_lru.hpp"
+#include "pipeline/strategy_async.hpp"
 #include "pipeline/opencv_specializations.hpp"
+#include "pipeline/mat_pool.hpp"
 #include "faceDetector/face_detector.hpp"
 #include "pipeline/region_pipeline.hpp"
 #include <opencv2/core/utils/logger.hpp>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
-#include <iostream>
-#include <memory>
-#include <vector>
-#include <string>
-
-#ifdef HAVE_OPENCV_CORE
 
 /**
  * @brief Strong Gaussian blur filter using OpenCV, in-place on ROI.
@@ -51,6 +54,7 @@ auto pixelateInPlace = [](cv::Mat& img, const cv::Rect& roi, int blockSize = 12)
 using Pipeline = pipeline::Pipeline<cv::Mat>;
 using LRUCacheManager = pipeline::LRUCacheManager<cv::Mat>;
 using CacheManager = pipeline::CacheManager<cv::Mat>;
+using AsyncImageSaver = pipeline::AsyncImageSaver<cv::Mat>;
 using RegionPipeline = pipeline::RegionPipeline<cv::Mat, cv::Rect>;
 
 /**
@@ -60,36 +64,52 @@ using RegionPipeline = pipeline::RegionPipeline<cv::Mat, cv::Rect>;
  */
 int main() {
     cv::utils::logging::setLogLevel(cv::utils::logging::LOG_LEVEL_ERROR);
+    // Recycle decoded/processed pixel buffers instead of reallocating them for every image
+    pipeline::installMatPool();
     try {
         const std::string inputPath = "../images/";
         const std::string outputPath = "output_images/";
         std::vector<std::string> extensions = {".jpg", ".jpeg"}; // Add more extensions
 
-        // Create a cache manager with capacity for 100 images
-        std::unique_ptr<CacheManager> cache = std::make_unique<LRUCacheManager>(100);
+        // Create a cache manager holding at most 1 GiB of decoded pixels
+        std::unique_ptr<CacheManager> cache = std::make_unique<LRUCacheManager>(pipeline::ByteBudget{size_t(1) << 30});
+
+        // Encode and write outputs on a background thread while the next variant is processed
+        auto saver = std::make_unique<AsyncImageSaver>(2);
+
+        // Initialize pipeline with input/output paths, cache manager and saver
+        Pipeline pipeline(inputPath, outputPath, std::move(cache), nullptr, std::move(saver));
 
-        // Initialize pipeline with input/output paths and cache manager
-        Pipeline pipeline(inputPath, outputPath, std::move(cache));
+        // Encoder settings per output folder: good quality by default, cheap encodes for the mosaic previews
+        pipeline.setProfile("people", pipeline::EncodeProfile::balanced())
+                .setProfile("people/pixelateInPlace", pipeline::EncodeProfile::fast());
 
         // Process each loaded image key by applying filters and saving outputs
         FaceDetector detector("../deploy.prototxt", "../res10_300x300_ssd_iter_140000_fp16.caffemodel");
 
-        // Region pipeline for region-based processing without modifying generic pipeline
-        auto detectorFunc = [&](const cv::Mat &img){ return detector.detect(img); };
-        RegionPipeline regionPipeline(detectorFunc, pipeline.getWorkingMap());
-
         // --------- Processing ----------
-        // Load images from the inputPath directory with specified extensions
-        pipeline.loadDirectory("people", extensions);
+        // Register images from the inputPath directory with specified extensions (decoded on first use)
+        pipeline.setLoadMode(pipeline::LoadMode::Lazy).loadDirectory("people", extensions);
 
-        // Filter pipeline to keep only images with faces
+        // Drop images too small to be worth processing, reading only their headers
+        pipeline.filterByInfo([](const std::string &, const pipeline::ImageInfo &info)
+                              { return info.width >= 300 && info.height >= 300; });
+
+        // Filter pipeline to keep only images with faces, detecting on reduced decodes (at least 600px)
         pipeline.filter([&](const std::string &, const cv::Mat &img)
-                        { return detector.countFaces(img) > 0; });
-        
+                        { return detector.countFaces(img) > 0; },
+                        pipeline::DecodeOptions{.minWidth = 600, .minHeight = 600});
+
+        // Region pipeline for region-based processing without modifying generic pipeline.
+        // It edits the working map in place, so it is created only once filtering has run on
+        // headers and previews: taking the map decodes the survivors and turns off passthrough.
+        auto detectorFunc = [&](const cv::Mat &img){ return detector.detect(img); };
+        RegionPipeline regionPipeline(detectorFunc, pipeline.getWorkingMap());
+
         // Now process only the images with faces detected
         for (const auto &key : pipeline.getAllImageKeys()) {
             // Show face-detector-filter detections and counts
-            int count = detector.countFaces(pipeline.getWorkingMap().at(key));
+            int count = detector.countFaces(pipeline.getImage(key));
             std::cout << "faces detected in " << key << ": " << count << "\n";
 
             regionPipeline.processRegion(key, gaussianBlurInPlace);
@@ -112,6 +132,9 @@ int main() {
             pipeline.unload(key); // Optionally unload
         }
 
+        // Wait for queued saves and surface any write error
+        pipeline.flush();
+
         std::cout << "Processing completed successfully.\n";
     } catch (const std::exception& ex) {
         std::cerr << "Error: " << ex.what() << "\n";
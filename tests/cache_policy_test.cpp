@@ -0,0 +1,94 @@
+#include "test_image.hpp"
+#include "pipeline/strategy_2q.hpp"
+#include "pipeline/strategy_arc.hpp"
+#include "pipeline/strategy_lru.hpp"
+#include "pipeline/strategy_tinylfu.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using pipeline::ARCCacheManager;
+using pipeline::CacheManager;
+using pipeline::TinyLFUCacheManager;
+using pipeline::TwoQueueCacheManager;
+
+namespace {
+
+// One pipeline access: a hit is read from the cache, a miss is "decoded", inserted and read
+void use(CacheManager<TestImage>& cache, const std::string& key) {
+    if (!cache.isCached(key)) cache.cacheImage(key, TestImage{key});
+    cache.getCachedShallow(key);
+}
+
+const std::vector<std::string> kHot{"h0", "h1", "h2", "h3"};
+
+// Reuse a hot set among one-off images, then scan 100 new images once; true if the hot set is still cached
+bool hotSetSurvivesAScan(CacheManager<TestImage>& cache) {
+    int oneOff = 0;
+    for (int round = 0; round < 10; ++round) {
+        for (const auto& key : kHot) use(cache, key);
+        for (int i = 0; i < 3; ++i) use(cache, "once" + std::to_string(oneOff++));
+    }
+    for (int i = 0; i < 100; ++i) use(cache, "scan" + std::to_string(i));
+    for (const auto& key : kHot)
+        if (!cache.isCached(key)) return false;
+    return true;
+}
+
+TEST(CachePolicyTest, ScanEvictsTheHotSetFromAnLRU) {
+    pipeline::LRUCacheManager<TestImage> cache(8);
+    EXPECT_FALSE(hotSetSurvivesAScan(cache)); // The baseline the other policies improve on
+}
+
+TEST(CachePolicyTest, ScanDoesNotEvictTheHotSetFrom2Q) {
+    TwoQueueCacheManager<TestImage> cache(8);
+    EXPECT_TRUE(hotSetSurvivesAScan(cache));
+}
+
+TEST(CachePolicyTest, ScanDoesNotEvictTheHotSetFromARC) {
+    ARCCacheManager<TestImage> cache(8);
+    EXPECT_TRUE(hotSetSurvivesAScan(cache));
+}
+
+TEST(CachePolicyTest, ScanDoesNotEvictTheHotSetFromTinyLFU) {
+    TinyLFUCacheManager<TestImage> cache(8);
+    EXPECT_TRUE(hotSetSurvivesAScan(cache));
+}
+
+TEST(CachePolicyTest, ARCAdaptsOnGhostHits) {
+    ARCCacheManager<TestImage> cache(4);
+    for (const char* key : {"a", "a", "b", "b"}) use(cache, key); // Reused: T2 = {b, a}
+    for (const char* key : {"c", "d", "e"}) use(cache, key);      // Full: c leaves T1 for B1
+    EXPECT_EQ(cache.recencyTarget(), 0u);
+    EXPECT_FALSE(cache.isCached("c"));
+
+    use(cache, "c"); // B1 hit: recency would have kept it
+    EXPECT_EQ(cache.recencyTarget(), 1u);
+    EXPECT_TRUE(cache.isCached("c"));
+
+    use(cache, "f"); // T1 is at its target, so a leaves T2 for B2
+    EXPECT_FALSE(cache.isCached("a"));
+    use(cache, "a"); // B2 hit: frequency would have kept it
+    EXPECT_EQ(cache.recencyTarget(), 0u);
+    EXPECT_TRUE(cache.isCached("a"));
+}
+
+TEST(CachePolicyTest, TinyLFURejectsAColdCandidate) {
+    TinyLFUCacheManager<TestImage> cache(16); // Window of 1, main cache of 15
+    std::vector<std::string> warm;
+    for (int i = 0; i < 15; ++i) warm.push_back("k" + std::to_string(i));
+    for (int round = 0; round < 3; ++round)
+        for (const auto& key : warm) use(cache, key);
+    use(cache, "cold");
+    use(cache, "next"); // Pushes cold out of the window: seen once, it loses to the main cache's victim
+    EXPECT_FALSE(cache.isCached("cold"));
+    for (const auto& key : warm) EXPECT_TRUE(cache.isCached(key)) << key;
+
+    for (int i = 0; i < 8; ++i) use(cache, "popular"); // Read often while in the window
+    use(cache, "last");
+    EXPECT_TRUE(cache.isCached("popular"));
+}
+
+} // namespace
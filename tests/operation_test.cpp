@@ -0,0 +1,42 @@
+#include "test_image.hpp"
+#include "pipeline/operation.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using pipeline::Operation;
+
+namespace {
+
+TestImage identity(const TestImage& image) { return image; }
+
+TEST(OperationTest, SignatureKeepsReadableParams) {
+    EXPECT_EQ(Operation<TestImage>::make("gaussianBlur", identity, 5, 1.5).signature(), "gaussianBlur(5,1.5)");
+    EXPECT_EQ(Operation<TestImage>::make("flip", identity).signature(), "flip()");
+}
+
+TEST(OperationTest, FloatsKeepAllSignificantDigits) {
+    auto a = Operation<TestImage>::make("scale", identity, 1.0000001);
+    auto b = Operation<TestImage>::make("scale", identity, 1.0000002);
+    EXPECT_NE(a.params, b.params);
+    EXPECT_EQ(std::stod(a.params), 1.0000001);
+    EXPECT_NE(Operation<TestImage>::make("s", identity, 0.1f).params, Operation<TestImage>::make("s", identity, 0.1000001f).params);
+}
+
+TEST(OperationTest, DelimitersInsideFieldsDoNotCollide) {
+    auto joined = Operation<TestImage>::make("text", identity, std::string("a,b"));
+    auto split = Operation<TestImage>::make("text", identity, std::string("a"), std::string("b"));
+    EXPECT_NE(joined.signature(), split.signature());
+
+    Operation<TestImage> nested{"f", "x);g(y", identity};
+    Operation<TestImage> first{"f", "x", identity};
+    Operation<TestImage> second{"g", "y", identity};
+    EXPECT_NE(nested.signature() + ";", first.signature() + ";" + second.signature() + ";");
+
+    Operation<TestImage> escapedId{"a\\", ")", identity};
+    Operation<TestImage> plainId{"a", "\\)", identity};
+    EXPECT_NE(escapedId.signature(), plainId.signature());
+}
+
+} // namespace
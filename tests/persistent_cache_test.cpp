@@ -0,0 +1,122 @@
+#include "test_image.hpp"
+#include "pipeline/strategy_persistent.hpp"
+#include "pipeline/strategy_lru.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using pipeline::PersistentCacheManager;
+using pipeline::PersistentCacheOptions;
+
+namespace {
+
+/**
+ * @brief Source images and a cache directory, removed when the test ends.
+ */
+class PersistentCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root_ = fs::temp_directory_path() / ("pixlink-persistent-test-" + std::to_string(::getpid()));
+        fs::remove_all(root_);
+        fs::create_directories(root_ / "in");
+        for (const char* key : {"a.img", "b.img", "c.img", "d.img"}) std::ofstream(root_ / "in" / key) << key;
+    }
+
+    void TearDown() override { fs::remove_all(root_); }
+
+    std::unique_ptr<PersistentCacheManager<TestImage>> open(PersistentCacheOptions options = {},
+                                                            std::unique_ptr<pipeline::CacheManager<TestImage>> memory = nullptr) {
+        return std::make_unique<PersistentCacheManager<TestImage>>(std::move(memory), (root_ / "in").string(),
+                                                                   (root_ / "cache").string(), options);
+    }
+
+    size_t rawFiles() const {
+        size_t count = 0;
+        for (const auto& entry : fs::directory_iterator(root_ / "cache")) count += entry.path().extension() == ".raw";
+        return count;
+    }
+
+    fs::path root_;
+};
+
+TEST_F(PersistentCacheTest, ServesImagesFromDiskInTheNextRun) {
+    open()->cacheImage("a.img", TestImage{"pixels of a"});
+    auto cache = open(PersistentCacheOptions{false, false});
+    EXPECT_TRUE(cache->isCached("a.img"));
+    EXPECT_EQ(cache->getCached("a.img"), TestImage{"pixels of a"});
+    EXPECT_EQ(cache->diskHits(), 1u);
+}
+
+TEST_F(PersistentCacheTest, RawFileOfAnotherKeyIsAMiss) {
+    open()->cacheImage("a.img", TestImage{"pixels of a"});
+    open()->cacheImage("b.img", TestImage{"pixels of b"});
+    fs::path a, b;
+    for (const auto& entry : fs::directory_iterator(root_ / "cache")) {
+        if (entry.path().extension() != ".raw") continue;
+        std::ifstream in(entry.path(), std::ios::binary);
+        std::string bytes(std::istreambuf_iterator<char>(in), {});
+        (bytes.find("a.img") != std::string::npos ? a : b) = entry.path();
+    }
+    ASSERT_FALSE(a.empty());
+    ASSERT_FALSE(b.empty());
+    fs::copy_file(b, a, fs::copy_options::overwrite_existing); // As if both keys hashed to one name
+
+    auto cache = open(PersistentCacheOptions{false, false});
+    EXPECT_THROW(cache->getCached("a.img"), std::runtime_error);
+    EXPECT_EQ(cache->getCached("b.img"), TestImage{"pixels of b"});
+}
+
+TEST_F(PersistentCacheTest, DiskUseStaysWithinItsBudget) {
+    PersistentCacheOptions options;
+    options.warmOnStart = false;
+    options.maxDiskBytes = 240; // Three raw files of 60 pixels
+    {
+        auto cache = open(options);
+        for (const char* key : {"a.img", "b.img", "c.img"}) cache->cacheImage(key, TestImage{std::string(60, key[0])});
+        EXPECT_TRUE(cache->isCached("a.img")); // Now more recent than b
+        cache->cacheImage("d.img", TestImage{std::string(60, 'd')});
+        EXPECT_LE(cache->diskBytes(), 240u);
+        EXPECT_EQ(rawFiles(), 3u);
+    }
+    options.maxDiskBytes = 160; // A smaller budget applies to what earlier runs stored
+    auto cache = open(options, std::make_unique<pipeline::LRUCacheManager<TestImage>>(1));
+    EXPECT_LE(cache->diskBytes(), 160u);
+    EXPECT_EQ(rawFiles(), 2u);
+    EXPECT_FALSE(cache->isCached("b.img"));
+    EXPECT_TRUE(cache->isCached("d.img"));
+}
+
+TEST_F(PersistentCacheTest, WarmingStopsWhenTheMemoryTierIsFull) {
+    {
+        auto cache = open();
+        for (const char* key : {"a.img", "b.img", "c.img", "d.img"}) cache->cacheImage(key, TestImage{key});
+    }
+    auto cache = open({}, std::make_unique<pipeline::LRUCacheManager<TestImage>>(2));
+    EXPECT_EQ(cache->diskHits(), 3u); // The third image evicted the first: no more after it
+    EXPECT_EQ(cache->getKeys().size(), 2u);
+}
+
+TEST_F(PersistentCacheTest, AvoidedDecodeIsCreditedOnce) {
+    {
+        auto cache = open();
+        cache->cacheImage("a.img", TestImage{"pixels of a"});
+        cache->noteDecodeCost("a.img", std::chrono::milliseconds(10));
+        // Pipeline's lookup: isCached, then a shallow get. Served from memory.
+        ASSERT_TRUE(cache->isCached("a.img"));
+        cache->getCachedShallow("a.img");
+        EXPECT_EQ(cache->stats().decodeTimeSaved, std::chrono::milliseconds(10));
+    }
+    auto cache = open(PersistentCacheOptions{false, false});
+    ASSERT_TRUE(cache->isCached("a.img")); // Served from disk
+    cache->getCachedShallow("a.img");
+    EXPECT_EQ(cache->stats().decodeTimeSaved, std::chrono::milliseconds(10));
+}
+
+} // namespace
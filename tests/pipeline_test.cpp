@@ -0,0 +1,200 @@
+#include "test_image.hpp"
+#include "pipeline/pipeline.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using Pipeline = pipeline::Pipeline<TestImage>;
+
+namespace {
+
+/**
+ * @brief Input and output folders with a few test images, removed when the test ends.
+ */
+class PipelineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root_ = fs::temp_directory_path() / ("pixlink-pipeline-test-" + std::to_string(::getpid()));
+        fs::remove_all(root_);
+        fs::create_directories(root_ / "in" / "set");
+        write("set/one.img", "1");
+        write("set/two.img", "2");
+        write("set/three.img", "3");
+    }
+
+    void TearDown() override { fs::remove_all(root_); }
+
+    void write(const std::string& key, const std::string& pixels) { std::ofstream(root_ / "in" / key, std::ios::binary) << pixels; }
+
+    std::string read(const std::string& key) const {
+        std::ifstream in(root_ / "out" / key, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    }
+
+    std::string in() const { return (root_ / "in").string(); }
+    std::string out() const { return (root_ / "out").string(); }
+
+    fs::path root_;
+};
+
+TEST_F(PipelineTest, StreamUnloadsOnlyWhatItLoaded) {
+    auto cache = std::make_unique<pipeline::DefaultCacheManager<TestImage>>();
+    auto* cacheView = cache.get();
+    Pipeline p(in(), out(), std::move(cache));
+    p.load("set/one.img").process("set/one.img", [](const TestImage& image) { return TestImage{image.pixels + "!"}; });
+
+    std::map<std::string, std::string> seen;
+    p.stream("set", {".img"}, [&](Pipeline& pl, const std::string& key) {
+        pl.process(key, [&](const TestImage& image) {
+            seen[key] = image.pixels;
+            return TestImage{image.pixels + "?"};
+        });
+    });
+
+    EXPECT_EQ(p.getLastReport().succeeded.size(), 3u);
+    EXPECT_EQ(seen, (std::map<std::string, std::string>{{"set/one.img", "1"}, {"set/three.img", "3"}, {"set/two.img", "2"}}));
+    EXPECT_EQ(p.getAllImageKeys(), std::vector<std::string>{"set/one.img"});
+    EXPECT_EQ(cacheView->getKeys(), std::vector<std::string>{"set/one.img"});
+    EXPECT_EQ(cacheView->getCached("set/one.img"), TestImage{"1"}); // The recipe worked on a copy
+    p.save("set/one.img");
+    EXPECT_EQ(read("set/one.img"), "1!"); // The caller's working image is untouched
+}
+
+/**
+ * @brief The test loader, counting the files it decodes (from any thread).
+ */
+class CountingLoader : public pipeline::DefaultImageLoader<TestImage> {
+public:
+    explicit CountingLoader(std::atomic<int>& decodes) : decodes_(decodes) {}
+
+    TestImage loadFromFile(const std::string& path) override {
+        ++decodes_;
+        return pipeline::DefaultImageLoader<TestImage>::loadFromFile(path);
+    }
+
+private:
+    std::atomic<int>& decodes_;
+};
+
+TEST_F(PipelineTest, StreamDoesNotReadCachedImagesAhead) {
+    std::atomic<int> decodes{0};
+    Pipeline p(in(), out(), nullptr, std::make_unique<CountingLoader>(decodes));
+    p.load("set/one.img");
+    ASSERT_EQ(decodes, 1);
+    p.stream("set", {".img"}, [](Pipeline&, const std::string&) {});
+    EXPECT_EQ(p.getLastReport().succeeded.size(), 3u);
+    EXPECT_EQ(decodes, 3); // Only the two images that were not cached
+}
+
+TEST_F(PipelineTest, StreamLeavesNothingBehind) {
+    Pipeline p(in(), out());
+    p.stream("set", {".img"}, [](Pipeline& pl, const std::string& key) { pl.saveAs(key, "copy"); });
+    EXPECT_EQ(p.getLastReport().succeeded.size(), 3u);
+    EXPECT_TRUE(p.isWorkingMapEmpty());
+    EXPECT_TRUE(p.isCacheMapEmpty());
+    EXPECT_EQ(read("copy/two.img"), "2");
+}
+
+TEST_F(PipelineTest, CopyOntoItselfKeepsTheFile) {
+    std::string path = (root_ / "in" / "set" / "one.img").string();
+    pipeline::copyFile(path, (root_ / "in" / "set" / "." / "one.img").string());
+    std::ifstream file(path, std::ios::binary);
+    EXPECT_EQ(std::string(std::istreambuf_iterator<char>(file), {}), "1");
+}
+
+TEST_F(PipelineTest, PassthroughIntoTheInputFolderKeepsTheInputs) {
+    Pipeline p(in(), in());
+    p.setPassthrough(true).loadDirectory("set", {".img"}).saveAll();
+    EXPECT_EQ(p.getLastReport().succeeded.size(), 3u);
+    EXPECT_TRUE(p.getLastReport().failed.empty());
+    std::ifstream file(root_ / "in" / "set" / "two.img", std::ios::binary);
+    EXPECT_EQ(std::string(std::istreambuf_iterator<char>(file), {}), "2");
+}
+
+TEST_F(PipelineTest, SaveAllReportsLazyImagesThatFailToDecode) {
+    Pipeline p(in(), out());
+    p.setLoadMode(pipeline::LoadMode::Lazy).loadDirectory("set", {".img"});
+    fs::remove(root_ / "in" / "set" / "two.img");
+    p.saveAll();
+    ASSERT_EQ(p.getLastReport().failed.size(), 1u);
+    EXPECT_EQ(p.getLastReport().failed[0].key, "set/two.img");
+    EXPECT_EQ(p.getLastReport().succeeded.size(), 2u);
+    EXPECT_EQ(read("set/three.img"), "3");
+}
+
+/**
+ * @brief A saver written against the original interface: only the throwing saveAll.
+ */
+class LegacySaver : public pipeline::ImageSaver<TestImage> {
+public:
+    void save(const std::string& outputPath, const TestImage& image) override { saved.push_back(outputPath + "=" + image.pixels); }
+
+    void saveAll(const pipeline::ImageMap<TestImage>& images, const std::string& outputDir) override {
+        for (const auto& [key, image] : images) {
+            if (image.pixels == "2") throw std::runtime_error("disk full");
+            save(outputDir + "/" + key, image);
+        }
+    }
+
+    void saveAs(const TestImage&, const std::string&, const std::string&, const std::string&) override {}
+
+    std::vector<std::string> saved;
+};
+
+TEST_F(PipelineTest, SaversWithoutReportsStillWork) {
+    auto saver = std::make_unique<LegacySaver>();
+    Pipeline p(in(), out(), nullptr, nullptr, std::move(saver));
+    p.load("set/one.img").saveAll();
+    EXPECT_EQ(p.getLastReport().succeeded, std::vector<std::string>{"set/one.img"});
+    p.load("set/two.img").saveAll();
+    EXPECT_EQ(p.getLastReport().failed.size(), 2u); // The saver cannot say which image failed
+    EXPECT_EQ(p.getLastReport().failed[0].error, "disk full");
+}
+
+TEST_F(PipelineTest, MemoizedChainsSkipTheOperations) {
+    std::map<std::string, int> runs;
+    auto append = [&](const std::string& id, const std::string& suffix) {
+        return pipeline::Operation<TestImage>::make(id, [&runs, id, suffix](const TestImage& image) {
+            ++runs[id];
+            return TestImage{image.pixels + suffix};
+        }, suffix);
+    };
+    const std::string key = "set/one.img";
+    Pipeline p(in(), out());
+    p.setResultCache(std::make_unique<pipeline::DefaultCacheManager<TestImage>>());
+
+    p.load(key).process(key, append("blur", "b")).process(key, append("sharpen", "s"));
+    EXPECT_EQ(p.getImage(key), TestImage{"1bs"});
+
+    p.reset(key).process(key, append("blur", "b")).process(key, append("sharpen", "s"));
+    EXPECT_EQ(p.getImage(key), TestImage{"1bs"});
+    EXPECT_EQ(runs, (std::map<std::string, int>{{"blur", 1}, {"sharpen", 1}})); // Both steps were cached
+
+    p.reset(key).process(key, append("blur", "b")).process(key, append("sharpen", "S"));
+    EXPECT_EQ(p.getImage(key), TestImage{"1bS"});
+    EXPECT_EQ(runs, (std::map<std::string, int>{{"blur", 1}, {"sharpen", 2}})); // Only the changed step ran
+}
+
+TEST_F(PipelineTest, FilterByInfoDescribesWorkingImagesAsTheyAreNow) {
+    Pipeline p(in(), out());
+    p.load("set/one.img").load("set/two.img");
+    p.process("set/one.img", [](const TestImage& image) { return TestImage{image.pixels + "234"}; }); // Now 4 wide
+    std::vector<std::string> formats;
+    p.filterByInfo([&](const std::string&, const pipeline::ImageInfo& info) {
+        formats.push_back(info.format);
+        return info.width >= 4;
+    });
+    EXPECT_EQ(p.getAllImageKeys(), std::vector<std::string>{"set/one.img"});
+    EXPECT_EQ(formats, (std::vector<std::string>{"", ""})); // ".img" names no known format
+}
+
+} // namespace
@@ -0,0 +1,260 @@
+#include "test_image.hpp"
+#include "pipeline/strategy_remote.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using pipeline::RemoteCacheManager;
+using pipeline::RemoteCacheOptions;
+namespace remote = pipeline::remote;
+
+namespace {
+
+/**
+ * @brief Runs pixlink-cache-server on a private Unix socket for each test.
+ */
+class RemoteCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        address_ = "unix:/tmp/pixlink-test-" + std::to_string(::getpid()) + ".sock";
+        startServer();
+    }
+
+    void TearDown() override {
+        stopServer();
+        ::unlink(address_.substr(5).c_str());
+    }
+
+    void startServer() {
+        server_ = ::fork();
+        ASSERT_GE(server_, 0);
+        if (server_ == 0) {
+            ::execl(PIXLINK_CACHE_SERVER, PIXLINK_CACHE_SERVER, "--listen", address_.c_str(), "--memory-mb", "64", static_cast<char*>(nullptr));
+            ::_exit(127);
+        }
+        // Ready once it accepts connections
+        for (int i = 0; i < 200; ++i) {
+            try {
+                remote::Socket::connect(remote::Endpoint::parse(address_), std::chrono::milliseconds(100));
+                return;
+            } catch (const std::exception&) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        FAIL() << "cache server did not start";
+    }
+
+    void stopServer() {
+        if (server_ <= 0) return;
+        ::kill(server_, SIGTERM);
+        int status = 0;
+        ::waitpid(server_, &status, 0);
+        server_ = -1;
+    }
+
+    bool serverAlive() const { return server_ > 0 && ::waitpid(server_, nullptr, WNOHANG) == 0; }
+
+    RemoteCacheOptions options(size_t hotCapacity = 4) const {
+        RemoteCacheOptions o;
+        o.hotCapacity = hotCapacity;
+        o.maxPendingWrites = 8;
+        o.timeout = std::chrono::milliseconds(2000);
+        return o;
+    }
+
+    /**
+     * @brief Send raw bytes on a fresh connection and return the frames answered.
+     */
+    std::vector<remote::Frame> roundTrip(const std::vector<unsigned char>& bytes, size_t frames) const {
+        remote::Socket s = remote::Socket::connect(remote::Endpoint::parse(address_), std::chrono::milliseconds(1000));
+        EXPECT_TRUE(s.sendAll(bytes.data(), bytes.size(), std::chrono::milliseconds(1000)));
+        std::vector<unsigned char> in;
+        std::vector<remote::Frame> responses;
+        size_t consumed = 0;
+        while (responses.size() < frames) {
+            remote::Frame frame;
+            size_t used = remote::parseFrame(in.data() + consumed, in.size() - consumed, frame);
+            if (used == 0) {
+                if (!s.receiveSome(in, 64 * 1024, std::chrono::milliseconds(1000))) break;
+                continue;
+            }
+            consumed += used;
+            responses.push_back(std::move(frame));
+        }
+        return responses;
+    }
+
+    std::string address_;
+    pid_t server_ = -1;
+};
+
+remote::Frame frame(remote::Op op, uint32_t id, const std::string& key) {
+    remote::Frame f;
+    f.op = op;
+    f.id = id;
+    f.key = key;
+    return f;
+}
+
+TEST_F(RemoteCacheTest, PutThenGetFromAnotherClient) {
+    RemoteCacheManager<TestImage> writer(address_, options());
+    RemoteCacheManager<TestImage> reader(address_, options());
+    writer.cacheImage("a", TestImage{"alpha"});
+    ASSERT_TRUE(writer.flush());
+
+    EXPECT_TRUE(reader.isCached("a"));
+    EXPECT_EQ(reader.getCached("a"), TestImage{"alpha"});
+    EXPECT_EQ(reader.getCachedShallow("a"), TestImage{"alpha"});
+    EXPECT_FALSE(reader.isCached("b"));
+    EXPECT_THROW(reader.getCached("b"), std::runtime_error);
+    EXPECT_EQ(reader.networkErrors(), 0u);
+}
+
+TEST_F(RemoteCacheTest, ProtocolContainsGetAndPipelinedIds) {
+    std::vector<unsigned char> bytes;
+    remote::Frame put = frame(remote::Op::Put, 1, "k");
+    put.kind = remote::PayloadKind::Raw;
+    put.value = {'R', 'A', 'W', '1', 'x'};
+    remote::appendFrame(bytes, put);
+    remote::appendFrame(bytes, frame(remote::Op::Contains, 2, "k"));
+    remote::appendFrame(bytes, frame(remote::Op::Contains, 3, "missing"));
+    remote::appendFrame(bytes, frame(remote::Op::Get, 4, "k"));
+
+    std::vector<remote::Frame> responses = roundTrip(bytes, 4);
+    ASSERT_EQ(responses.size(), 4u);
+    for (uint32_t i = 0; i < 4; ++i) EXPECT_EQ(responses[i].id, i + 1);
+    EXPECT_EQ(responses[0].status, remote::Status::Ok);
+    EXPECT_EQ(responses[1].op, remote::Op::Contains);
+    EXPECT_EQ(responses[1].status, remote::Status::Ok);
+    EXPECT_TRUE(responses[1].value.empty());
+    EXPECT_EQ(responses[2].status, remote::Status::NotFound);
+    EXPECT_EQ(responses[3].kind, remote::PayloadKind::Raw);
+    EXPECT_EQ(responses[3].value, put.value);
+}
+
+TEST_F(RemoteCacheTest, RemoveClearAndKeys) {
+    RemoteCacheManager<TestImage> cache(address_, options());
+    for (const char* key : {"x", "y", "z"}) cache.cacheImage(key, TestImage{key});
+    cache.remove("y");
+    std::vector<std::string> keys = cache.getKeys();
+    std::sort(keys.begin(), keys.end());
+    EXPECT_EQ(keys, (std::vector<std::string>{"x", "z"}));
+
+    RemoteCacheManager<TestImage> other(address_, options());
+    EXPECT_FALSE(other.isCached("y"));
+    EXPECT_TRUE(other.isCached("z"));
+
+    cache.clear();
+    EXPECT_TRUE(cache.getKeys().empty());
+    RemoteCacheManager<TestImage> fresh(address_, options());
+    EXPECT_FALSE(fresh.isCached("x"));
+}
+
+TEST_F(RemoteCacheTest, ServerStatsAndDecodeCost) {
+    RemoteCacheManager<TestImage> writer(address_, options());
+    writer.cacheImage("a", TestImage{"1234"});
+    writer.noteDecodeCost("a", std::chrono::milliseconds(5));
+    writer.cacheImage("b", TestImage{"56"});
+    ASSERT_TRUE(writer.flush());
+
+    RemoteCacheManager<TestImage> reader(address_, options());
+    EXPECT_TRUE(reader.isCached("a"));
+    EXPECT_EQ(reader.stats().decodeTimeSaved, std::chrono::milliseconds(5));
+
+    std::optional<pipeline::CacheStatsSnapshot> server = reader.serverStats();
+    ASSERT_TRUE(server.has_value());
+    EXPECT_EQ(server->insertions, 2u);
+    EXPECT_EQ(server->residentBytes, 2 * 4 + 6u); // "RAW1" prefix on each payload
+    EXPECT_EQ(server->isCachedHits, 1u);
+}
+
+TEST_F(RemoteCacheTest, PipelinedBatchesKeepKeysApart) {
+    RemoteCacheManager<TestImage> writer(address_, options());
+    std::vector<std::string> keys;
+    for (int i = 0; i < 100; ++i) {
+        keys.push_back("img" + std::to_string(i));
+        writer.cacheImage(keys.back(), TestImage{std::string(100 + i, static_cast<char>('a' + i % 26))});
+    }
+    ASSERT_TRUE(writer.flush());
+
+    RemoteCacheManager<TestImage> reader(address_, options());
+    keys.insert(keys.begin() + 50, "absent");
+    std::vector<std::optional<TestImage>> images = reader.getMany(keys);
+    ASSERT_EQ(images.size(), keys.size());
+    EXPECT_FALSE(images[50].has_value());
+    for (size_t j = 0; j < keys.size(); ++j) {
+        if (j == 50) continue;
+        int i = static_cast<int>(j < 50 ? j : j - 1);
+        ASSERT_TRUE(images[j].has_value()) << keys[j];
+        EXPECT_EQ(images[j]->pixels, std::string(100 + i, static_cast<char>('a' + i % 26)));
+    }
+    EXPECT_EQ(reader.networkErrors(), 0u);
+}
+
+TEST_F(RemoteCacheTest, PrefetchServesFromHotSetWithoutServer) {
+    RemoteCacheManager<TestImage> writer(address_, options());
+    writer.cacheImage("p1", TestImage{"one"});
+    writer.cacheImage("p2", TestImage{"two"});
+    ASSERT_TRUE(writer.flush());
+
+    RemoteCacheManager<TestImage> reader(address_, options());
+    reader.prefetch({"p1", "p2"});
+    stopServer();
+    EXPECT_TRUE(reader.isCached("p1"));
+    EXPECT_EQ(reader.getCachedShallow("p2"), TestImage{"two"});
+    EXPECT_EQ(reader.networkErrors(), 0u);
+}
+
+TEST_F(RemoteCacheTest, EncodedPayloadsAreDecodedByReaders) {
+    RemoteCacheOptions encoded = options();
+    encoded.payload = pipeline::RemotePayload::Encoded;
+    RemoteCacheManager<TestImage> writer(address_, encoded);
+    ASSERT_TRUE(writer.acceptsEncoded());
+    writer.cacheEncoded("e", encodeTestImage("jpeg-ish"));
+    ASSERT_TRUE(writer.flush());
+
+    RemoteCacheManager<TestImage> reader(address_, options()); // Raw client reads encoded entries too
+    EXPECT_EQ(reader.getCached("e"), TestImage{"jpeg-ish"});
+}
+
+TEST_F(RemoteCacheTest, ServerDownIsAMissAndCounted) {
+    stopServer();
+    RemoteCacheOptions o = options();
+    o.timeout = std::chrono::milliseconds(200);
+    RemoteCacheManager<TestImage> cache(address_, o);
+    EXPECT_FALSE(cache.isCached("a"));
+    EXPECT_GE(cache.networkErrors(), 1u);
+
+    cache.cacheImage("b", TestImage{"local"});
+    EXPECT_TRUE(cache.isCached("b")); // Still served from the hot set
+    EXPECT_FALSE(cache.flush());
+    EXPECT_GE(cache.networkErrors(), 2u);
+}
+
+TEST_F(RemoteCacheTest, ServerSurvivesGarbageAndOversizedFrames) {
+    std::string http = "GET / HTTP/1.1\r\nHost: cache\r\n\r\n";
+    EXPECT_TRUE(roundTrip(std::vector<unsigned char>(http.begin(), http.end()), 1).empty());
+
+    std::vector<unsigned char> huge(remote::kHeaderSize);
+    remote::putLE(huge.data(), remote::kMagic, 4);
+    huge[4] = static_cast<unsigned char>(remote::Op::Put);
+    remote::putLE(huge.data() + 16, uint64_t(1) << 31, 8); // Over the 64 MiB budget
+    EXPECT_TRUE(roundTrip(huge, 1).empty());
+
+    EXPECT_TRUE(serverAlive());
+    RemoteCacheManager<TestImage> cache(address_, options());
+    cache.cacheImage("ok", TestImage{"fine"});
+    ASSERT_TRUE(cache.flush());
+    RemoteCacheManager<TestImage> reader(address_, options());
+    EXPECT_TRUE(reader.isCached("ok"));
+}
+
+} // namespace
@@ -0,0 +1,41 @@
+#include "test_image.hpp"
+#include "pipeline/strategy_sharded.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using pipeline::ShardedCacheManager;
+
+namespace {
+
+TEST(ShardedCacheTest, CountCapacityIsExact) {
+    for (size_t capacity : {1u, 5u, 16u, 17u, 100u}) {
+        ShardedCacheManager<TestImage> cache(capacity, 16);
+        for (int i = 0; i < 1000; ++i) cache.cacheImage("k" + std::to_string(i), TestImage{"x"});
+        EXPECT_LE(cache.getKeys().size(), capacity) << capacity;
+    }
+}
+
+TEST(ShardedCacheTest, ByteBudgetIsExact) {
+    ShardedCacheManager<TestImage> cache(pipeline::ByteBudget{100}, 16); // 6 or 7 bytes per shard
+    for (int i = 0; i < 1000; ++i) cache.cacheImage("k" + std::to_string(i), TestImage{"x"});
+    EXPECT_EQ(cache.stats().residentBytes, 100u); // Each shard fills its share exactly
+}
+
+TEST(ShardedCacheTest, ImageLargerThanAShareEvictsFromOtherShards) {
+    ShardedCacheManager<TestImage> cache(pipeline::ByteBudget{100}, 4); // 25 bytes per shard
+    for (int i = 0; i < 1000; ++i) cache.cacheImage("k" + std::to_string(i), TestImage{"x"});
+    ASSERT_EQ(cache.stats().residentBytes, 100u);
+
+    cache.cacheImage("large", TestImage{std::string(60, 'l')});
+    EXPECT_TRUE(cache.isCached("large"));
+    EXPECT_EQ(cache.stats().residentBytes, 100u);
+
+    cache.cacheImage("huge", TestImage{std::string(101, 'h')}); // Larger than the whole budget
+    EXPECT_FALSE(cache.isCached("huge"));
+    EXPECT_TRUE(cache.isCached("large"));
+    EXPECT_EQ(cache.stats().residentBytes, 100u);
+}
+
+} // namespace
@@ -0,0 +1,157 @@
+#include "pipeline/shm_store.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using pipeline::SharedImageStore;
+using pipeline::SharedMemoryCacheOptions;
+
+namespace {
+
+constexpr size_t kPage = 4096;
+
+/**
+ * @brief A fresh store of 16 data pages, removed when the test ends.
+ */
+class SharedImageStoreTest : public ::testing::Test {
+protected:
+    SharedImageStoreTest() : name_("/pixlink-test-" + std::to_string(::getpid())) {
+        SharedImageStore::unlink(name_);
+        SharedMemoryCacheOptions options;
+        options.dataBytes = 16 * kPage;
+        options.maxEntries = 32;
+        options.unlinkOnDestroy = true;
+        store_ = std::make_unique<SharedImageStore>(name_, options);
+    }
+
+    bool put(const std::string& key, size_t pages) {
+        SharedImageStore::ImageInfo info{1, static_cast<int32_t>(pages * kPage), 0, pages * kPage};
+        return store_->insert(key, info, [&](unsigned char* data) { std::memset(data, key.back(), info.bytes); });
+    }
+
+    bool holds(const std::string& key) {
+        auto lease = store_->acquire(key);
+        if (!lease) return false;
+        bool intact = lease->data[0] == static_cast<unsigned char>(key.back()) &&
+                      lease->data[lease->info.bytes - 1] == static_cast<unsigned char>(key.back());
+        store_->release(lease->entry);
+        return intact;
+    }
+
+    std::string name_;
+    std::unique_ptr<SharedImageStore> store_;
+};
+
+TEST_F(SharedImageStoreTest, LargeImagesTakeSpaceFromSmallOnes) {
+    for (int i = 0; i < 16; ++i) ASSERT_TRUE(put("small" + std::string(1, static_cast<char>('a' + i)), 1));
+    EXPECT_EQ(store_->usedBytes(), 16 * kPage);
+
+    // No 4-page block was ever carved: the four least recently used small images make room
+    ASSERT_TRUE(put("largeZ", 4));
+    EXPECT_TRUE(holds("largeZ"));
+    EXPECT_EQ(store_->evictions(), 4u);
+    for (int i = 0; i < 16; ++i) {
+        std::string key = "small" + std::string(1, static_cast<char>('a' + i));
+        EXPECT_EQ(store_->contains(key), i >= 4) << key;
+    }
+    EXPECT_EQ(store_->usedBytes(), 16 * kPage);
+}
+
+TEST_F(SharedImageStoreTest, SmallImagesReuseSpaceOfLargeOnes) {
+    for (char c : std::string("ABCD")) ASSERT_TRUE(put(std::string("large") + c, 4));
+    for (char c : std::string("wxyz")) ASSERT_TRUE(put(std::string("small") + c, 1));
+    EXPECT_EQ(store_->evictions(), 1u); // One large image split into four small blocks
+    EXPECT_FALSE(store_->contains("largeA"));
+    for (char c : std::string("BCD")) EXPECT_TRUE(holds(std::string("large") + c));
+    for (char c : std::string("wxyz")) EXPECT_TRUE(holds(std::string("small") + c));
+}
+
+TEST_F(SharedImageStoreTest, FreedSpaceMergesBackIntoLargeBlocks) {
+    for (int i = 0; i < 8; ++i) ASSERT_TRUE(put("s" + std::to_string(i), 1));
+    for (int i = 0; i < 8; ++i) store_->remove("s" + std::to_string(i));
+    EXPECT_EQ(store_->usedBytes(), 0u);
+    for (char c : std::string("1234")) ASSERT_TRUE(put(std::string("big") + c, 4)); // The last two need the freed pages
+    EXPECT_EQ(store_->evictions(), 0u);
+    for (char c : std::string("1234")) EXPECT_TRUE(holds(std::string("big") + c));
+}
+
+TEST_F(SharedImageStoreTest, ReferencedImagesAreNotEvicted) {
+    for (int i = 0; i < 16; ++i) ASSERT_TRUE(put("p" + std::to_string(i), 1));
+    std::vector<SharedImageStore::Lease> leases;
+    for (int i = 0; i < 16; i += 2) leases.push_back(*store_->acquire("p" + std::to_string(i)));
+    EXPECT_FALSE(put("wide", 2)); // Every other page is pinned: no two free pages are adjacent
+    for (int i = 0; i < 16; i += 2) EXPECT_TRUE(holds("p" + std::to_string(i)));
+    for (const auto& lease : leases) store_->release(lease.entry);
+    EXPECT_TRUE(put("wide", 2));
+}
+
+TEST_F(SharedImageStoreTest, ChurnKeepsLookupsWorking) {
+    // Far more distinct keys than index slots; removed slots must not break later probe sequences
+    for (int round = 0; round < 200; ++round) {
+        for (int i = 0; i < 8; ++i) ASSERT_TRUE(put("k" + std::to_string(round) + "-" + std::to_string(i), 1));
+        for (int i = 0; i < 8; i += 2) store_->remove("k" + std::to_string(round) + "-" + std::to_string(i));
+        for (int i = 1; i < 8; i += 2) ASSERT_TRUE(holds("k" + std::to_string(round) + "-" + std::to_string(i)));
+        for (int i = 1; i < 8; i += 2) store_->remove("k" + std::to_string(round) + "-" + std::to_string(i));
+    }
+    EXPECT_TRUE(store_->keys().empty());
+    EXPECT_EQ(store_->usedBytes(), 0u);
+}
+
+TEST_F(SharedImageStoreTest, FullIndexEvictsTheLeastRecentlyUsedImage) {
+    store_.reset();
+    SharedMemoryCacheOptions options;
+    options.dataBytes = 64 * kPage;
+    options.maxEntries = 4;
+    options.unlinkOnDestroy = true;
+    store_ = std::make_unique<SharedImageStore>(name_, options);
+
+    for (int i = 0; i < 4; ++i) ASSERT_TRUE(put("k" + std::to_string(i), 1));
+    ASSERT_TRUE(holds("k0")); // k1 is now the least recently used
+    for (int i = 4; i < 7; ++i) ASSERT_TRUE(put("k" + std::to_string(i), 1));
+    EXPECT_EQ(store_->evictions(), 3u);
+    for (int i = 0; i < 7; ++i) EXPECT_EQ(store_->contains("k" + std::to_string(i)), i == 0 || i >= 4) << i;
+
+    ASSERT_TRUE(put("k7", 1));
+    std::vector<std::string> keys = store_->keys();
+    std::sort(keys.begin(), keys.end());
+    EXPECT_EQ(keys, (std::vector<std::string>{"k4", "k5", "k6", "k7"}));
+}
+
+TEST_F(SharedImageStoreTest, OwnerDyingMidUpdateRebuildsTheAllocator) {
+    for (int i = 0; i < 8; ++i) ASSERT_TRUE(put("k" + std::to_string(i), 1)); // Carved in order: k1 at page 1
+    store_->remove("k0");
+    store_->remove("k2");
+
+    pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) { // Dies holding the lock, the free list pointing into k1 and the byte count lost
+        int fd = ::shm_open(name_.c_str(), O_RDWR, 0600);
+        void* base = ::mmap(nullptr, sizeof(pipeline::shm::Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        auto* header = static_cast<pipeline::shm::Header*>(base);
+        pthread_mutex_lock(&header->mutex);
+        header->dirty = 1;
+        header->freeList[0] = kPage;
+        header->usedBytes = 0;
+        ::_exit(0);
+    }
+    int status = 0;
+    ASSERT_EQ(::waitpid(child, &status, 0), child);
+
+    EXPECT_EQ(store_->usedBytes(), 6 * kPage);
+    for (int i = 0; i < 10; ++i) ASSERT_TRUE(put("n" + std::to_string(i), 1)); // Exactly the free pages
+    EXPECT_EQ(store_->evictions(), 0u);
+    for (int i : {1, 3, 4, 5, 6, 7}) EXPECT_TRUE(holds("k" + std::to_string(i))) << i;
+    for (int i = 0; i < 10; ++i) EXPECT_TRUE(holds("n" + std::to_string(i))) << i;
+    EXPECT_EQ(store_->usedBytes(), 16 * kPage);
+}
+
+} // namespace
@@ -0,0 +1,123 @@
+#include "test_image.hpp"
+#include "pipeline/strategy_spill.hpp"
+#include "pipeline/strategy_lru.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using pipeline::BloomFilter;
+using pipeline::LRUCacheManager;
+using pipeline::SpillCacheManager;
+
+namespace {
+
+/**
+ * @brief A scratch directory, removed when the test ends.
+ */
+class SpillCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        scratch_ = fs::temp_directory_path() / ("pixlink-spill-test-" + std::to_string(::getpid()));
+        fs::remove_all(scratch_);
+    }
+
+    void TearDown() override { fs::remove_all(scratch_); }
+
+    std::unique_ptr<SpillCacheManager<TestImage>> open(size_t memoryImages, size_t diskBytes = 1 << 20) {
+        return std::make_unique<SpillCacheManager<TestImage>>(std::make_unique<LRUCacheManager<TestImage>>(memoryImages),
+                                                              scratch_.string(), pipeline::ByteBudget{diskBytes});
+    }
+
+    size_t files() const {
+        size_t count = 0;
+        for (const auto& entry : fs::recursive_directory_iterator(scratch_)) count += entry.is_regular_file();
+        return count;
+    }
+
+    fs::path scratch_;
+};
+
+TEST_F(SpillCacheTest, EvictedImagesSpillToDiskAndComeBack) {
+    auto cache = open(2);
+    for (const char* key : {"a", "b", "c"}) cache->cacheImage(key, TestImage{std::string(10, key[0])});
+    EXPECT_EQ(files(), 1u); // a left memory
+    EXPECT_EQ(cache->diskBytes(), 14u); // "RAW1" + 10 pixels
+
+    ASSERT_TRUE(cache->isCached("a"));
+    EXPECT_EQ(cache->getCached("a"), TestImage{std::string(10, 'a')});
+    EXPECT_EQ(cache->diskHits(), 1u);
+    EXPECT_EQ(files(), 2u); // a is back in memory and pushed b out; a's file stays for its next eviction
+
+    cache->getCached("c");
+    cache->getCached("a");
+    cache->cacheImage("d", TestImage{"d"}); // Evicts c, not a
+    EXPECT_EQ(files(), 3u);
+    EXPECT_EQ(cache->getCached("b"), TestImage{std::string(10, 'b')});
+    EXPECT_EQ(cache->diskHits(), 2u);
+}
+
+TEST_F(SpillCacheTest, DiskTierStaysWithinItsBudget) {
+    auto cache = open(1, 30); // Two raw files of 14 bytes
+    for (const char* key : {"a", "b", "c", "d", "e"}) cache->cacheImage(key, TestImage{std::string(10, key[0])});
+    EXPECT_EQ(cache->diskBytes(), 28u);
+    EXPECT_EQ(files(), 2u);
+    EXPECT_EQ(cache->stats().evictions, 2u); // a and b left the disk
+    for (const char* key : {"a", "b"}) EXPECT_FALSE(cache->isCached(key)) << key;
+    for (const char* key : {"c", "d", "e"}) EXPECT_TRUE(cache->isCached(key)) << key;
+}
+
+TEST_F(SpillCacheTest, KeysOnDiskSurviveTheFilterRebuild) {
+    auto cache = open(1);
+    for (int i = 0; i <= 100; ++i) cache->cacheImage("k" + std::to_string(i), TestImage{std::to_string(i)});
+    ASSERT_EQ(files(), 100u);
+    for (int i = 0; i < 90; ++i) cache->remove("k" + std::to_string(i)); // Rebuilds once 83 are dropped
+    EXPECT_EQ(files(), 10u);
+    for (int i = 0; i < 90; ++i) EXPECT_FALSE(cache->isCached("k" + std::to_string(i))) << i;
+    for (int i = 90; i < 100; ++i) EXPECT_EQ(cache->getCached("k" + std::to_string(i)), TestImage{std::to_string(i)}) << i;
+}
+
+TEST_F(SpillCacheTest, InstancesShareAScratchDirectory) {
+    auto first = open(1);
+    auto second = open(1);
+    for (const char* key : {"a", "b"}) {
+        first->cacheImage(key, TestImage{std::string("first ") + key});
+        second->cacheImage(key, TestImage{std::string("second ") + key});
+    }
+    EXPECT_EQ(files(), 2u); // One a in each instance's subdirectory
+    EXPECT_EQ(first->getCached("a"), TestImage{"first a"});
+    second.reset();
+    EXPECT_EQ(first->getCached("b"), TestImage{"first b"}); // Spilled again after a came back
+    first.reset();
+    EXPECT_TRUE(fs::is_empty(scratch_));
+}
+
+TEST(BloomFilterTest, AnswersOnlyForAddedKeys) {
+    BloomFilter filter(100);
+    for (int i = 0; i < 100; ++i) filter.add("k" + std::to_string(i));
+    for (int i = 0; i < 100; ++i) EXPECT_TRUE(filter.mayContain("k" + std::to_string(i))) << i;
+    int falsePositives = 0;
+    for (int i = 0; i < 1000; ++i) falsePositives += filter.mayContain("other" + std::to_string(i));
+    EXPECT_LT(falsePositives, 50);
+    filter.clear();
+    EXPECT_FALSE(filter.mayContain("k0"));
+}
+
+TEST_F(SpillCacheTest, AvoidedDecodeIsCreditedOnce) {
+    auto cache = open(4);
+    cache->cacheImage("a", TestImage{"aaaa"});
+    cache->noteDecodeCost("a", std::chrono::milliseconds(10));
+
+    // Pipeline's lookup: isCached, then a shallow get
+    ASSERT_TRUE(cache->isCached("a"));
+    EXPECT_EQ(cache->getCachedShallow("a"), TestImage{"aaaa"});
+    EXPECT_EQ(cache->stats().decodeTimeSaved, std::chrono::milliseconds(10));
+}
+
+} // namespace
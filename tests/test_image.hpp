@@ -0,0 +1,93 @@
+#pragma once
+
+#include "pipeline/strategy.hpp"
+#include "pipeline/image_traits.hpp"
+#include "pipeline/strategy_default.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Minimal image type for tests: its "pixels" are a string.
+ *
+ * Raw payloads are "RAW1" + pixels, encoded payloads "ENC1" + pixels, files hold the pixels.
+ */
+struct TestImage {
+    std::string pixels;
+
+    TestImage clone() const { return *this; }
+    bool operator==(const TestImage& other) const { return pixels == other.pixels; }
+};
+
+namespace pipeline {
+
+template <>
+struct ImageTraits<TestImage> {
+    static size_t byteSize(const TestImage& image) { return image.pixels.size(); }
+
+    static void makeExclusive(TestImage& image) { (void)image; }
+
+    static std::optional<ImageInfo> describe(const TestImage& image) {
+        ImageInfo info;
+        info.width = static_cast<int>(image.pixels.size());
+        info.height = 1;
+        info.channels = 1;
+        return info;
+    }
+
+    static bool writeRaw(const TestImage& image, const std::string& path) {
+        std::vector<unsigned char> bytes;
+        encodeRaw(image, bytes);
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return static_cast<bool>(out.flush());
+    }
+
+    static bool encodeRaw(const TestImage& image, std::vector<unsigned char>& bytes) {
+        bytes.insert(bytes.end(), {'R', 'A', 'W', '1'});
+        bytes.insert(bytes.end(), image.pixels.begin(), image.pixels.end());
+        return true;
+    }
+
+    static std::optional<TestImage> readRaw(const unsigned char* data, size_t size) {
+        if (size < 4 || std::memcmp(data, "RAW1", 4) != 0) return std::nullopt;
+        return TestImage{std::string(reinterpret_cast<const char*>(data) + 4, size - 4)};
+    }
+};
+
+template <>
+inline TestImage DefaultImageLoader<TestImage>::loadFromFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot read " + path);
+    return TestImage{std::string(std::istreambuf_iterator<char>(in), {})};
+}
+
+template <>
+inline TestImage DefaultImageLoader<TestImage>::loadFromBuffer(const std::vector<unsigned char>& bytes) {
+    if (bytes.size() < 4 || std::memcmp(bytes.data(), "ENC1", 4) != 0) throw std::runtime_error("Not an encoded TestImage");
+    return TestImage{std::string(bytes.begin() + 4, bytes.end())};
+}
+
+template <>
+inline void DefaultImageSaver<TestImage>::save(const std::string& outputPath, const TestImage& image) {
+    std::filesystem::path parent = std::filesystem::path(outputPath).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent);
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    out << image.pixels;
+}
+
+} // namespace pipeline
+
+/**
+ * @brief Encoded bytes of a TestImage (see DefaultImageLoader<TestImage>::loadFromBuffer).
+ */
+inline std::vector<unsigned char> encodeTestImage(const std::string& pixels) {
+    std::vector<unsigned char> bytes{'E', 'N', 'C', '1'};
+    bytes.insert(bytes.end(), pixels.begin(), pixels.end());
+    return bytes;
+}